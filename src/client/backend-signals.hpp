@@ -76,6 +76,17 @@ public:
         Send("Log", l.GetGVariantTuple());
     }
 
+    /**
+     *  Changes the session token used as log prefix.  This is used by
+     *  standby processes, which get the token after being started.
+     *
+     * @param token  std::string with the new session token
+     */
+    void SetSessionToken(const std::string& token)
+    {
+        session_token = token;
+    }
+
     /**
      * Sends a FATAL log messages and kills itself
      *
@@ -29,6 +29,7 @@
 
 #include <openvpn/tun/builder/base.hpp>
 
+#include "common/startup-timings.hpp"
 #include "netcfg/proxy-netcfg.hpp"
 #include "backend-signals.hpp"
 
@@ -243,7 +244,31 @@ public:
         // Set all routes in one go to avoid calling the function multiple
         // times
         device->AddNetworks(networks);
-        return device->Establish();
+        if (!startup_timings)
+        {
+            return device->Establish();
+        }
+
+        startup_timings->Begin(StartupPhase::NETCFG_ESTABLISH);
+        int fd = device->Establish();
+        startup_timings->End(StartupPhase::NETCFG_ESTABLISH);
+
+        // The DNS settings are applied by the net.openvpn.v3.netcfg
+        // service as part of the Establish call
+        try
+        {
+            int64_t begin = 0;
+            int64_t end = 0;
+            if (device->GetDNSCommitTiming(begin, end))
+            {
+                startup_timings->Set(StartupPhase::DNS_COMMIT, begin, end);
+            }
+        }
+        catch (const DBusException&)
+        {
+            // Not provided by older net.openvpn.v3.netcfg services
+        }
+        return fd;
     }
 
 
@@ -317,6 +342,7 @@ public:
 
 protected:
     bool disabled_dns_config;
+    StartupTimings *startup_timings = nullptr;
 
 
 private:
@@ -50,6 +50,7 @@
 #include <openvpn/ssl/peerinfo.hpp>
 
 #include "common/core-extensions.hpp"
+#include "common/startup-timings.hpp"
 #include "backend-signals.hpp"
 #include "statistics.hpp"
 
@@ -89,6 +90,7 @@ public:
 
 protected:
     bool disabled_dns_config;
+    StartupTimings *startup_timings = nullptr;
 
 private:
     std::string session_name;
@@ -138,6 +140,19 @@ public:
         disabled_dns_config = val;
     }
 
+
+    /**
+     *  Records the TLS handshake and tun device setup phases of the
+     *  session start
+     *
+     * @param timings  Pointer to the StartupTimings of the session, which
+     *                 must exist as long as this object
+     */
+    void set_startup_timings(StartupTimings *timings)
+    {
+        startup_timings = timings;
+    }
+
     /**
      *  Do we have a dynamic challenge?
      *
@@ -199,6 +214,42 @@ public:
     }
 
 
+    /**
+     *  Retrieves the names of all the connection statistics counters, in
+     *  the order used by GetStatsValues().  The set of counters is fixed
+     *  by the OpenVPN 3 Core library, so the names are only looked up once.
+     *
+     * @return Returns a std::vector<std::string> of all counter names
+     */
+    static const std::vector<std::string>& GetStatsNames()
+    {
+        static const std::vector<std::string> names = []()
+        {
+            std::vector<std::string> ret;
+            const int n = stats_n();
+            for (int i = 0; i < n; ++i)
+            {
+                ret.push_back(stats_name(i));
+            }
+            return ret;
+        }();
+        return names;
+    }
+
+
+    /**
+     *  Retrieves the values of all the connection statistics counters,
+     *  including those which are zero
+     *
+     * @return Returns a std::vector<long long> with the counter values, in
+     *         the same order as GetStatsNames()
+     */
+    std::vector<long long> GetStatsValues()
+    {
+        return stats_bundle();
+    }
+
+
 protected:
 
 
@@ -291,6 +342,10 @@ private:
         else if ("GET_CONFIG" == ev.name)
         {
             signal->LogVerb2("Retrieving configuration from server");
+            if (startup_timings)
+            {
+                startup_timings->End(StartupPhase::TLS_HANDSHAKE);
+            }
         }
         else if ("TUN_SETUP_FAILED" == ev.name
                  && "TUN_IFACE_CREATE" == ev.name
@@ -303,6 +358,13 @@ private:
         }
         else if ("CONNECTING" == ev.name)
         {
+            // The transport is connected; the TLS handshake and the
+            // authentication follow
+            if (startup_timings)
+            {
+                startup_timings->Begin(StartupPhase::TLS_HANDSHAKE);
+            }
+
             // Don't log "Connecting" if we're in reconnect mode
             if (StatusMinor::CONN_RECONNECTING != run_status)
             {
@@ -28,9 +28,21 @@
  *         service is supposed to be automatically started by D-Bus, with
  *         root privileges.  This ensures the client process this service
  *         starts also runs with the appropriate privileges.
+ *
+ *         Optionally, a pool of standby client processes can be kept
+ *         running.  These processes have already connected to the D-Bus
+ *         and are just waiting for a session token, which makes
+ *         StartClient requests complete faster.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <spawn.h>
+#include <sys/wait.h>
 
 #include <openvpn/common/rc.hpp>
 
@@ -38,6 +50,7 @@
 #include "common/cmdargparser.hpp"
 #include "dbus/core.hpp"
 #include "dbus/connection-creds.hpp"
+#include "dbus/namewatch.hpp"
 #include "log/dbus-log.hpp"
 #include "log/proxy-log.hpp"
 #include "common/utils.hpp"
@@ -104,19 +117,27 @@ public:
      *  Constructor initializing the Backend Starter to be registered on
      *  the D-Bus.
      *
-     * @param dbuscon  D-Bus this object is tied to
-     * @param busname  D-Bus bus name this service is registered on
-     * @param objpath  D-Bus object path to this object
+     * @param dbuscon      D-Bus this object is tied to
+     * @param busname      D-Bus bus name this service is registered on
+     * @param objpath      D-Bus object path to this object
+     * @param pool_size    Number of standby client processes to keep
+     *                     running.  0 disables the pool.
+     * @param pool_expiry  Seconds a standby client process waits for a
+     *                     session before it exits
      */
     BackendStarterObject(GDBusConnection *dbuscon, const std::string busname,
                          const std::string objpath,
                          const std::vector<std::string> client_args,
                          unsigned int log_level,
-                         bool signal_broadcast)
+                         bool signal_broadcast,
+                         unsigned int pool_size,
+                         unsigned int pool_expiry)
         : DBusObject(objpath),
           BackendStarterSignals(dbuscon, objpath, log_level),
           dbuscon(dbuscon),
-          client_args(client_args)
+          client_args(client_args),
+          pool_size(pool_size),
+          pool_expiry(pool_expiry)
     {
         if (!signal_broadcast)
         {
@@ -131,6 +152,9 @@ public:
                           << "          <arg type='s' name='token' direction='in'/>"
                           << "          <arg type='u' name='pid' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='RegisterStandby'>"
+                          << "          <arg type='b' name='accepted' direction='out'/>"
+                          << "        </method>"
                           << "        <property type='s' name='version' access='read'/>"
                           << GetLogIntrospection()
                           << "    </interface>"
@@ -143,10 +167,45 @@ public:
     ~BackendStarterObject()
     {
         LogInfo("Shutting down");
+        for (const auto& sb : pool)
+        {
+            shutdown_standby(sb.busname);
+        }
+        for (const auto& child : children)
+        {
+            g_source_remove(child.second);
+        }
         RemoveObject(dbuscon);
     }
 
 
+    /**
+     *  Starts the standby client processes, if the pool is enabled.
+     *  This must be called once the object is registered on the D-Bus.
+     */
+    void FillPool()
+    {
+        // Launches which did not result in a RegisterStandby call
+        // in time are considered failed
+        auto now = std::chrono::steady_clock::now();
+        while (!standby_starting.empty()
+               && now - standby_starting.front() > std::chrono::milliseconds(OpenVPN3DBus_timeout_backends))
+        {
+            standby_starting.pop_front();
+        }
+
+        while (pool.size() + standby_starting.size() < pool_size)
+        {
+            if (-1 == start_backend_process({"--standby-expiry",
+                                             std::to_string(pool_expiry)}))
+            {
+                break;
+            }
+            standby_starting.push_back(now);
+        }
+    }
+
+
     /**
      *  Callback method called each time a method in the Backend Starter
      *  service is called over the D-Bus.
@@ -175,9 +234,26 @@ public:
 
             // Retrieve the configuration path for the tunnel
             // from the request
-            gchar *token = nullptr;
-            g_variant_get (params, "(s)", &token);
-            pid_t backend_pid = start_backend_process(token);
+            gchar *token_c = nullptr;
+            g_variant_get (params, "(s)", &token_c);
+            std::string token(token_c);
+            g_free(token_c);
+
+            // Hand over the most recently started standby process, if
+            // any, and only start a new process if none is usable
+            pid_t backend_pid = -1;
+            while (-1 == backend_pid && !pool.empty())
+            {
+                backend_pid = assign_standby(pool.back().busname,
+                                             pool.back().pid, token);
+                remove_standby(pool.back().busname);
+            }
+            if (-1 == backend_pid)
+            {
+                backend_pid = start_backend_process({token});
+            }
+            FillPool();
+
             if (-1 == backend_pid)
             {
                 GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.backend",
@@ -188,6 +264,32 @@ public:
             }
             g_dbus_method_invocation_return_value(invoc, g_variant_new("(u)", backend_pid));
         }
+        else if ("RegisterStandby" == method_name)
+        {
+            // Called by a client process started by FillPool() once it
+            // is ready to be handed over to a session
+            IdleCheck_UpdateTimestamp();
+            DBusConnectionCreds creds(conn);
+            if (creds.GetUID(sender) != getuid())
+            {
+                GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.acl.denied",
+                                                              "Access denied");
+                g_dbus_method_invocation_return_gerror(invoc, err);
+                g_error_free(err);
+                return;
+            }
+            if (!standby_starting.empty())
+            {
+                standby_starting.pop_front();
+            }
+
+            bool accepted = pool.size() < pool_size;
+            if (accepted)
+            {
+                add_standby(sender, creds.GetPID(sender));
+            }
+            g_dbus_method_invocation_return_value(invoc, g_variant_new("(b)", accepted));
+        }
     };
 
 
@@ -266,84 +368,218 @@ public:
 
 
 private:
+    /**
+     *  A client process waiting in the pool for a session token
+     */
+    struct StandbyBackend
+    {
+        std::string busname;    ///< Unique bus name of the client process
+        pid_t pid;
+        std::unique_ptr<DBusNameWatch> watch;
+    };
+
     GDBusConnection *dbuscon;
     const std::vector<std::string> client_args;
+    const unsigned int pool_size;
+    const unsigned int pool_expiry;
+    std::deque<StandbyBackend> pool;
+    std::deque<std::chrono::steady_clock::time_point> standby_starting;
+    std::map<pid_t, guint> children;  ///< Child watch source IDs, per pid
+
 
     /**
-     * Forks out a child thread which starts the openvpn3-service-client
-     * process with the provided backend start token.
+     *  Adds a registered standby client process to the pool.  The
+     *  process is removed again if it exits on its own, which it does
+     *  when no session needed it before the pool expiry time.
      *
-     * @param token  String containing the start token identifying the session
-     *               object this process is tied to.
-     * @return Returns the process ID (pid) of the child process.
+     * @param busname  Unique bus name of the client process
+     * @param pid      Process ID of the client process
      */
-    pid_t start_backend_process(char * token)
+    void add_standby(const std::string& busname, pid_t pid)
+    {
+        StandbyBackend sb;
+        sb.busname = busname;
+        sb.pid = pid;
+        sb.watch.reset(new DBusNameWatch(dbuscon, busname, nullptr,
+                                         [this, busname]()
+                                         {
+                                             remove_standby(busname);
+                                         }));
+        pool.push_back(std::move(sb));
+
+        // Don't exit on idle while the pool is in use
+        IdleCheck_RefInc();
+        LogVerb2("Standby client process added to the pool, pid "
+                 + std::to_string(pid));
+    }
+
+
+    /**
+     *  Removes a client process from the pool, if present
+     *
+     * @param busname  Unique bus name of the client process
+     */
+    void remove_standby(const std::string& busname)
     {
-        pid_t backend_pid = fork();
-        if (0 == backend_pid)
+        for (auto it = pool.begin(); it != pool.end(); ++it)
         {
-            //  Child process
-            //
-            //  In this process scope, we do not have any access
-            //  to the D-Bus connection.  So we avoid as much logging
-            //  as possible here - and only critical things are sent
-            //  to stdout, which will be picked up by other logs on the
-            //  system
-            //
-            char *args[client_args.size()+2];
-            unsigned int i = 0;
-
-            for (const auto& arg : client_args)
+            if (it->busname == busname)
             {
-                args[i++] = (char *) strdup(arg.c_str());
+                pool.erase(it);
+                IdleCheck_RefDec();
+                IdleCheck_UpdateTimestamp();
+                return;
             }
-            args[i++] = token;
-            args[i++] = nullptr;
+        }
+    }
 
-#ifdef OPENVPN_DEBUG
-            std::cout << "[openvpn3-service-backend] Command line to be started: ";
-            for (unsigned int j = 0; j < i; j++)
-            {
-                std::cout << args[j] << " ";
-            }
-            std::cout << std::endl << std::endl;
+
+    /**
+     *  Hands over a standby client process to a session.  The client
+     *  process registers with the session manager using the token, just
+     *  like a newly started process.
+     *
+     * @param busname  Unique bus name of the client process
+     * @param pid      Process ID of the client process
+     * @param token    Backend start token of the session
+     *
+     * @return Returns the process ID of the client process, or -1 if it
+     *         could not be handed over
+     */
+    pid_t assign_standby(const std::string& busname, pid_t pid,
+                         const std::string& token)
+    {
+        try
+        {
+            DBusProxy prx(dbuscon, busname, OpenVPN3DBus_interf_backends,
+                          OpenVPN3DBus_rootp_backends_session);
+            prx.SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
+            prx.SetGDBusCallTimeout(OpenVPN3DBus_timeout_backends);
+            GVariant *res = prx.Call("AssignSessionToken",
+                                     g_variant_new("(s)", token.c_str()));
+            g_variant_unref(res);
+            LogVerb2("Session " + token + " assigned to standby client "
+                     "process, pid " + std::to_string(pid));
+            return pid;
+        }
+        catch (const DBusException& excp)
+        {
+            LogWarn("Could not use standby client process, pid "
+                    + std::to_string(pid) + ": " + excp.what());
+            return -1;
+        }
+    }
+
+
+    /**
+     *  Tells a standby client process to exit
+     *
+     * @param busname  Unique bus name of the client process
+     */
+    void shutdown_standby(const std::string& busname)
+    {
+        try
+        {
+            DBusProxy prx(dbuscon, busname, OpenVPN3DBus_interf_backends,
+                          OpenVPN3DBus_rootp_backends_session);
+            prx.SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
+            prx.Call("ForceShutdown", true);
+        }
+        catch (const DBusException&)
+        {
+            // The process will exit when the pool expiry time is reached
+        }
+    }
+
+
+    /**
+     *  Starts an openvpn3-service-client process.  The process is not
+     *  waited for; it is reaped by a GLib child watch when it exits.
+     *
+     * @param extra_args  Arguments added to the client command line; either
+     *                    the start token identifying the session object
+     *                    this process is tied to or the standby options.
+     * @return Returns the process ID (pid) of the client process, or -1
+     *         if it could not be started.
+     */
+    pid_t start_backend_process(const std::vector<std::string>& extra_args)
+    {
+        std::vector<std::string> cmdline(client_args);
+        cmdline.insert(cmdline.end(), extra_args.begin(), extra_args.end());
+
+        std::vector<char *> args;
+        for (auto& arg : cmdline)
+        {
+            args.push_back(&arg[0]);
+        }
+        args.push_back(nullptr);
+        char *envp[] = {nullptr};
+
+        // The client process is started in its own session, which
+        // previously required forking twice
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+#ifdef POSIX_SPAWN_SETSID
+        if (cmdline.end() == std::find(cmdline.begin(), cmdline.end(),
+                                       "--no-setsid"))
+        {
+            posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+        }
 #endif
 
-            execve(args[0], args, NULL);
+        pid_t backend_pid = -1;
+        int ret = posix_spawn(&backend_pid, args[0], nullptr, &attr,
+                              args.data(), envp);
+        posix_spawnattr_destroy(&attr);
 
-            // If execve() succeedes, the line below will not be executed
-            // at all.  So if we come here, there must be an error.
-            std::cerr << "** Error starting " << args[0] << ": "
-                      << strerror(errno) << std::endl;
+        std::stringstream extra;
+        for (auto const& c : extra_args)
+        {
+            extra << (extra.tellp() > 0 ? " " : "") << c;
         }
-        else if( backend_pid > 0)
+        if (0 != ret)
         {
-            // Parent
-            std::stringstream cmdline;
-            cmdline << "Command line used: ";
-            for (auto const& c : client_args)
-            {
-                cmdline << c << " ";
-            }
-            cmdline << token;
-            LogVerb2(cmdline.str());
+            LogError("Child process (" + extra.str() + ") failed to start: "
+                     + std::string(strerror(ret)));
+            return -1;
+        }
 
-            // Wait for the child process to exit, as the client process will fork again
-            int rc = -1;
-            int w = waitpid(backend_pid, &rc, 0);
-            if (-1 == w)
-            {
-                std::stringstream msg;
-                msg << "Child process ("  << token
-                    << ") - pid " << backend_pid
-                    << " failed to start as expected (exit code: "
-                    << std::to_string(rc) << ")";
-                LogError(msg.str());
-                return -1;
-            }
-            return backend_pid;
+        std::stringstream cmd;
+        cmd << "Command line used: ";
+        for (auto const& c : client_args)
+        {
+            cmd << c << " ";
+        }
+        cmd << extra.str();
+        LogVerb2(cmd.str());
+
+        children[backend_pid] = g_child_watch_add(backend_pid,
+                                                  child_exited, this);
+        return backend_pid;
+    }
+
+
+    /**
+     *  Called when a started client process has exited
+     */
+    static void child_exited(GPid pid, gint status, gpointer user_data)
+    {
+        BackendStarterObject *self = static_cast<BackendStarterObject *>(user_data);
+        self->children.erase(pid);
+        g_spawn_close_pid(pid);
+
+        if (WIFEXITED(status) && 0 != WEXITSTATUS(status))
+        {
+            self->LogVerb1("Client process, pid " + std::to_string(pid)
+                           + ", exited with exit code "
+                           + std::to_string(WEXITSTATUS(status)));
+        }
+        else if (WIFSIGNALED(status))
+        {
+            self->LogVerb1("Client process, pid " + std::to_string(pid)
+                           + ", was terminated by signal "
+                           + std::to_string(WTERMSIG(status)));
         }
-        throw std::runtime_error("Failed to fork() backend client process");
     }
 };
 
@@ -364,7 +600,9 @@ public:
     BackendStarterDBus(GDBusConnection *conn,
                        const std::vector<std::string> cliargs,
                        unsigned int log_level,
-                       bool signal_broadcast)
+                       bool signal_broadcast,
+                       unsigned int pool_size,
+                       unsigned int pool_expiry)
         : DBus(conn,
                OpenVPN3DBus_name_backends,
                OpenVPN3DBus_rootp_backends,
@@ -373,7 +611,9 @@ public:
           log_level(log_level),
           signal_broadcast(signal_broadcast),
           procsig(nullptr),
-          client_args(cliargs)
+          client_args(cliargs),
+          pool_size(pool_size),
+          pool_expiry(pool_expiry)
     {
         procsig.reset(new ProcessSignalProducer(conn,
                                                 OpenVPN3DBus_interf_backends,
@@ -395,7 +635,8 @@ public:
     {
         mainobj.reset(new BackendStarterObject(GetConnection(), GetBusName(),
                                                GetRootPath(), client_args,
-                                               log_level, signal_broadcast));
+                                               log_level, signal_broadcast,
+                                               pool_size, pool_expiry));
         mainobj->RegisterObject(GetConnection());
 
         procsig->ProcessChange(StatusMinor::PROC_STARTED);
@@ -411,14 +652,15 @@ public:
      *  This is called each time the well-known bus name is successfully
      *  acquired on the D-Bus.
      *
-     *  This is not used, as the preparations already happens in
-     *  callback_bus_acquired()
+     *  The standby client processes register using the well-known bus
+     *  name, so the pool is filled from here.
      *
      * @param conn     Connection where this event happened
      * @param busname  A string of the acquired bus name
      */
     void callback_name_acquired(GDBusConnection *conn, std::string busname)
     {
+        mainobj->FillPool();
     };
 
 
@@ -443,6 +685,8 @@ private:
     bool signal_broadcast = true;
     ProcessSignalProducer::Ptr procsig;
     std::vector<std::string> client_args;
+    unsigned int pool_size = 0;
+    unsigned int pool_expiry = 0;
 };
 
 
@@ -473,10 +717,6 @@ int backend_starter(ParsedArgs args)
 
     client_args.push_back(std::string(LIBEXEC_PATH) + "/openvpn3-service-client");
 #ifdef OPENVPN_DEBUG
-    if (args.Present("client-no-fork"))
-    {
-        client_args.push_back("--no-fork");
-    }
     if (args.Present("client-no-setsid"))
     {
         client_args.push_back("--no-setsid");
@@ -511,6 +751,22 @@ int backend_starter(ParsedArgs args)
         log_level = std::atoi(args.GetValue("log-level", 0).c_str());
     }
 
+    unsigned int pool_size = 0;
+    if (args.Present("pool-size"))
+    {
+        pool_size = std::atoi(args.GetValue("pool-size", 0).c_str());
+    }
+
+    unsigned int pool_expiry = 300;
+    if (args.Present("pool-idle-expiry"))
+    {
+        pool_expiry = std::atoi(args.GetValue("pool-idle-expiry", 0).c_str());
+    }
+    if (1 > pool_expiry)
+    {
+        pool_expiry = 1;
+    }
+
     unsigned int idle_wait_sec = 3;
     if (args.Present("idle-exit"))
     {
@@ -529,7 +785,8 @@ int backend_starter(ParsedArgs args)
     }
 
     BackendStarterDBus backstart(dbus.GetConnection(), client_args,
-                                 log_level, signal_broadcast);
+                                 log_level, signal_broadcast,
+                                 pool_size, pool_expiry);
 
     IdleCheck::Ptr idle_exit;
     if (idle_wait_sec > 0)
@@ -585,13 +842,17 @@ int main(int argc, char **argv)
     cmd.AddOption("idle-exit", "SECONDS", true,
                   "How long to wait before exiting if being idle. "
                   "0 disables it (Default: 10 seconds)");
+    cmd.AddOption("pool-size", "NUM", true,
+                  "Number of standby openvpn3-service-client processes to "
+                  "keep ready for new sessions (Default: 0, disabled)");
+    cmd.AddOption("pool-idle-expiry", "SECONDS", true,
+                  "How long an unused standby openvpn3-service-client "
+                  "process is kept (Default: 300 seconds)");
 #ifdef OPENVPN_DEBUG
     cmd.AddOption("run-via", 0, "DEBUG_PROGAM", true,
                   "Debug option: Run openvpn3-service-client via provided executable (full path required)");
     cmd.AddOption("debugger-arg", 0, "ARG", true,
                   "Debug option: Argument to pass to the DEBUG_PROGAM");
-    cmd.AddOption("client-no-fork", 0,
-                  "Debug option: Adds the --no-fork argument to openvpn3-service-client");
     cmd.AddOption("client-no-setsid", 0,
                   "Debug option: Adds the --no-setsid argument to openvpn3-service-client");
 #endif
@@ -41,6 +41,7 @@
 #include "dbus/connection-creds.hpp"
 #include "dbus/path.hpp"
 #include "common/requiresqueue.hpp"
+#include "common/startup-timings.hpp"
 #include "common/utils.hpp"
 #include "common/cmdargparser.hpp"
 #include "configmgr/proxy-configmgr.hpp"
@@ -49,6 +50,9 @@
 #include "log/logwriter.hpp"
 #include "log/proxy-log.hpp"
 #include "backend-signals.hpp"
+#include "statistics-delta.hpp"
+#include "statistics-history.hpp"
+#include "statistics-segment.hpp"
 
 
 #define USE_TUN_BUILDER
@@ -79,7 +83,9 @@ public:
      * @param session_token  String based token which is used to register
      *                       itself with the session manager.  This token
      *                       is provided on the command line when starting
-     *                       this openvpn3-service-client process.
+     *                       this openvpn3-service-client process.  It is
+     *                       empty when started as a standby process, which
+     *                       gets the token through AssignSessionToken.
      */
     BackendClientObject(GDBusConnection *conn, std::string bus_name,
                          std::string objpath, std::string session_token,
@@ -90,6 +96,7 @@ public:
           mainloop(nullptr),
           signal(conn, LogGroup::CLIENT, session_token, logwr),
           signal_broadcast(false),
+          bus_name(bus_name),
           session_token(session_token),
           registered(false),
           paused(false),
@@ -106,6 +113,9 @@ public:
         std::stringstream introspection_xml;
         introspection_xml << "<node name='" << objpath << "'>"
                           << "    <interface name='" << OpenVPN3DBus_interf_backends << "'>"
+                          << "        <method name='SetCallBudget'>"
+                          << "            <arg type='u' name='budget_ms' direction='in'/>"
+                          << "        </method>"
                           << "        <method name='RegistrationConfirmation'>"
                           << "            <arg type='s' name='token' direction='in'/>"
                           << "            <arg type='o' name='config_path' direction='in'/>"
@@ -114,6 +124,9 @@ public:
                           << "        <method name='Ping'>"
                           << "            <arg type='b' name='alive' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='AssignSessionToken'>"
+                          << "            <arg type='s' name='token' direction='in'/>"
+                          << "        </method>"
                           << "        <method name='Ready'/>"
                           << "        <method name='Connect'/>"
                           << "        <method name='Pause'>"
@@ -123,6 +136,20 @@ public:
                           << "        <method name='Restart'/>"
                           << "        <method name='Disconnect'/>"
                           << "        <method name='ForceShutdown'/>"
+                          << "        <method name='SetStatisticsInterval'>"
+                          << "            <arg type='u' name='interval' direction='in'/>"
+                          << "        </method>"
+                          << "        <method name='FetchStatisticsHistory'>"
+                          << "            <arg type='u' name='max_samples' direction='in'/>"
+                          << "            <arg type='as' name='keys' direction='out'/>"
+                          << "            <arg type='a(xax)' name='samples' direction='out'/>"
+                          << "            <arg type='a(sddd)' name='rates' direction='out'/>"
+                          << "        </method>"
+                          << "        <method name='FetchStatisticsSegment'/>"
+                          /* FetchStatisticsSegment returns the segment as a
+                           * unix_fd, passed as auxiliary data like
+                           * FetchFD in the configuration manager
+                           */
                           << RequiresQueue::IntrospectionMethods("UserInputQueueGetTypeGroup",
                                                                  "UserInputQueueFetch",
                                                                  "UserInputQueueCheck",
@@ -140,31 +167,44 @@ public:
                           << "            <arg type='s' name='busname' direction='out'/>"
                           << "            <arg type='s' name='token' direction='out'/>"
                           << "        </signal>"
+                          << "        <signal name='StatisticsUpdate'>"
+                          << "            <arg type='x' name='timestamp' direction='out'/>"
+                          << "            <arg type='u' name='sequence' direction='out'/>"
+                          << "            <arg type='as' name='keys' direction='out'/>"
+                          << "            <arg type='a(ux)' name='deltas' direction='out'/>"
+                          << "        </signal>"
                           << "        <property type='a{sx}' name='statistics' access='read'/>"
                           << "        <property type='(uus)' name='status' access='read'/>"
                           << "        <property type='o' name='device_path' access='read'/>"
                           << "        <property type='s' name='device_name' access='read'/>"
+                          << "        <property type='a(sxx)' name='startup_timings' access='read'/>"
                           <<  "    </interface>"
                           <<  "</node>";
         ParseIntrospectionXML(introspection_xml);
 
-        // Tell the session manager we are ready.  This
-        // request will also carry the correct object path
-        // in the response automatically, but the well-known
-        // bus name needs to be sent back.
-        signal.LogVerb1("Initializing VPN client session, token "
-                        + session_token);
-        signal.Send(OpenVPN3DBus_name_sessions,
-                    OpenVPN3DBus_interf_backends,
-                    "RegistrationRequest",
-                    g_variant_new("(ssi)",
-                                  bus_name.c_str(), session_token.c_str(),
-                                  getpid()));
+        history_timer = g_timeout_add_seconds(1, statistics_sample, this);
+
+        if (!session_token.empty())
+        {
+            send_registration_request();
+        }
     }
 
 
     ~BackendClientObject()
     {
+        if (0 < standby_timer)
+        {
+            g_source_remove(standby_timer);
+        }
+        if (0 < stats_timer)
+        {
+            g_source_remove(stats_timer);
+        }
+        if (0 < history_timer)
+        {
+            g_source_remove(history_timer);
+        }
         CoreVPNClient::uninit_process();
     }
 
@@ -196,6 +236,41 @@ public:
     }
 
 
+    /**
+     *  Offers this process to the openvpn3-service-backendstart pool of
+     *  standby processes.  This is used when no session token was given
+     *  on the command line.  Once accepted, this process waits for an
+     *  AssignSessionToken call and exits if that does not happen within
+     *  the expiry time.
+     *
+     * @param expiry  Seconds to wait for a session
+     *
+     * @return Returns true if the backend starter accepted this process
+     *
+     * @throws DBusException if the backend starter could not be reached
+     */
+    bool RegisterStandby(unsigned int expiry)
+    {
+        DBusProxy starter(dbusconn, OpenVPN3DBus_name_backends,
+                          OpenVPN3DBus_interf_backends,
+                          OpenVPN3DBus_rootp_backends);
+        starter.SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
+        starter.SetGDBusCallTimeout(OpenVPN3DBus_timeout_backends);
+        GVariant *res = starter.Call("RegisterStandby");
+        gboolean accepted = false;
+        g_variant_get(res, "(b)", &accepted);
+        g_variant_unref(res);
+
+        if (accepted)
+        {
+            standby = true;
+            standby_timer = g_timeout_add_seconds(expiry, standby_expired, this);
+            signal.LogVerb2("Waiting for a session as a standby process");
+        }
+        return accepted;
+    }
+
+
     /**
      *  Sets the flag disabling the ProtectSocket method.  If this is
      *  set to true, any calls to socket_protect ends up as a NOOP with
@@ -236,10 +311,34 @@ public:
         // Ensure D-Bus method calls are serialized
         std::lock_guard<std::mutex> lg(guard);
 
+        if ("SetCallBudget" == method_name)
+        {
+            // The budget applies to the next request from this caller
+            guint budget_ms = 0;
+            g_variant_get(params, "(u)", &budget_ms);
+            DBusCallBudgets::Set(sender, budget_ms);
+            g_dbus_method_invocation_return_value(invoc, NULL);
+            return;
+        }
+
+        // Calls to the configuration manager and net.openvpn.v3.netcfg
+        // done while handling this request must complete before the
+        // session manager gives up waiting for us
+        DBusCallDeadlineScope deadline(sender, OpenVPN3DBus_timeout_backends
+                                                - OpenVPN3DBus_timeout_margin);
+
         try
         {
-            // Only the session manager is allowed to call methods
-            validate_sender(sender);
+            // Only the session manager is allowed to call methods,
+            // except for the backend starter handing over a standby
+            // process to a session or stopping it
+            if (!standby
+                || GetUniqueBusID(OpenVPN3DBus_name_backends) != sender
+                || ("AssignSessionToken" != method_name
+                    && "ForceShutdown" != method_name))
+            {
+                validate_sender(sender);
+            }
 
             // Ensure a vpnclient object is present only when we are
             // expected to be in an active connection.
@@ -259,7 +358,32 @@ public:
                 }
             }
 
-            if ("RegistrationConfirmation" == method_name)
+            if ("AssignSessionToken" == method_name)
+            {
+                // Called by openvpn3-service-backendstart when a session
+                // is started while this process is on standby.  From
+                // here on, the registration is done just as if the
+                // token had been given on the command line.
+                if (!standby)
+                {
+                    THROW_DBUSEXCEPTION("BackendServiceObject",
+                                        "Backend service is not on standby");
+                }
+                gchar *token = nullptr;
+                g_variant_get(params, "(s)", &token);
+                session_token = std::string(token);
+                g_free(token);
+
+                standby = false;
+                if (0 < standby_timer)
+                {
+                    g_source_remove(standby_timer);
+                    standby_timer = 0;
+                }
+                signal.SetSessionToken(session_token);
+                send_registration_request();
+            }
+            else if ("RegistrationConfirmation" == method_name)
             {
                 // This is called by the session manager only, as an
                 // acknowledgement from the session manager that it has
@@ -306,14 +430,28 @@ public:
                     // Fetch the configuration from the config-manager.
                     // Since the configuration may be set up for single-use
                     // only, we must keep this config as long as we're running
+                    startup_timings.Begin(StartupPhase::CONFIG_FETCH);
                     std::string config_name = fetch_configuration();
+                    startup_timings.End(StartupPhase::CONFIG_FETCH);
                     g_dbus_method_invocation_return_value(invoc,
                                                           g_variant_new("(s)", config_name.c_str()));
 
                     // Sets initial state, which also allows us to early
                     // report back back if more data is required to be
-                    // sent by the front-end interface.
+                    // sent by the front-end interface.  This also
+                    // validates the profile, so errors are reported before
+                    // the connection is started.
+                    startup_timings.Begin(StartupPhase::PROFILE_EVALUATION);
                     initialize_client();
+                    startup_timings.End(StartupPhase::PROFILE_EVALUATION);
+
+                    // The credential queue phase lasts until the front-end
+                    // has provided all the required user input
+                    startup_timings.Begin(StartupPhase::CREDENTIAL_QUEUE);
+                    if (userinputq.QueueAllDone())
+                    {
+                        startup_timings.End(StartupPhase::CREDENTIAL_QUEUE);
+                    }
                 }
                 else
                 {
@@ -359,8 +497,16 @@ public:
                 // This re-initializes the client object.  If we have already
                 // tried to connectbut got an AUTH_FAILED, either due to wrong
                 // credentials or a dynamic challenge from the server, we
-                // need to re-establish the vpnclient object.
-                initialize_client();
+                // need to re-establish the vpnclient object.  The same is
+                // needed when the private key passphrase has been provided
+                // after the profile was evaluated.  Otherwise the object
+                // evaluated at registration is used as-is.
+                if (client_used || !vpnclient
+                    || userinputq.QueueCount(ClientAttentionType::CREDENTIALS,
+                                             ClientAttentionGroup::PK_PASSPHRASE) > 0)
+                {
+                    initialize_client();
+                }
 
                 if (!userinputq.QueueAllDone())
                 {
@@ -378,17 +524,23 @@ public:
                 // Disconnect from the server.  This will also shutdown this
                 // process.
 
-                if (!registered || !vpnclient)
+                if (!registered)
                 {
                     THROW_DBUSEXCEPTION("BackendServiceObject", "Backend service is not initialized");
                 }
 
                 signal.LogInfo("Stopping connection");
                 signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_DISCONNECTING);
-                vpnclient->stop();
-                if (client_thread)
+
+                // The VPN client object does not exist if the profile
+                // could not be evaluated
+                if (vpnclient)
                 {
-                    client_thread->join();
+                    vpnclient->stop();
+                    if (client_thread)
+                    {
+                        client_thread->join();
+                    }
                 }
                 signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_DONE);
 
@@ -463,6 +615,10 @@ public:
                     return;
                 }
                 userinputq.UpdateEntry(invoc, params);
+                if (userinputq.QueueAllDone())
+                {
+                    startup_timings.End(StartupPhase::CREDENTIAL_QUEUE);
+                }
             }
             else if ("Pause" == method_name)
             {
@@ -532,6 +688,41 @@ public:
                 signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_RECONNECTING);
                 vpnclient->reconnect(0);
             }
+            else if ("SetStatisticsInterval" == method_name)
+            {
+                // Enables or disables the periodic StatisticsUpdate
+                // signal.  This is only enabled by the session manager
+                // while someone has subscribed to the updates.  Each call
+                // results in a key frame being sent first, so new
+                // subscribers can decode the following delta frames.
+                guint32 interval = 0;
+                g_variant_get(params, "(u)", &interval);
+
+                if (0 < stats_timer)
+                {
+                    g_source_remove(stats_timer);
+                    stats_timer = 0;
+                }
+                if (0 < interval)
+                {
+                    stats_target = sender;
+                    stats_encoder.Reset();
+                    stats_timer = g_timeout_add(interval, statistics_update, this);
+                }
+            }
+            else if ("FetchStatisticsHistory" == method_name)
+            {
+                guint32 max_samples = 0;
+                g_variant_get(params, "(u)", &max_samples);
+                StatisticsHistoryReport report = stats_history.GetReport(max_samples);
+                g_dbus_method_invocation_return_value(invoc, report.GetGVariant());
+                return;
+            }
+            else if ("FetchStatisticsSegment" == method_name)
+            {
+                return_statistics_segment(invoc);
+                return;
+            }
             else if ("ForceShutdown" == method_name)
             {
                 // This is an emergency break for this process.  This
@@ -609,6 +800,8 @@ public:
                                      const std::string property_name,
                                      GError **error)
     {
+        DBusCallDeadlineScope deadline(sender, OpenVPN3DBus_timeout_backends
+                                                - OpenVPN3DBus_timeout_margin);
         try {
             // Some properties can be read without any restrictions ...
             if ("device_path" == property_name)
@@ -658,6 +851,10 @@ public:
             {
                 return g_variant_new_string((vpnclient ? vpnclient->tun_builder_get_session_name().c_str() : ""));
             }
+            else if ("startup_timings" == property_name)
+            {
+                return startup_timings.GetGVariant();
+            }
         }
         catch (DBusCredentialsException& excp)
         {
@@ -699,6 +896,8 @@ public:
                                             GVariant *value,
                                             GError **error)
     {
+        DBusCallDeadlineScope deadline(sender, OpenVPN3DBus_timeout_backends
+                                                - OpenVPN3DBus_timeout_margin);
         try
         {
             // Only the session manager is allowed to set properties
@@ -735,19 +934,177 @@ private:
     GMainLoop *mainloop;
     BackendSignals signal;
     bool signal_broadcast;
+    std::string bus_name;
     std::string session_token;
+    bool standby = false;
+    guint standby_timer = 0;
     bool registered;
     bool paused;
     std::string configpath;
+    StartupTimings startup_timings;  ///< Must outlive vpnclient
     CoreVPNClient::Ptr vpnclient;
     bool disabled_socket_protect;
     bool ignore_dns_cfg;
     std::unique_ptr<std::thread> client_thread;
     ClientAPI::Config vpnconfig;
     ClientAPI::EvalConfig cfgeval;
+    bool client_used = false;  ///< vpnclient has been used for a connection
+    ProfileEvaluation profile_eval;
     ClientAPI::ProvideCreds creds;
     RequiresQueue userinputq;
     std::mutex guard;
+    guint stats_timer = 0;
+    std::string stats_target;
+    StatisticsDeltaEncoder stats_encoder;
+    guint history_timer = 0;
+    StatisticsHistory stats_history;
+    std::unique_ptr<StatisticsSegmentWriter> stats_segment;
+
+
+    /**
+     *  Returns a read-only file descriptor of the shared memory segment
+     *  with the statistics counters.  The segment is created on the
+     *  first request; from then on it is updated together with the
+     *  statistics history, once a second.
+     *
+     * @param invoc  GDBusMethodInvocation of the FetchStatisticsSegment call
+     *
+     * @throws DBusException if the segment could not be prepared
+     */
+    void return_statistics_segment(GDBusMethodInvocation *invoc)
+    {
+        int fd = -1;
+        try
+        {
+            if (!stats_segment)
+            {
+                stats_segment.reset(new StatisticsSegmentWriter(CoreVPNClient::GetStatsNames()));
+                if (vpnclient)
+                {
+                    stats_segment->Update(vpnclient->GetStatsValues(),
+                                          g_get_monotonic_time());
+                }
+            }
+            fd = stats_segment->GetReaderFD();
+        }
+        catch (const StatisticsSegmentException& excp)
+        {
+            // Without a reader there is no point in keeping the segment
+            // updated; the next request will try again
+            stats_segment.reset();
+            THROW_DBUSEXCEPTION("BackendServiceObject", excp.what());
+        }
+
+        GError *error = nullptr;
+        GUnixFDList *fdlist = g_unix_fd_list_new();
+        g_unix_fd_list_append(fdlist, fd, &error);
+        close(fd);
+        if (error)
+        {
+            GLibUtils::unref_fdlist(fdlist);
+            std::string err(error->message);
+            g_error_free(error);
+            THROW_DBUSEXCEPTION("BackendServiceObject",
+                                "Could not prepare the fd list: " + err);
+        }
+        g_dbus_method_invocation_return_value_with_unix_fd_list(invoc,
+                                                                nullptr,
+                                                                fdlist);
+        GLibUtils::unref_fdlist(fdlist);
+    }
+
+
+    /**
+     *  Tells the session manager we are ready.  This request will also
+     *  carry the correct object path in the response automatically, but
+     *  the well-known bus name needs to be sent back.
+     */
+    void send_registration_request()
+    {
+        signal.LogVerb1("Initializing VPN client session, token "
+                        + session_token);
+        signal.Send(OpenVPN3DBus_name_sessions,
+                    OpenVPN3DBus_interf_backends,
+                    "RegistrationRequest",
+                    g_variant_new("(ssi)",
+                                  bus_name.c_str(), session_token.c_str(),
+                                  getpid()));
+    }
+
+
+    /**
+     *  Timer callback stopping a standby process which was not assigned
+     *  to any session within the expiry time
+     */
+    static gboolean standby_expired(gpointer this_ptr)
+    {
+        BackendClientObject *self = static_cast<BackendClientObject *>(this_ptr);
+        self->standby_timer = 0;
+        self->signal.LogVerb2("No session assigned to the standby process, "
+                              "shutting down");
+        self->RemoveObject(self->dbusconn);
+        if (self->mainloop)
+        {
+            g_main_loop_quit(self->mainloop);
+        }
+        else
+        {
+            kill(getpid(), SIGTERM);
+        }
+        return G_SOURCE_REMOVE;
+    }
+
+
+    /**
+     *  Timer callback adding a sample to the statistics history and
+     *  updating the statistics segment, if requested by anyone, once
+     *  a second while a connection is running
+     */
+    static gboolean statistics_sample(gpointer this_ptr)
+    {
+        BackendClientObject *self = static_cast<BackendClientObject *>(this_ptr);
+        if (self->vpnclient)
+        {
+            std::vector<long long> values = self->vpnclient->GetStatsValues();
+            gint64 now = g_get_monotonic_time();
+            self->stats_history.Add(CoreVPNClient::GetStatsNames(),
+                                    values, now);
+            if (self->stats_segment)
+            {
+                self->stats_segment->Update(values, now);
+            }
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+
+    /**
+     *  Timer callback sending the periodic StatisticsUpdate signal to the
+     *  session manager.  Only the counters which changed since the
+     *  previous update are sent; nothing is sent if no counters changed
+     *  or no connection is running.
+     */
+    static gboolean statistics_update(gpointer this_ptr)
+    {
+        BackendClientObject *self = static_cast<BackendClientObject *>(this_ptr);
+        if (!self->vpnclient)
+        {
+            return G_SOURCE_CONTINUE;
+        }
+
+        StatisticsFrame frame;
+        if (self->stats_encoder.Encode(CoreVPNClient::GetStatsNames(),
+                                       self->vpnclient->GetStatsValues(),
+                                       g_get_monotonic_time(), frame))
+        {
+            self->signal.Send(std::vector<std::string>{self->stats_target},
+                              OpenVPN3DBus_interf_backends,
+                              self->GetObjectPath(),
+                              "StatisticsUpdate",
+                              frame.GetGVariant());
+        }
+        return G_SOURCE_CONTINUE;
+    }
 
 
     /**
@@ -894,6 +1251,7 @@ private:
                 }
                 client_thread = nullptr;
             }
+            client_used = true;
             client_thread.reset(new std::thread([self=Ptr(this)]()
                                                 {
                                                     self->run_connection_thread();
@@ -928,6 +1286,8 @@ private:
                                           session_token));
         vpnclient->disable_socket_protect(disabled_socket_protect);
         vpnclient->disable_dns_config(ignore_dns_cfg);
+        vpnclient->set_startup_timings(&startup_timings);
+        client_used = false;
 
         if (userinputq.QueueCount(ClientAttentionType::CREDENTIALS,
                                   ClientAttentionGroup::PK_PASSPHRASE) > 0)
@@ -937,47 +1297,6 @@ private:
                                                                   "pk_passphrase");
         }
 
-        // Parse the configuration profile to an OptionList to be able
-        // to extract certain values from the configuration directly
-        OptionList parsed_opts;
-        try
-        {
-            // Basic profile limits
-            OptionList::Limits limits("profile is too large",
-                                      ProfileParseLimits::MAX_PROFILE_SIZE,
-                                      ProfileParseLimits::OPT_OVERHEAD,
-                                      ProfileParseLimits::TERM_OVERHEAD,
-                                      ProfileParseLimits::MAX_LINE_SIZE,
-                                      ProfileParseLimits::MAX_DIRECTIVE_SIZE);
-
-            parsed_opts.parse_from_config(vpnconfig.content, &limits);
-            parsed_opts.update_map();
-        }
-        catch (const std::exception& excp)
-        {
-            THROW_DBUSEXCEPTION("BackendClientObject",
-                                "Configuration pre-parsing failed: "
-                                + std::string(excp.what()));
-        }
-
-        //
-        // Check if the configuration contains a client certificate or not
-        //
-        // The client_cert_present does now only consider file based
-        // certificates, but is intended to be set also if certificates is
-        // expected to be provided by external PKI
-        //
-        try
-        {
-            Option cert = parsed_opts.get("cert");
-        }
-        catch (...)
-        {
-            // If this happens, the configuration profile does not
-            // contain a client certificate - so we disable it
-            vpnconfig.disableClientCert = true;
-        }
-
         // We need to provide a copy of the vpnconfig object, as vpnclient
         // seems to take ownership
         cfgeval = vpnclient->eval_config(ClientAPI::Config(vpnconfig));
@@ -1064,8 +1383,9 @@ private:
             // GetConfig() call.
             std::vector<OverrideValue> overrides = cfg_proxy.GetOverrides();
 
-            // Parse the configuration
-            ProfileMergeFromString pm(cfg_proxy.GetConfig(), "",
+            // Retrieve the configuration together with the evaluation
+            // done by the configuration manager, and parse it
+            ProfileMergeFromString pm(cfg_proxy.GetConfigEvaluated(profile_eval), "",
                                       ProfileMerge::FOLLOW_NONE,
                                       ProfileParseLimits::MAX_LINE_SIZE,
                                       ProfileParseLimits::MAX_PROFILE_SIZE);
@@ -1076,6 +1396,10 @@ private:
 #endif
             vpnconfig.info = true;
             vpnconfig.content = pm.profile_content();
+
+            // Only file based client certificates are considered; they
+            // are intended to be provided by external PKI as well later on
+            vpnconfig.disableClientCert = !profile_eval.client_cert;
             set_overrides(overrides);
         }
         catch (std::exception& e)
@@ -1091,96 +1415,68 @@ private:
     {
         for (const auto & override: overrides)
         {
-            bool valid_override = false;
-            if (override.override.key == "server-override")
+            // The override descriptor carries the override ID and the
+            // value is already typed, so no key comparisons are needed
+            bool valid_override = true;
+            switch (override.override->id)
             {
+            case OverrideID::server_override:
                 vpnconfig.serverOverride = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "port-override")
-            {
+                break;
+            case OverrideID::port_override:
                 vpnconfig.portOverride = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "proto-override")
-            {
+                break;
+            case OverrideID::proto_override:
                 vpnconfig.protoOverride = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "ipv6")
-            {
+                break;
+            case OverrideID::ipv6:
                 vpnconfig.ipv6 = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "dns-fallback-google")
-            {
+                break;
+            case OverrideID::dns_fallback_google:
                 vpnconfig.googleDnsFallback = override.boolValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "dns-setup-disabled")
-            {
+                break;
+            case OverrideID::dns_setup_disabled:
                 ignore_dns_cfg = override.boolValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "dns-sync-lookup")
-            {
+                break;
+            case OverrideID::dns_sync_lookup:
                 vpnconfig.synchronousDnsLookup = override.boolValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "auth-fail-retry")
-            {
+                break;
+            case OverrideID::auth_fail_retry:
                 vpnconfig.retryOnAuthFailed = override.boolValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "force-cipher-aes-cbc")
-            {
+                break;
+            case OverrideID::force_cipher_aes_cbc:
                 vpnconfig.forceAesCbcCiphersuites = override.boolValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "allow-compression")
-            {
+                break;
+            case OverrideID::allow_compression:
                 vpnconfig.compressionMode = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "tls-version-min")
-            {
+                break;
+            case OverrideID::tls_version_min:
                 vpnconfig.tlsVersionMinOverride = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "tls-cert-profile")
-            {
+                break;
+            case OverrideID::tls_cert_profile:
                 vpnconfig.tlsCertProfileOverride = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "persist-tun")
-            {
+                break;
+            case OverrideID::persist_tun:
                 vpnconfig.tunPersist = override.boolValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "proxy-host")
-            {
+                break;
+            case OverrideID::proxy_host:
                 vpnconfig.proxyHost = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "proxy-port")
-            {
+                break;
+            case OverrideID::proxy_port:
                 vpnconfig.proxyPort = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "proxy-username")
-            {
+                break;
+            case OverrideID::proxy_username:
                 vpnconfig.proxyUsername = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "proxy-password")
-            {
+                break;
+            case OverrideID::proxy_password:
                 vpnconfig.proxyPassword = override.strValue;
-                valid_override = true;
-            }
-            else if (override.override.key == "proxy-auth-cleartext")
-            {
+                break;
+            case OverrideID::proxy_auth_cleartext:
                 vpnconfig.proxyAllowCleartextAuth = override.boolValue;
-                valid_override = true;
+                break;
+            default:
+                valid_override = false;
+                break;
             }
 
             // Add some logging to the overrides which got processed
@@ -1189,10 +1485,10 @@ private:
                 std::stringstream msg;
 
                 msg << "Configuration override '"
-                    << override.override.key << "' ";
+                    << override.override->key << "' ";
 
                 bool invalid = false;
-                switch (override.override.type)
+                switch (override.override->type)
                 {
                 case OverrideType::string:
                     msg << "set to '" << override.strValue << "'";
@@ -1226,7 +1522,7 @@ private:
                 // the valid_override will typically be false.  Log this
                 // scenario slightly different
                 signal.LogError("Unsupported override: "
-                                + override.override.key);
+                                + override.override->key);
             }
         }
     }
@@ -1245,20 +1541,18 @@ public:
     /**
      *  Initializes the BackendClientDBus object
      *
-     * @param start_pid  The PID value we were started with, used for logging
      * @param bus_type   GBusType, which defines if this service should be
      *                   registered on the system or session bus.
      * @param sesstoken  String containing the session token provided via the
      *                   command line.  This is used when signalling back
      *                   to the session manager.
      */
-    BackendClientDBus(pid_t start_pid, GBusType bus_type,
+    BackendClientDBus(GBusType bus_type,
                       std::string sesstoken, LogWriter *logwr)
         : DBus(bus_type,
                OpenVPN3DBus_name_backends_be + to_string(getpid()),
                OpenVPN3DBus_rootp_sessions,
                OpenVPN3DBus_interf_sessions),
-          start_pid(start_pid),
           session_token(sesstoken),
           logwr(logwr),
           procsig(nullptr),
@@ -1337,6 +1631,19 @@ public:
        disabled_socket_protect = val;
     }
 
+
+    /**
+     *  Runs this process as a standby process, waiting for a session
+     *  token from openvpn3-service-backendstart instead of having it
+     *  on the command line.
+     *
+     * @param expiry  Seconds to wait for a session before exiting
+     */
+    void SetStandby(unsigned int expiry)
+    {
+        standby_expiry = expiry;
+    }
+
     /**
      *  This callback is called when the service was successfully registered
      *  on the D-Bus.
@@ -1377,8 +1684,8 @@ public:
         signal.reset(new BackendSignals(GetConnection(), LogGroup::BACKENDPROC,
                                         session_token, logwr));
         signal->SetLogLevel(default_log_level);
-        signal->LogVerb2("Backend client process started as pid " + std::to_string(start_pid)
-                         + " daemonized as pid " + std::to_string(getpid()));
+        signal->LogVerb2("Backend client process started as pid "
+                         + std::to_string(getpid()));
         signal->Debug("BackendClientDBus registered on '" + GetBusName()
                        + "': " + object_path);
 
@@ -1392,14 +1699,34 @@ public:
      *  This is called each time the well-known bus name is successfully
      *  acquired on the D-Bus.
      *
-     *  This is not used, as the preparations already happens in
-     *  callback_bus_acquired()
+     *  A standby process offers itself to the backend starter from here,
+     *  as the session manager expects the well-known bus name to be
+     *  owned once the process is handed over to a session.
      *
      * @param conn     Connection where this event happened
      * @param busname  A string of the acquired bus name
      */
     void callback_name_acquired(GDBusConnection *conn, std::string busname)
     {
+        if (0 == standby_expiry || !be_obj)
+        {
+            return;
+        }
+
+        try
+        {
+            if (!be_obj->RegisterStandby(standby_expiry))
+            {
+                signal->LogVerb2("Standby process not needed, shutting down");
+                kill(getpid(), SIGTERM);
+            }
+        }
+        catch (DBusException& excp)
+        {
+            signal->LogError("Could not register as a standby process: "
+                             + std::string(excp.what()));
+            kill(getpid(), SIGTERM);
+        }
     };
 
 
@@ -1421,7 +1748,6 @@ public:
 
 private:
     unsigned int default_log_level = 6; // LogCategory::DEBUG messages
-    pid_t start_pid;
     std::string session_token;
     std::string object_path;
     LogWriter *logwr;
@@ -1431,18 +1757,20 @@ private:
     BackendSignals::Ptr signal;
     bool signal_broadcast;
     LogServiceProxy::Ptr logservice;
+    unsigned int standby_expiry = 0;
 };
 
 
-void start_client_thread(pid_t start_pid, const std::string argv0,
+void start_client_thread(const std::string argv0,
                         const std::string sesstoken,
+                        unsigned int standby_expiry,
                         bool disable_socket_protect,
                         int log_level, bool signal_broadcast,
                         LogWriter *logwr)
 {
     std::cout << get_version(argv0) << std::endl;
 
-    BackendClientDBus backend_service(start_pid, G_BUS_TYPE_SYSTEM,
+    BackendClientDBus backend_service(G_BUS_TYPE_SYSTEM,
                                       sesstoken, logwr);
     if (log_level > 0)
     {
@@ -1450,6 +1778,7 @@ void start_client_thread(pid_t start_pid, const std::string argv0,
     }
     backend_service.SetSignalBroadcast(signal_broadcast);
     backend_service.DisableSocketProtect(disable_socket_protect);
+    backend_service.SetStandby(standby_expiry);
     backend_service.Setup();
 
     // Main loop
@@ -1459,14 +1788,25 @@ void start_client_thread(pid_t start_pid, const std::string argv0,
     g_unix_signal_add(SIGHUP, stop_handler, main_loop);
     backend_service.SetMainLoop(main_loop);
     g_main_loop_run(main_loop);
-    usleep(500);
     g_main_loop_unref(main_loop);
 }
 
 
 int client_service(ParsedArgs args)
 {
+    // A standby process gets its session token later on, from
+    // openvpn3-service-backendstart
+    unsigned int standby_expiry = 0;
+    if (args.Present("standby-expiry"))
+    {
+        standby_expiry = std::atoi(args.GetValue("standby-expiry", 0).c_str());
+    }
+
     auto extra = args.GetAllExtraArgs();
+    if (0 < standby_expiry && extra.empty())
+    {
+        extra.push_back("");
+    }
     if (extra.size() != 1)
     {
         std::cout << "** ERROR ** Invalid usage: " << args.GetArgv0()
@@ -1509,12 +1849,12 @@ int client_service(ParsedArgs args)
     }
 
 
-    // Save the current pid, for logging later on
-    pid_t start_pid = getpid();
-
-    // Get a new process session ID, unless we're debugging
-    // and --no-setsid is used.  This can make gdb debugging simpler.
-    if (!args.Present("no-setsid") && (-1 == setsid()))
+    // openvpn3-service-backendstart already starts this process in a
+    // new session; otherwise get a new process session ID, unless
+    // we're debugging and --no-setsid is used.  This can make gdb
+    // debugging simpler.
+    if (!args.Present("no-setsid") && getsid(0) != getpid()
+        && (-1 == setsid()))
     {
         std::cerr << "** ERROR ** Failed getting a new process session ID:" << strerror(errno) << std::endl;
         return 3;
@@ -1526,60 +1866,21 @@ int client_service(ParsedArgs args)
         log_level = std::atoi(args.GetValue("log-level", 0).c_str());
     }
 
-#ifdef OPENVPN_DEBUG
-    // When debugging, we might not want to do a fork.
-    if (args.Present("no-fork"))
-    {
-        try
-        {
-            start_client_thread(getpid(), args.GetArgv0(), extra[0],
-                                args.Present("disable-protect-socket"),
-                                log_level, args.Present("signal-broadcast"),
-                                logwr.get());
-            return 0;
-        }
-        catch (std::exception& excp)
-        {
-            std::cout << "FATAL ERROR: " << excp.what() << std::endl;
-            return 3;
-        }
-        // This should really not happen, but if it does - lets log it
-        std::cout << "FATAL ERROR: Unexpected error event in no-fork branch"
-                  << std::endl;
-        return 8;
-    }
-#endif
-
-    //
-    // This is the normal production code branch
-    //
-    pid_t real_pid = fork();
-    if (real_pid == 0)
+    // This process is not forked into the background, so the PID seen
+    // by openvpn3-service-backendstart is the PID of the backend client
+    try
     {
-        try
-        {
-            start_client_thread(start_pid, args.GetArgv0(), extra[0],
-                                args.Present("disable-protect-socket"),
-                                log_level, args.Present("signal-broadcast"),
-                                logwr.get());
-            return 0;
-        }
-        catch (std::exception& excp)
-        {
-            std::cout << "FATAL ERROR: " << excp.what() << std::endl;
-            return 3;
-        }
+        start_client_thread(args.GetArgv0(), extra[0], standby_expiry,
+                            args.Present("disable-protect-socket"),
+                            log_level, args.Present("signal-broadcast"),
+                            logwr.get());
+        return 0;
     }
-    else if (real_pid > 0)
+    catch (std::exception& excp)
     {
-        std::cout << "Re-initiated process from pid " << std::to_string(start_pid)
-                  << " to backend process pid " << std::to_string(real_pid)
-                  << std::endl;
-        return 0;
+        std::cout << "FATAL ERROR: " << excp.what() << std::endl;
+        return 3;
     }
-
-    std::cerr << "** ERROR ** Failed forking out backend process child" << std::endl;
-    return 3;
 }
 
 
@@ -1599,11 +1900,12 @@ int main(int argc, char **argv)
     argparser.AddOption("disable-protect-socket", 0,
                         "Disable the socket protect call on the UDP/TCP socket. "
                         "This is needed on systems not supporting this feature");
+    argparser.AddOption("standby-expiry", "SECONDS", true,
+                        "Start without a session token and wait up to SECONDS "
+                        "for openvpn3-service-backendstart to assign one");
 #if OPENVPN_DEBUG
-    argparser.AddOption("no-fork", 0,
-                        "Debug option: Do not fork a child to be run in the background.");
     argparser.AddOption("no-setsid", 0,
-                        "Debug option: Do not not call setsid(3) when forking process.");
+                        "Debug option: Do not not call setsid(3) when starting.");
 #endif
 
     try
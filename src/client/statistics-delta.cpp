@@ -0,0 +1,170 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-delta.cpp
+ *
+ * @brief  Delta encoding of connection statistics, used by the periodic
+ *         StatisticsUpdate signals
+ */
+
+#include "statistics-delta.hpp"
+
+
+StatisticsFrame::StatisticsFrame(GVariant *params)
+{
+    gint64 ts = 0;
+    guint32 seq = 0;
+    GVariantIter *keylist = nullptr;
+    GVariantIter *deltalist = nullptr;
+    g_variant_get(params, "(xuasa(ux))", &ts, &seq, &keylist, &deltalist);
+    timestamp = ts;
+    sequence = seq;
+
+    const gchar *key = nullptr;
+    while (g_variant_iter_next(keylist, "&s", &key))
+    {
+        keys.push_back(std::string(key));
+    }
+    g_variant_iter_free(keylist);
+
+    guint32 idx = 0;
+    gint64 delta = 0;
+    while (g_variant_iter_next(deltalist, "(ux)", &idx, &delta))
+    {
+        deltas.push_back(Delta(idx, delta));
+    }
+    g_variant_iter_free(deltalist);
+}
+
+
+GVariant * StatisticsFrame::GetGVariant() const
+{
+    GVariantBuilder *kb = g_variant_builder_new(G_VARIANT_TYPE("as"));
+    for (const auto& k : keys)
+    {
+        g_variant_builder_add(kb, "s", k.c_str());
+    }
+    GVariant *keylist = g_variant_builder_end(kb);
+    g_variant_builder_unref(kb);
+
+    GVariantBuilder *db = g_variant_builder_new(G_VARIANT_TYPE("a(ux)"));
+    for (const auto& d : deltas)
+    {
+        g_variant_builder_add(db, "(ux)", (guint32) d.first, (gint64) d.second);
+    }
+    GVariant *deltalist = g_variant_builder_end(db);
+    g_variant_builder_unref(db);
+
+    return g_variant_new("(xu@as@a(ux))", (gint64) timestamp,
+                         (guint32) sequence, keylist, deltalist);
+}
+
+
+bool StatisticsDeltaEncoder::Encode(const std::vector<std::string>& keys,
+                                    const std::vector<long long>& values,
+                                    const int64_t timestamp,
+                                    StatisticsFrame& frame)
+{
+    const size_t n = (keys.size() < values.size() ? keys.size() : values.size());
+    bool keyframe = keyframe_pending
+                    || since_keyframe >= keyframe_interval
+                    || keys != last_keys;
+
+    frame.timestamp = timestamp;
+    frame.keys.clear();
+    frame.deltas.clear();
+    if (keyframe)
+    {
+        frame.keys.assign(keys.begin(), keys.begin() + n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (0 != values[i])
+            {
+                frame.deltas.push_back(StatisticsFrame::Delta(i, values[i]));
+            }
+        }
+        last_keys = frame.keys;
+        last_values.assign(values.begin(), values.begin() + n);
+        keyframe_pending = false;
+        since_keyframe = 0;
+    }
+    else
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (values[i] != last_values[i])
+            {
+                frame.deltas.push_back(StatisticsFrame::Delta(i, values[i] - last_values[i]));
+                last_values[i] = values[i];
+            }
+        }
+        if (frame.deltas.empty())
+        {
+            return false;
+        }
+    }
+
+    ++since_keyframe;
+    frame.sequence = sequence++;
+    return true;
+}
+
+
+bool StatisticsDeltaDecoder::Apply(const StatisticsFrame& frame)
+{
+    if (frame.IsKeyFrame())
+    {
+        keys = frame.keys;
+        values.assign(keys.size(), 0);
+    }
+    else if (!synchronized || frame.sequence != sequence + 1)
+    {
+        // A frame was lost; the values can only be restored
+        // by the next key frame
+        synchronized = false;
+        return false;
+    }
+
+    for (const auto& d : frame.deltas)
+    {
+        if (d.first < values.size())
+        {
+            values[d.first] += d.second;
+        }
+    }
+    synchronized = true;
+    sequence = frame.sequence;
+    timestamp = frame.timestamp;
+    return true;
+}
+
+
+ConnectionStats StatisticsDeltaDecoder::GetStats() const
+{
+    ConnectionStats ret;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        if (0 != values[i])
+        {
+            ret.push_back(ConnectionStatDetails(keys[i], values[i]));
+        }
+    }
+    return ret;
+}
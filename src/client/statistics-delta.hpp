@@ -0,0 +1,187 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-delta.hpp
+ *
+ * @brief  Delta encoding of connection statistics, used by the periodic
+ *         StatisticsUpdate signals
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glib.h>
+
+#include "statistics.hpp"
+
+
+/**
+ *  A single StatisticsUpdate signal.
+ *
+ *  A key frame carries the names of all the counters, in the order the
+ *  counters are indexed, together with all counters which are not zero.
+ *  The following delta frames only carry the index of the counters which
+ *  changed since the previous frame and the difference to the previous
+ *  value.
+ */
+struct StatisticsFrame
+{
+    typedef std::pair<uint32_t, int64_t> Delta;
+
+    StatisticsFrame() = default;
+
+    /**
+     *  Restores a frame from the parameters of a StatisticsUpdate signal
+     *
+     * @param params  GVariant (xuasa(ux)) tuple
+     */
+    StatisticsFrame(GVariant *params);
+
+    /**
+     * @return Returns true if this frame is a key frame
+     */
+    bool IsKeyFrame() const noexcept
+    {
+        return !keys.empty();
+    }
+
+    /**
+     * @return Returns the frame as a GVariant (xuasa(ux)) tuple, as used
+     *         by the StatisticsUpdate signal
+     */
+    GVariant * GetGVariant() const;
+
+    int64_t timestamp = 0;       ///< Sample time, CLOCK_MONOTONIC usecs
+    uint32_t sequence = 0;       ///< Frame counter, increased per frame
+    std::vector<std::string> keys; ///< Counter names, only in key frames
+    std::vector<Delta> deltas;   ///< Changed counters, by counter index
+};
+
+
+/**
+ *  Creates StatisticsFrame objects from periodic samples of the
+ *  connection statistics counters.
+ */
+class StatisticsDeltaEncoder
+{
+public:
+    /**
+     * @param keyframe_interval  A key frame is sent at least every
+     *                           keyframe_interval frames, so receivers
+     *                           which missed a frame can resynchronize.
+     */
+    StatisticsDeltaEncoder(const unsigned int keyframe_interval = 60)
+        : keyframe_interval(keyframe_interval)
+    {
+    }
+
+    /**
+     *  Encodes a new sample of all the statistics counters
+     *
+     * @param keys       std::vector<std::string> of all counter names
+     * @param values     std::vector<long long> of all counter values, in
+     *                   the same order as keys
+     * @param timestamp  Sample time, CLOCK_MONOTONIC microseconds
+     * @param frame      StatisticsFrame receiving the encoded frame
+     *
+     * @return Returns true if a frame should be sent.  If no counters
+     *         changed since the previous frame, nothing needs to be sent
+     *         and false is returned.
+     */
+    bool Encode(const std::vector<std::string>& keys,
+                const std::vector<long long>& values,
+                const int64_t timestamp, StatisticsFrame& frame);
+
+    /**
+     *  Ensures the next frame will be a key frame.  This is used when new
+     *  receivers have started listening.
+     */
+    void Reset() noexcept
+    {
+        keyframe_pending = true;
+    }
+
+
+private:
+    const unsigned int keyframe_interval;
+    bool keyframe_pending = true;
+    unsigned int since_keyframe = 0;
+    uint32_t sequence = 0;
+    std::vector<std::string> last_keys;
+    std::vector<long long> last_values;
+};
+
+
+/**
+ *  Reconstructs the connection statistics from received StatisticsFrame
+ *  objects
+ */
+class StatisticsDeltaDecoder
+{
+public:
+    StatisticsDeltaDecoder() = default;
+
+    /**
+     *  Applies a received frame.  A delta frame is only applied if no
+     *  frames are missing since the previous frame.  Otherwise, the
+     *  decoder waits for the next key frame.
+     *
+     * @param frame  StatisticsFrame to apply
+     *
+     * @return Returns true if the frame was applied
+     */
+    bool Apply(const StatisticsFrame& frame);
+
+    /**
+     * @return Returns true if a key frame and all the following frames
+     *         have been applied
+     */
+    bool Synchronized() const noexcept
+    {
+        return synchronized;
+    }
+
+    /**
+     * @return Returns the sample time of the last applied frame, in
+     *         CLOCK_MONOTONIC microseconds
+     */
+    int64_t GetTimestamp() const noexcept
+    {
+        return timestamp;
+    }
+
+    /**
+     * @return Returns a ConnectionStats array with all the counters which
+     *         are not zero, the same way the statistics property reports
+     *         them
+     */
+    ConnectionStats GetStats() const;
+
+
+private:
+    bool synchronized = false;
+    uint32_t sequence = 0;
+    int64_t timestamp = 0;
+    std::vector<std::string> keys;
+    std::vector<long long> values;
+};
@@ -0,0 +1,281 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-history.cpp
+ *
+ * @brief  Time series of the most important connection statistics
+ *         counters, with throughput rate calculation
+ */
+
+#include "statistics-history.hpp"
+
+
+const size_t StatisticsHistory::TRACKED;
+
+/** Slot of the sum of all *_ERROR counters */
+static const int errors_slot = StatisticsHistory::TRACKED - 1;
+
+
+static bool ends_with(const std::string& str, const std::string& suffix)
+{
+    return str.size() >= suffix.size()
+           && 0 == str.compare(str.size() - suffix.size(), suffix.size(),
+                               suffix);
+}
+
+
+StatisticsHistoryReport::StatisticsHistoryReport(GVariant *report)
+{
+    GVariantIter *keylist = nullptr;
+    GVariantIter *samplelist = nullptr;
+    GVariantIter *ratelist = nullptr;
+    g_variant_get(report, "(asa(xax)a(sddd))",
+                  &keylist, &samplelist, &ratelist);
+
+    const gchar *key = nullptr;
+    while (g_variant_iter_next(keylist, "&s", &key))
+    {
+        keys.push_back(std::string(key));
+    }
+    g_variant_iter_free(keylist);
+
+    gint64 ts = 0;
+    GVariantIter *valuelist = nullptr;
+    while (g_variant_iter_next(samplelist, "(xax)", &ts, &valuelist))
+    {
+        Sample s;
+        s.timestamp = ts;
+        gint64 val = 0;
+        while (g_variant_iter_next(valuelist, "x", &val))
+        {
+            s.values.push_back(val);
+        }
+        g_variant_iter_free(valuelist);
+        samples.push_back(s);
+    }
+    g_variant_iter_free(samplelist);
+
+    StatisticsRate r;
+    while (g_variant_iter_next(ratelist, "(&sddd)", &key,
+                               &r.rate_1s, &r.rate_10s, &r.rate_60s))
+    {
+        r.key = std::string(key);
+        rates.push_back(r);
+    }
+    g_variant_iter_free(ratelist);
+}
+
+
+GVariant * StatisticsHistoryReport::GetGVariant() const
+{
+    GVariantBuilder *kb = g_variant_builder_new(G_VARIANT_TYPE("as"));
+    for (const auto& k : keys)
+    {
+        g_variant_builder_add(kb, "s", k.c_str());
+    }
+
+    GVariantBuilder *sb = g_variant_builder_new(G_VARIANT_TYPE("a(xax)"));
+    for (const auto& s : samples)
+    {
+        GVariantBuilder *vb = g_variant_builder_new(G_VARIANT_TYPE("ax"));
+        for (const auto& v : s.values)
+        {
+            g_variant_builder_add(vb, "x", (gint64) v);
+        }
+        g_variant_builder_add(sb, "(xax)", (gint64) s.timestamp, vb);
+        g_variant_builder_unref(vb);
+    }
+
+    GVariantBuilder *rb = g_variant_builder_new(G_VARIANT_TYPE("a(sddd)"));
+    for (const auto& r : rates)
+    {
+        g_variant_builder_add(rb, "(sddd)", r.key.c_str(),
+                              r.rate_1s, r.rate_10s, r.rate_60s);
+    }
+
+    GVariant *ret = g_variant_new("(asa(xax)a(sddd))", kb, sb, rb);
+    g_variant_builder_unref(kb);
+    g_variant_builder_unref(sb);
+    g_variant_builder_unref(rb);
+    return ret;
+}
+
+
+StatisticsHistory::StatisticsHistory(const size_t capacity)
+    : ring(0 < capacity ? capacity : 1)
+{
+}
+
+
+const std::vector<std::string>& StatisticsHistory::TrackedKeys()
+{
+    static const std::vector<std::string> keys = {
+        "BYTES_IN", "BYTES_OUT", "PACKETS_IN", "PACKETS_OUT",
+        "TUN_BYTES_IN", "TUN_BYTES_OUT", "TUN_PACKETS_IN", "TUN_PACKETS_OUT",
+        "ERRORS"
+    };
+    return keys;
+}
+
+
+void StatisticsHistory::Add(const std::vector<std::string>& names,
+                            const std::vector<long long>& values,
+                            const int64_t timestamp)
+{
+    if (names != mapped_names)
+    {
+        map_names(names);
+    }
+
+    Entry e;
+    e.timestamp = timestamp;
+    e.values.fill(0);
+    for (size_t i = 0; i < slot_map.size() && i < values.size(); ++i)
+    {
+        if (0 <= slot_map[i])
+        {
+            e.values[slot_map[i]] += values[i];
+        }
+    }
+
+    if (0 < count)
+    {
+        const Entry& last = entry(0);
+        for (size_t s = 0; s < TRACKED; ++s)
+        {
+            if (e.values[s] < last.values[s])
+            {
+                // Counters were reset by a new connection
+                Clear();
+                break;
+            }
+        }
+    }
+
+    ring[head] = e;
+    head = (head + 1) % ring.size();
+    if (count < ring.size())
+    {
+        ++count;
+    }
+}
+
+
+std::vector<StatisticsRate> StatisticsHistory::GetRates() const
+{
+    std::vector<StatisticsRate> ret;
+    const std::vector<std::string>& keys = TrackedKeys();
+    for (size_t s = 0; s < TRACKED; ++s)
+    {
+        StatisticsRate r;
+        r.key = keys[s];
+        r.rate_1s = rate(s, 1000000);
+        r.rate_10s = rate(s, 10000000);
+        r.rate_60s = rate(s, 60000000);
+        ret.push_back(r);
+    }
+    return ret;
+}
+
+
+StatisticsHistoryReport StatisticsHistory::GetReport(const size_t max_samples) const
+{
+    StatisticsHistoryReport ret;
+    ret.keys = TrackedKeys();
+
+    size_t n = (max_samples < count ? max_samples : count);
+    for (size_t age = n; 0 < age; --age)
+    {
+        const Entry& e = entry(age - 1);
+        StatisticsHistoryReport::Sample s;
+        s.timestamp = e.timestamp;
+        s.values.assign(e.values.begin(), e.values.end());
+        ret.samples.push_back(s);
+    }
+    ret.rates = GetRates();
+    return ret;
+}
+
+
+/**
+ *  Retrieve a sample by its age; 0 is the newest sample.  The age must
+ *  be lower than count.
+ */
+const StatisticsHistory::Entry& StatisticsHistory::entry(const size_t age) const
+{
+    return ring[(head + ring.size() - 1 - age) % ring.size()];
+}
+
+
+void StatisticsHistory::map_names(const std::vector<std::string>& names)
+{
+    const std::vector<std::string>& keys = TrackedKeys();
+    slot_map.assign(names.size(), -1);
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        for (int s = 0; s < errors_slot; ++s)
+        {
+            if (keys[s] == names[i])
+            {
+                slot_map[i] = s;
+                break;
+            }
+        }
+        if (0 > slot_map[i] && ends_with(names[i], "_ERROR"))
+        {
+            slot_map[i] = errors_slot;
+        }
+    }
+    mapped_names = names;
+    Clear();
+}
+
+
+/**
+ *  Calculates the average rate per second of a tracked counter over a
+ *  time window ending at the newest sample.  If the history does not
+ *  cover the complete window yet, the oldest sample is used.
+ */
+double StatisticsHistory::rate(const size_t slot, const int64_t window_us) const
+{
+    if (2 > count)
+    {
+        return 0;
+    }
+
+    const Entry& newest = entry(0);
+    const Entry *start = nullptr;
+    for (size_t age = 1; age < count; ++age)
+    {
+        start = &entry(age);
+        if (newest.timestamp - start->timestamp >= window_us)
+        {
+            break;
+        }
+    }
+
+    int64_t elapsed = newest.timestamp - start->timestamp;
+    if (0 >= elapsed)
+    {
+        return 0;
+    }
+    return (double) (newest.values[slot] - start->values[slot])
+           * 1000000.0 / (double) elapsed;
+}
@@ -0,0 +1,172 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-history.hpp
+ *
+ * @brief  Time series of the most important connection statistics
+ *         counters, with throughput rate calculation
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glib.h>
+
+
+/**
+ *  Throughput of a single counter, in units per second, averaged over
+ *  the last 1, 10 and 60 seconds
+ */
+struct StatisticsRate
+{
+    std::string key;
+    double rate_1s = 0;
+    double rate_10s = 0;
+    double rate_60s = 0;
+};
+
+
+/**
+ *  The result of a statistics history lookup, as passed over D-Bus
+ */
+struct StatisticsHistoryReport
+{
+    /**
+     *  A single sample, the values are in the same order as the keys
+     */
+    struct Sample
+    {
+        int64_t timestamp;           ///< Sample time, CLOCK_MONOTONIC usecs
+        std::vector<long long> values;
+    };
+
+    StatisticsHistoryReport() = default;
+
+    /**
+     *  Restores a report from a GVariant created by GetGVariant()
+     *
+     * @param report  GVariant (asa(xax)a(sddd)) tuple
+     */
+    StatisticsHistoryReport(GVariant *report);
+
+    /**
+     * @return Returns the report as a GVariant (asa(xax)a(sddd)) tuple
+     */
+    GVariant * GetGVariant() const;
+
+    std::vector<std::string> keys;     ///< Names of the tracked counters
+    std::vector<Sample> samples;       ///< Samples, the oldest first
+    std::vector<StatisticsRate> rates; ///< Rates of each tracked counter
+};
+
+
+/**
+ *  Keeps a fixed size ring buffer of periodic samples of the traffic and
+ *  error counters of a connection.  The tracked counters are the byte and
+ *  packet counters of the transport and the tun device.  In addition, the
+ *  ERRORS counter contains the sum of all the *_ERROR counters.
+ *
+ *  When the counters decrease, which happens when a new connection is
+ *  started, the history is cleared.
+ */
+class StatisticsHistory
+{
+public:
+    static const size_t TRACKED = 9;
+
+    /**
+     * @param capacity  Number of samples to keep.  With one sample per
+     *                  second, 61 samples are needed to calculate the
+     *                  60 second rates.
+     */
+    StatisticsHistory(const size_t capacity = 128);
+
+    /**
+     * @return Returns the names of the tracked counters
+     */
+    static const std::vector<std::string>& TrackedKeys();
+
+    /**
+     *  Adds a new sample of all the statistics counters.  Only the
+     *  tracked counters are kept.
+     *
+     * @param names      std::vector<std::string> of all counter names
+     * @param values     std::vector<long long> of all counter values, in
+     *                   the same order as names
+     * @param timestamp  Sample time, CLOCK_MONOTONIC microseconds
+     */
+    void Add(const std::vector<std::string>& names,
+             const std::vector<long long>& values,
+             const int64_t timestamp);
+
+    /**
+     *  Removes all the samples
+     */
+    void Clear() noexcept
+    {
+        count = 0;
+    }
+
+    /**
+     * @return Returns the number of samples kept
+     */
+    size_t size() const noexcept
+    {
+        return count;
+    }
+
+    /**
+     *  Calculates the rates of all the tracked counters
+     *
+     * @return Returns a std::vector<StatisticsRate> with one element per
+     *         tracked counter, in the order of TrackedKeys()
+     */
+    std::vector<StatisticsRate> GetRates() const;
+
+    /**
+     *  Retrieve the newest samples together with the current rates
+     *
+     * @param max_samples  Maximum number of samples to return
+     *
+     * @return Returns a StatisticsHistoryReport
+     */
+    StatisticsHistoryReport GetReport(const size_t max_samples) const;
+
+
+private:
+    struct Entry
+    {
+        int64_t timestamp;
+        std::array<long long, TRACKED> values;
+    };
+
+    std::vector<Entry> ring;
+    size_t head = 0;      ///< Index of the next entry to write
+    size_t count = 0;     ///< Number of valid entries
+    std::vector<int> slot_map;   ///< Counter index to tracked slot
+    std::vector<std::string> mapped_names;
+
+    const Entry& entry(const size_t age) const;
+    void map_names(const std::vector<std::string>& names);
+    double rate(const size_t slot, const int64_t window_us) const;
+};
@@ -0,0 +1,214 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-segment.cpp
+ *
+ * @brief  Connection statistics published in a shared memory segment,
+ *         which can be read without any D-Bus calls
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "dbus/sealed-memfd.hpp"
+#include "statistics-segment.hpp"
+
+
+static_assert(2 == ATOMIC_LLONG_LOCK_FREE,
+              "Lock-free 64-bit atomics are required in shared memory");
+static_assert(32 == sizeof(StatisticsSegmentHeader),
+              "The segment header layout is part of the D-Bus API");
+
+const uint32_t StatisticsSegmentHeader::MAGIC;
+const uint16_t StatisticsSegmentHeader::VERSION;
+
+/** Size of each counter name slot, including the terminating NUL */
+static const uint16_t name_slot_size = 32;
+
+/** Largest segment a reader accepts */
+static const size_t max_segment_size = 256 * 1024;
+
+/** How many times a reader retries while the writer is updating */
+static const unsigned int max_read_attempts = 10000;
+
+
+StatisticsSegmentWriter::StatisticsSegmentWriter(const std::vector<std::string>& names)
+{
+    size_t values_offset = sizeof(StatisticsSegmentHeader)
+                           + names.size() * name_slot_size;
+    values_offset = (values_offset + 7) & ~((size_t) 7);
+    size = values_offset + names.size() * sizeof(std::atomic<int64_t>);
+
+    void *addr = nullptr;
+    try
+    {
+        fd = sealed_memfd_create_shared("openvpn3-statistics", size, &addr);
+    }
+    catch (const SealedMemfdException& excp)
+    {
+        throw StatisticsSegmentException(excp.what());
+    }
+
+    // The memfd is zero filled, which is a valid initial state of
+    // all the atomic counters
+    header = static_cast<StatisticsSegmentHeader *>(addr);
+    header->magic = StatisticsSegmentHeader::MAGIC;
+    header->version = StatisticsSegmentHeader::VERSION;
+    header->name_size = name_slot_size;
+    header->count = names.size();
+    header->values_offset = values_offset;
+
+    char *slot = static_cast<char *>(addr) + sizeof(StatisticsSegmentHeader);
+    for (const auto& n : names)
+    {
+        strncpy(slot, n.c_str(), name_slot_size - 1);
+        slot += name_slot_size;
+    }
+    values = reinterpret_cast<std::atomic<int64_t> *>(
+                     static_cast<char *>(addr) + values_offset);
+}
+
+
+StatisticsSegmentWriter::~StatisticsSegmentWriter()
+{
+    munmap(header, size);
+    close(fd);
+}
+
+
+void StatisticsSegmentWriter::Update(const std::vector<long long>& newvalues,
+                                     int64_t timestamp)
+{
+    uint64_t seq = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t count = std::min((size_t) header->count, newvalues.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i].store(newvalues[i], std::memory_order_relaxed);
+    }
+    header->timestamp.store(timestamp, std::memory_order_relaxed);
+
+    header->sequence.store(seq + 2, std::memory_order_release);
+}
+
+
+int StatisticsSegmentWriter::GetReaderFD() const
+{
+    try
+    {
+        return sealed_memfd_reopen_readonly(fd);
+    }
+    catch (const SealedMemfdException& excp)
+    {
+        throw StatisticsSegmentException(excp.what());
+    }
+}
+
+
+
+StatisticsSegmentReader::StatisticsSegmentReader(int fd)
+{
+    const void *addr = nullptr;
+    try
+    {
+        addr = sealed_memfd_map_readonly(fd, sizeof(StatisticsSegmentHeader),
+                                         max_segment_size, size);
+    }
+    catch (const SealedMemfdException& excp)
+    {
+        throw StatisticsSegmentException(excp.what());
+    }
+    header = static_cast<const StatisticsSegmentHeader *>(addr);
+
+    // The header fields outside the sequence lock are written once,
+    // before the segment is handed out to any reader
+    size_t names_end = sizeof(StatisticsSegmentHeader)
+                       + (size_t) header->count * header->name_size;
+    if (StatisticsSegmentHeader::MAGIC != header->magic
+        || StatisticsSegmentHeader::VERSION != header->version
+        || 0 == header->name_size
+        || 0 != header->values_offset % 8
+        || names_end > header->values_offset
+        || size < header->values_offset
+                  + (size_t) header->count * sizeof(std::atomic<int64_t>))
+    {
+        munmap(const_cast<void *>(addr), size);
+        throw StatisticsSegmentException("Invalid statistics segment");
+    }
+
+    const char *slot = static_cast<const char *>(addr)
+                       + sizeof(StatisticsSegmentHeader);
+    for (uint32_t i = 0; i < header->count; ++i)
+    {
+        names.push_back(std::string(slot, strnlen(slot, header->name_size)));
+        slot += header->name_size;
+    }
+    values = reinterpret_cast<const std::atomic<int64_t> *>(
+                     static_cast<const char *>(addr) + header->values_offset);
+}
+
+
+StatisticsSegmentReader::~StatisticsSegmentReader()
+{
+    munmap(const_cast<StatisticsSegmentHeader *>(header), size);
+}
+
+
+const std::vector<std::string>& StatisticsSegmentReader::GetNames() const
+{
+    return names;
+}
+
+
+StatisticsSegmentSnapshot StatisticsSegmentReader::Read() const
+{
+    StatisticsSegmentSnapshot snap;
+    snap.values.resize(names.size());
+
+    for (unsigned int attempt = 0; attempt < max_read_attempts; ++attempt)
+    {
+        uint64_t seq = header->sequence.load(std::memory_order_acquire);
+        if (1 == (seq & 1))
+        {
+            sched_yield();
+            continue;
+        }
+
+        for (size_t i = 0; i < snap.values.size(); ++i)
+        {
+            snap.values[i] = values[i].load(std::memory_order_relaxed);
+        }
+        snap.timestamp = header->timestamp.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) == seq)
+        {
+            snap.sequence = seq / 2;
+            return snap;
+        }
+    }
+    throw StatisticsSegmentException("The statistics segment is not updated "
+                                     "consistently");
+}
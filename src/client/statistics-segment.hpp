@@ -0,0 +1,186 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-segment.hpp
+ *
+ * @brief  Connection statistics published in a shared memory segment,
+ *         which can be read without any D-Bus calls
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+
+class StatisticsSegmentException : public std::exception
+{
+public:
+    StatisticsSegmentException(const std::string& msg) : message(msg)
+    {
+    }
+
+    const char* what() const noexcept
+    {
+        return message.c_str();
+    }
+
+private:
+    std::string message{};
+};
+
+
+/**
+ *  The fixed header at the start of a statistics segment.
+ *
+ *  The segment layout is:
+ *
+ *     StatisticsSegmentHeader
+ *     char names[count][name_size]    counter names, NUL terminated
+ *     std::atomic<int64_t> values[count]
+ *
+ *  The values and the timestamp are protected by a sequence lock.  The
+ *  writer makes the sequence number odd while it updates the values and
+ *  even again when done, so a reader knows its copy is consistent if it
+ *  read the same even sequence number before and after copying them.
+ */
+struct StatisticsSegmentHeader
+{
+    static const uint32_t MAGIC = 0x5333564f;   ///< "OV3S", little endian
+    static const uint16_t VERSION = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t name_size;          ///< Size of each counter name slot
+    uint32_t count;              ///< Number of counters
+    uint32_t values_offset;      ///< Offset of the values from the start
+    std::atomic<uint64_t> sequence;
+    std::atomic<int64_t> timestamp; ///< Update time, CLOCK_MONOTONIC usecs
+};
+
+
+/**
+ *  A consistent copy of the counters in a statistics segment
+ */
+struct StatisticsSegmentSnapshot
+{
+    uint64_t sequence = 0;      ///< Sequence number, increases on updates
+    int64_t timestamp = 0;      ///< Update time, CLOCK_MONOTONIC usecs.
+                                ///< 0 if the counters were never updated
+    std::vector<long long> values;
+};
+
+
+/**
+ *  Creates a statistics segment and updates its counters.  This is used
+ *  by the backend client process, which is the only writer.  Readers
+ *  are given read-only file descriptors to the segment.
+ */
+class StatisticsSegmentWriter
+{
+public:
+    /**
+     *  Creates the segment.  The set of counters is fixed for the
+     *  lifetime of the segment.
+     *
+     * @param names  std::vector<std::string> with the counter names.
+     *               Names longer than the name slots are truncated.
+     *
+     * @throws StatisticsSegmentException on errors
+     */
+    StatisticsSegmentWriter(const std::vector<std::string>& names);
+    ~StatisticsSegmentWriter();
+
+    StatisticsSegmentWriter(const StatisticsSegmentWriter&) = delete;
+    StatisticsSegmentWriter& operator=(const StatisticsSegmentWriter&) = delete;
+
+    /**
+     *  Updates the counters.  Readers never see a partial update.
+     *
+     * @param values     std::vector<long long> with the counter values, in
+     *                   the order of the names given to the constructor.
+     *                   Any extra values are ignored.
+     * @param timestamp  Update time, CLOCK_MONOTONIC usecs
+     */
+    void Update(const std::vector<long long>& values, int64_t timestamp);
+
+    /**
+     * @return Returns a new read-only file descriptor of the segment to
+     *         pass to a reader.  The caller is responsible for closing it.
+     *
+     * @throws StatisticsSegmentException on errors
+     */
+    int GetReaderFD() const;
+
+private:
+    int fd = -1;
+    size_t size = 0;
+    StatisticsSegmentHeader *header = nullptr;
+    std::atomic<int64_t> *values = nullptr;
+};
+
+
+/**
+ *  Maps a statistics segment read-only and takes consistent snapshots
+ *  of its counters.
+ */
+class StatisticsSegmentReader
+{
+public:
+    /**
+     *  Maps the segment and validates its header
+     *
+     * @param fd  File descriptor of the segment, as retrieved from the
+     *            backend.  It is not closed and can be closed as soon as
+     *            the constructor returns.
+     *
+     * @throws StatisticsSegmentException if the segment is not usable
+     */
+    StatisticsSegmentReader(int fd);
+    ~StatisticsSegmentReader();
+
+    StatisticsSegmentReader(const StatisticsSegmentReader&) = delete;
+    StatisticsSegmentReader& operator=(const StatisticsSegmentReader&) = delete;
+
+    /**
+     * @return Returns the counter names, in the order of the values
+     */
+    const std::vector<std::string>& GetNames() const;
+
+    /**
+     *  Copies the counters, retrying while the writer is updating them
+     *
+     * @return Returns a StatisticsSegmentSnapshot with the counters
+     *
+     * @throws StatisticsSegmentException if no consistent copy could be
+     *         made, which only happens if the writer crashed during an
+     *         update
+     */
+    StatisticsSegmentSnapshot Read() const;
+
+private:
+    size_t size = 0;
+    const StatisticsSegmentHeader *header = nullptr;
+    const std::atomic<int64_t> *values = nullptr;
+    std::vector<std::string> names;
+};
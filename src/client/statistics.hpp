@@ -51,4 +51,18 @@ struct ConnectionStatDetails
  */
 typedef std::vector<ConnectionStatDetails> ConnectionStats;
 
+
+/**
+ *  Connection statistics of a single session, as retrieved from the
+ *  session manager together with the statistics of all other sessions
+ */
+struct SessionStatistics
+{
+    std::string session_path;
+    std::string config_name;
+    std::string device_name;
+    long long timestamp;    ///< Sample time, usecs since epoch. 0 if unavailable
+    ConnectionStats stats;
+};
+
 #endif // OPENVPN3_DBUS_CLIENT_STATISTICS
@@ -0,0 +1,210 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   atomic-file.cpp
+ *
+ * @brief  Crash-safe replacement of file contents
+ */
+
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "atomic-file.hpp"
+
+
+static std::string errmsg(const std::string& msg, const std::string& fname)
+{
+    return msg + " '" + fname + "': " + std::string(strerror(errno));
+}
+
+
+/**
+ *  Suffix added to the file name of the temporary files.  mkstemp()
+ *  replaces the X characters with [A-Za-z0-9].
+ */
+static const std::string tmp_suffix = ".tmp.XXXXXX";
+
+
+/**
+ *  Follows a chain of symbolic links to the file it ends at.  The
+ *  final file does not need to exist.
+ *
+ * @param fname  std::string with the file name to resolve
+ *
+ * @return  Returns the file name rename() needs to replace to update
+ *          the file fname refers to
+ */
+static std::string resolve_symlinks(const std::string& fname)
+{
+    std::string path = fname;
+
+    // Same limit as the kernel uses for path resolution
+    for (int i = 0; i < 40; ++i)
+    {
+        struct stat st;
+        if (0 != lstat(path.c_str(), &st) || !S_ISLNK(st.st_mode))
+        {
+            return path;
+        }
+
+        char target[PATH_MAX];
+        ssize_t len = readlink(path.c_str(), target, sizeof(target) - 1);
+        if (0 > len)
+        {
+            throw AtomicFileException(errmsg("Could not resolve", path));
+        }
+        target[len] = '\0';
+
+        if ('/' == target[0])
+        {
+            path = std::string(target);
+        }
+        else
+        {
+            // Relative links are relative to the directory of the link
+            std::string::size_type slash = path.rfind('/');
+            path = (std::string::npos == slash ? std::string(target)
+                    : path.substr(0, slash + 1) + std::string(target));
+        }
+    }
+    errno = ELOOP;
+    throw AtomicFileException(errmsg("Could not resolve", fname));
+}
+
+
+void write_file_atomic(const std::string& fname_arg, const std::string& data)
+{
+    // Replacing a symbolic link would detach it from its target
+    std::string fname = resolve_symlinks(fname_arg);
+
+    // mkstemp() modifies the template, so it needs a writable buffer
+    std::string tmpl = fname + tmp_suffix;
+    std::vector<char> tmpname(tmpl.begin(), tmpl.end());
+    tmpname.push_back('\0');
+
+    int fd = mkstemp(tmpname.data());
+    if (-1 == fd)
+    {
+        throw AtomicFileException(errmsg("Could not create temporary file for",
+                                         fname));
+    }
+
+    const char *p = data.data();
+    size_t left = data.size();
+    while (left > 0)
+    {
+        ssize_t r = write(fd, p, left);
+        if (0 > r)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            std::string err = errmsg("Could not write", tmpname.data());
+            close(fd);
+            unlink(tmpname.data());
+            throw AtomicFileException(err);
+        }
+        p += r;
+        left -= r;
+    }
+
+    if (0 != fsync(fd))
+    {
+        std::string err = errmsg("Could not flush", tmpname.data());
+        close(fd);
+        unlink(tmpname.data());
+        throw AtomicFileException(err);
+    }
+    close(fd);
+
+    if (0 != std::rename(tmpname.data(), fname.c_str()))
+    {
+        std::string err = errmsg("Could not replace", fname);
+        unlink(tmpname.data());
+        throw AtomicFileException(err);
+    }
+
+    // Make the rename persistent as well
+    std::string::size_type slash = fname.rfind('/');
+    std::string dir = (std::string::npos == slash ? std::string(".")
+                       : fname.substr(0, (0 == slash ? 1 : slash)));
+    int dirfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (-1 != dirfd)
+    {
+        (void) fsync(dirfd);
+        close(dirfd);
+    }
+}
+
+
+/**
+ *  Checks if a file name looks like a write_file_atomic() temporary file
+ */
+static bool is_atomic_tempfile(const std::string& fname)
+{
+    size_t rnd = tmp_suffix.size() - 6;
+    if (fname.size() <= tmp_suffix.size()
+        || 0 != fname.compare(fname.size() - tmp_suffix.size(), rnd,
+                              tmp_suffix, 0, rnd))
+    {
+        return false;
+    }
+    for (size_t i = fname.size() - 6; i < fname.size(); ++i)
+    {
+        if (!isalnum(static_cast<unsigned char>(fname[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+size_t remove_stale_atomic_files(const std::string& dir)
+{
+    DIR *dirfd = opendir(dir.c_str());
+    if (nullptr == dirfd)
+    {
+        return 0;
+    }
+
+    size_t removed = 0;
+    struct dirent *entry = nullptr;
+    while (nullptr != (entry = readdir(dirfd)))
+    {
+        std::string fname(entry->d_name);
+        if (is_atomic_tempfile(fname)
+            && 0 == unlink((dir + "/" + fname).c_str()))
+        {
+            ++removed;
+        }
+    }
+    closedir(dirfd);
+    return removed;
+}
@@ -0,0 +1,82 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   atomic-file.hpp
+ *
+ * @brief  Crash-safe replacement of file contents
+ */
+
+#pragma once
+
+#include <exception>
+#include <string>
+
+
+class AtomicFileException : public std::exception
+{
+public:
+    AtomicFileException(const std::string& msg) : message(msg)
+    {
+    }
+
+    const char* what() const noexcept
+    {
+        return message.c_str();
+    }
+
+private:
+    std::string message{};
+};
+
+
+/**
+ *  Replaces the contents of a file in a way which ensures the file
+ *  either contains the old or the new contents, also if the process or
+ *  the system crashes while writing.
+ *
+ *  The data is written to a temporary file in the same directory, which
+ *  is flushed to disk with fsync() before it is renamed to the final
+ *  file name.  The directory is flushed afterwards, so the rename itself
+ *  is persistent as well.  The file is always created with mode 0600,
+ *  as mkstemp() does.
+ *
+ *  If fname is a symbolic link, the file the link points at is replaced
+ *  and the link itself is kept.
+ *
+ * @param fname  std::string with the file name to write
+ * @param data   std::string with the new file contents
+ *
+ * @throws AtomicFileException on errors.  The original file is left
+ *         untouched in this case.
+ */
+void write_file_atomic(const std::string& fname, const std::string& data);
+
+
+/**
+ *  Removes temporary files write_file_atomic() left behind in a
+ *  directory, if the process crashed before it could rename them.
+ *  This should only be called before any writes to this directory
+ *  are started.
+ *
+ * @param dir  std::string with the directory to clean up
+ *
+ * @return  Returns the number of files removed
+ */
+size_t remove_stale_atomic_files(const std::string& dir);
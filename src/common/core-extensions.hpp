@@ -39,7 +39,7 @@ namespace openvpn {
                 || (optname == "tls-crypt")) ? true : false;
     }
 
-    std::string optparser_mkline(std::string optname, std::string optvalue)
+    inline std::string optparser_mkline(std::string optname, std::string optvalue)
     {
         bool inlined_file = optparser_inline_file(optname);
         std::stringstream ret;
@@ -87,7 +87,7 @@ namespace openvpn {
             return outdata;
         }
 
-        std::string string_export()
+        std::string string_export() const
         {
             std::stringstream cfgstr;
 
@@ -0,0 +1,146 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   pidfd-watch.hpp
+ *
+ * @brief  Watches a process for its exit from the GLib main loop, using
+ *         a pidfd
+ */
+
+#pragma once
+
+#include <csignal>
+#include <functional>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <glib.h>
+#include <glib-unix.h>
+
+
+/**
+ *  Calls a function when a process exits.  The process is referenced by
+ *  a pidfd, which becomes readable when the process exits and is watched
+ *  from the thread-default main context of the thread creating the
+ *  PidfdWatch.
+ *
+ *  Unlike waitpid(), this never blocks and works for processes which are
+ *  not children of the calling process.  Unlike kill(), signals sent with
+ *  Kill() can never reach another process which reused the PID.  Child
+ *  processes are not reaped; the exit callback should call waitpid().
+ *
+ *  pidfds require Linux 5.3 or newer.  On older kernels, Active() returns
+ *  false and the exit callback is never called.
+ *
+ *  The watch may be deleted from within its own callback.
+ *
+ *  A PID looked up earlier may have been reused by another process
+ *  before the pidfd is opened.  The caller must verify the watched
+ *  process afterwards, for example by checking that the PID still owns
+ *  the same D-Bus connection.
+ */
+class PidfdWatch
+{
+public:
+    typedef std::function<void()> ExitCallback;
+
+    /**
+     * @param pid     Process ID of the process to watch
+     * @param exited  Called when the process has exited
+     */
+    PidfdWatch(pid_t pid, ExitCallback exited)
+        : pid(pid), exited(exited)
+    {
+#ifdef SYS_pidfd_open
+        pidfd = syscall(SYS_pidfd_open, pid, 0);
+#endif
+        if (0 <= pidfd)
+        {
+            source = g_unix_fd_source_new(pidfd, G_IO_IN);
+            g_source_set_callback(source, (GSourceFunc) process_exited,
+                                  this, nullptr);
+            g_source_attach(source, g_main_context_get_thread_default());
+        }
+    }
+
+    ~PidfdWatch()
+    {
+        if (source)
+        {
+            g_source_destroy(source);
+            g_source_unref(source);
+        }
+        if (0 <= pidfd)
+        {
+            close(pidfd);
+        }
+    }
+
+    PidfdWatch(const PidfdWatch&) = delete;
+    PidfdWatch& operator=(const PidfdWatch&) = delete;
+
+
+    /**
+     * @return Returns true if the process is watched
+     */
+    bool Active() const
+    {
+        return 0 <= pidfd;
+    }
+
+
+    /**
+     *  Sends a signal to the process
+     *
+     * @param sig  Signal to send
+     *
+     * @return Returns true if the signal was sent
+     */
+    bool Kill(int sig) const
+    {
+#ifdef SYS_pidfd_send_signal
+        if (0 <= pidfd)
+        {
+            return 0 == syscall(SYS_pidfd_send_signal, pidfd, sig,
+                                nullptr, 0);
+        }
+#endif
+        return 0 == kill(pid, sig);
+    }
+
+
+private:
+    pid_t pid;
+    ExitCallback exited;
+    int pidfd = -1;
+    GSource *source = nullptr;
+
+
+    static gboolean process_exited(gint fd, GIOCondition cond,
+                                   gpointer user_data)
+    {
+        // The callback may delete the watch
+        ExitCallback cb = static_cast<PidfdWatch *>(user_data)->exited;
+        if (cb)
+        {
+            cb();
+        }
+        return G_SOURCE_REMOVE;
+    }
+};
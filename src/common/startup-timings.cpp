@@ -0,0 +1,237 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+/**
+ * @file   startup-timings.cpp
+ *
+ * @brief  Timestamps of the phases of a session start, from the NewTunnel
+ *         call until the tunnel is connected, and histograms of the phase
+ *         durations across sessions
+ */
+
+#include <cstring>
+
+#include "startup-timings.hpp"
+
+
+const size_t StartupTimings::PHASES;
+const size_t StartupTimingHistograms::BUCKETS;
+
+static const char *phase_names[StartupTimings::PHASES] = {
+    "new_tunnel",
+    "backend_spawn",
+    "bus_registration",
+    "registration_confirmation",
+    "config_fetch",
+    "profile_evaluation",
+    "credential_queue",
+    "tls_handshake",
+    "netcfg_establish",
+    "dns_commit"
+};
+
+
+StartupTimings::StartupTimings(const StartupTimings& orig)
+{
+    std::lock_guard<std::mutex> lock(orig.mtx);
+    phases = orig.phases;
+}
+
+
+StartupTimings& StartupTimings::operator=(const StartupTimings& orig)
+{
+    if (this != &orig)
+    {
+        std::lock(mtx, orig.mtx);
+        std::lock_guard<std::mutex> lock(mtx, std::adopt_lock);
+        std::lock_guard<std::mutex> lock_orig(orig.mtx, std::adopt_lock);
+        phases = orig.phases;
+    }
+    return *this;
+}
+
+
+StartupTimings::StartupTimings(GVariant *timings)
+{
+    GVariantIter *list = nullptr;
+    g_variant_get(timings, "a(sxx)", &list);
+
+    const gchar *name = nullptr;
+    gint64 begin = 0;
+    gint64 end = 0;
+    while (g_variant_iter_next(list, "(&sxx)", &name, &begin, &end))
+    {
+        for (size_t i = 0; i < PHASES; ++i)
+        {
+            if (0 == strcmp(name, phase_names[i]))
+            {
+                phases[i].begin = begin;
+                phases[i].end = end;
+                break;
+            }
+        }
+    }
+    g_variant_iter_free(list);
+}
+
+
+const char * StartupTimings::PhaseName(const StartupPhase phase)
+{
+    return phase_names[static_cast<size_t>(phase)];
+}
+
+
+void StartupTimings::Begin(const StartupPhase phase, const int64_t now)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    StartupPhaseTiming& p = phases[static_cast<size_t>(phase)];
+    if (0 == p.begin)
+    {
+        p.begin = now;
+    }
+}
+
+
+void StartupTimings::End(const StartupPhase phase, const int64_t now)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    StartupPhaseTiming& p = phases[static_cast<size_t>(phase)];
+    if (0 < p.begin && 0 == p.end)
+    {
+        p.end = now;
+    }
+}
+
+
+void StartupTimings::Set(const StartupPhase phase,
+                         const int64_t begin, const int64_t end)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    StartupPhaseTiming& p = phases[static_cast<size_t>(phase)];
+    if (0 == p.begin)
+    {
+        p.begin = begin;
+        p.end = end;
+    }
+}
+
+
+void StartupTimings::Merge(const StartupTimings& other)
+{
+    for (const auto& p : other.GetPhases())
+    {
+        Set(p.phase, p.begin, p.end);
+    }
+}
+
+
+std::vector<StartupPhaseTiming> StartupTimings::GetPhases() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<StartupPhaseTiming> ret;
+    for (size_t i = 0; i < PHASES; ++i)
+    {
+        if (0 < phases[i].begin)
+        {
+            ret.push_back({static_cast<StartupPhase>(i),
+                           phases[i].begin, phases[i].end});
+        }
+    }
+    return ret;
+}
+
+
+GVariant * StartupTimings::GetGVariant() const
+{
+    GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a(sxx)"));
+    for (const auto& p : GetPhases())
+    {
+        g_variant_builder_add(b, "(sxx)", PhaseName(p.phase),
+                              (gint64) p.begin, (gint64) p.end);
+    }
+    GVariant *ret = g_variant_builder_end(b);
+    g_variant_builder_unref(b);
+    return ret;
+}
+
+
+
+void StartupTimingHistograms::Add(const StartupTimings& timings)
+{
+    for (const auto& p : timings.GetPhases())
+    {
+        int64_t duration = p.Duration();
+        if (0 > duration)
+        {
+            continue;
+        }
+
+        Histogram& h = histograms[static_cast<size_t>(p.phase)];
+        size_t bucket = 0;
+        while (BUCKETS - 1 > bucket && duration >= BucketLimit(bucket))
+        {
+            ++bucket;
+        }
+        ++h.buckets[bucket];
+        ++h.count;
+        h.sum += duration;
+    }
+}
+
+
+int64_t StartupTimingHistograms::BucketLimit(const size_t bucket)
+{
+    return (BUCKETS - 1 > bucket ? (int64_t(1) << bucket) * 1000 : -1);
+}
+
+
+uint64_t StartupTimingHistograms::Count(const StartupPhase phase) const
+{
+    return histograms[static_cast<size_t>(phase)].count;
+}
+
+
+uint64_t StartupTimingHistograms::BucketCount(const StartupPhase phase,
+                                              const size_t bucket) const
+{
+    return histograms[static_cast<size_t>(phase)].buckets.at(bucket);
+}
+
+
+GVariant * StartupTimingHistograms::GetGVariant() const
+{
+    GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a(sttat)"));
+    for (size_t i = 0; i < StartupTimings::PHASES; ++i)
+    {
+        const Histogram& h = histograms[i];
+        GVariantBuilder *bb = g_variant_builder_new(G_VARIANT_TYPE("at"));
+        for (const auto& c : h.buckets)
+        {
+            g_variant_builder_add(bb, "t", (guint64) c);
+        }
+        g_variant_builder_add(b, "(sttat)",
+                              StartupTimings::PhaseName(static_cast<StartupPhase>(i)),
+                              (guint64) h.count, (guint64) h.sum, bb);
+        g_variant_builder_unref(bb);
+    }
+    GVariant *ret = g_variant_builder_end(b);
+    g_variant_builder_unref(b);
+    return ret;
+}
@@ -0,0 +1,234 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+/**
+ * @file   startup-timings.hpp
+ *
+ * @brief  Timestamps of the phases of a session start, from the NewTunnel
+ *         call until the tunnel is connected, and histograms of the phase
+ *         durations across sessions
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glib.h>
+
+
+/**
+ *  The phases of a session start.  The phases are recorded by both the
+ *  session manager and the backend client process; some phases contain
+ *  other phases.
+ */
+enum class StartupPhase : uint8_t
+{
+    NEW_TUNNEL,                ///< Session manager NewTunnel call
+    BACKEND_SPAWN,             ///< StartClient call to the backend starter
+    BUS_REGISTRATION,          ///< Until the backend owns its bus name
+    REGISTRATION_CONFIRMATION, ///< RegistrationConfirmation call
+    CONFIG_FETCH,              ///< Backend retrieves the profile
+    PROFILE_EVALUATION,        ///< Backend evaluates the profile
+    CREDENTIAL_QUEUE,          ///< Until all user input is provided
+    TLS_HANDSHAKE,             ///< Until the server configuration is pulled
+    NETCFG_ESTABLISH,          ///< net.openvpn.v3.netcfg Establish call
+    DNS_COMMIT                 ///< DNS settings applied by Establish
+};
+
+
+/**
+ *  The begin and end of a single startup phase, as CLOCK_MONOTONIC
+ *  timestamps in microseconds.  The monotonic clock is shared by all
+ *  processes, so timestamps from different processes can be compared.
+ */
+struct StartupPhaseTiming
+{
+    StartupPhase phase;
+    int64_t begin;         ///< 0 if the phase has not started
+    int64_t end;           ///< 0 if the phase has not completed
+
+    /**
+     * @return Returns the duration of a completed phase in microseconds,
+     *         otherwise -1
+     */
+    int64_t Duration() const noexcept
+    {
+        return (0 < begin && begin <= end ? end - begin : -1);
+    }
+};
+
+
+/**
+ *  Records when each phase of a session start began and ended.  Only the
+ *  first occurrence of each phase is recorded, so phases repeated later
+ *  on, for example on a reconnect, do not change the recorded timings.
+ *
+ *  All methods are thread safe.
+ */
+class StartupTimings
+{
+public:
+    static const size_t PHASES = 10;
+
+    StartupTimings() = default;
+    StartupTimings(const StartupTimings& orig);
+    StartupTimings& operator=(const StartupTimings& orig);
+
+    /**
+     *  Restores the timings from a GVariant created by GetGVariant().
+     *  Unknown phase names are ignored.
+     *
+     * @param timings  GVariant a(sxx) array
+     */
+    StartupTimings(GVariant *timings);
+
+    /**
+     * @param phase  StartupPhase to look up
+     *
+     * @return Returns the name of the phase, as used in GetGVariant()
+     */
+    static const char * PhaseName(const StartupPhase phase);
+
+    /**
+     *  Records the start of a phase
+     *
+     * @param phase  StartupPhase which started
+     * @param now    Monotonic timestamp in microseconds
+     */
+    void Begin(const StartupPhase phase, const int64_t now);
+    void Begin(const StartupPhase phase)
+    {
+        Begin(phase, g_get_monotonic_time());
+    }
+
+    /**
+     *  Records the end of a phase.  This is ignored if the phase has not
+     *  started.
+     *
+     * @param phase  StartupPhase which completed
+     * @param now    Monotonic timestamp in microseconds
+     */
+    void End(const StartupPhase phase, const int64_t now);
+    void End(const StartupPhase phase)
+    {
+        End(phase, g_get_monotonic_time());
+    }
+
+    /**
+     *  Records a phase measured elsewhere, unless it is already recorded
+     *
+     * @param phase  StartupPhase to record
+     * @param begin  Monotonic timestamp of the start, in microseconds
+     * @param end    Monotonic timestamp of the end, in microseconds
+     */
+    void Set(const StartupPhase phase, const int64_t begin, const int64_t end);
+
+    /**
+     *  Adds the phases recorded by another process.  Phases which are
+     *  already recorded are kept.
+     *
+     * @param other  StartupTimings to merge with
+     */
+    void Merge(const StartupTimings& other);
+
+    /**
+     * @return Returns all the phases which have started, in StartupPhase
+     *         order
+     */
+    std::vector<StartupPhaseTiming> GetPhases() const;
+
+    /**
+     * @return Returns the timings as a GVariant a(sxx) array with the
+     *         phase name and the begin and end timestamps of all the
+     *         phases which have started
+     */
+    GVariant * GetGVariant() const;
+
+
+private:
+    mutable std::mutex mtx;
+    std::array<StartupPhaseTiming, PHASES> phases = {};
+};
+
+
+/**
+ *  Histograms of the durations of each startup phase, collected from
+ *  all the sessions started by the session manager.
+ *
+ *  The bucket limits grow exponentially; bucket N counts durations below
+ *  2^N milliseconds, and the last bucket counts everything longer.
+ */
+class StartupTimingHistograms
+{
+public:
+    static const size_t BUCKETS = 16;
+
+    /**
+     *  Adds the durations of all the completed phases of a session start
+     *
+     * @param timings  StartupTimings of a single session
+     */
+    void Add(const StartupTimings& timings);
+
+    /**
+     * @param bucket  Bucket index
+     *
+     * @return Returns the upper limit of a bucket in microseconds, or -1
+     *         for the last bucket which has no upper limit
+     */
+    static int64_t BucketLimit(const size_t bucket);
+
+    /**
+     * @param phase  StartupPhase to look up
+     *
+     * @return Returns the number of recorded durations of the phase
+     */
+    uint64_t Count(const StartupPhase phase) const;
+
+    /**
+     * @param phase   StartupPhase to look up
+     * @param bucket  Bucket index
+     *
+     * @return Returns the number of durations of a phase in a bucket
+     */
+    uint64_t BucketCount(const StartupPhase phase, const size_t bucket) const;
+
+    /**
+     * @return Returns the histograms as a GVariant a(sttat) array with
+     *         the phase name, the number of recorded durations, the sum
+     *         of the durations in microseconds and the bucket counts of
+     *         each phase
+     */
+    GVariant * GetGVariant() const;
+
+
+private:
+    struct Histogram
+    {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        std::array<uint64_t, BUCKETS> buckets = {};
+    };
+
+    std::array<Histogram, StartupTimings::PHASES> histograms;
+};
@@ -0,0 +1,339 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   blob-store.cpp
+ *
+ * @brief  Content addressed, reference counted storage of large inline
+ *         configuration profile payloads (certificates, keys, etc)
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/atomic-file.hpp"
+#include "blob-store.hpp"
+
+
+/**
+ *  Calculates the base blob ID of a payload: the 64-bit FNV-1a hash and
+ *  the length, both in hexadecimal
+ */
+static std::string blob_id(const std::string& data)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char c : data)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    std::stringstream id;
+    id << std::hex;
+    id.width(16);
+    id.fill('0');
+    id << hash << "-" << data.size();
+    return id.str();
+}
+
+
+/**
+ *  Blob IDs are used as file names, so only accept IDs which could have
+ *  been generated by blob_id()
+ */
+static void check_id(const std::string& id)
+{
+    if (id.empty()
+        || std::string::npos != id.find_first_not_of("0123456789abcdef-"))
+    {
+        throw InlineBlobStoreException("Invalid blob ID '" + id + "'");
+    }
+}
+
+
+void InlineBlobStore::SetDirectory(const std::string& dir)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (0 != mkdir(dir.c_str(), 0700) && EEXIST != errno)
+    {
+        throw InlineBlobStoreException("Could not create '" + dir + "': "
+                                       + std::string(strerror(errno)));
+    }
+    directory = dir;
+}
+
+
+std::string InlineBlobStore::Add(const std::string& data)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::string base = blob_id(data);
+
+    // On a hash collision, the payload is stored with a numbered
+    // suffix on the blob ID
+    for (unsigned int n = 0; ; ++n)
+    {
+        std::string id = (0 == n ? base : base + "-" + std::to_string(n));
+        auto it = blobs.find(id);
+        if (blobs.end() == it)
+        {
+            Blob& blob = blobs[id];
+            blob.data = data;
+            blob.loaded = true;
+            blob.refcount = 1;
+            return id;
+        }
+
+        Blob& blob = it->second;
+        try
+        {
+            load(id, blob);
+        }
+        catch (const InlineBlobStoreException&)
+        {
+            // The persisted blob is unusable; store the payload
+            // under a different ID instead
+            continue;
+        }
+        if (blob.data == data)
+        {
+            ++blob.refcount;
+            return id;
+        }
+    }
+}
+
+
+void InlineBlobStore::Ref(const std::string& id)
+{
+    check_id(id);
+    std::lock_guard<std::mutex> lock(mtx);
+    Blob& blob = blobs[id];
+    blob.on_disk = true;
+    ++blob.refcount;
+}
+
+
+void InlineBlobStore::Release(const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = blobs.find(id);
+    if (blobs.end() == it)
+    {
+        return;
+    }
+
+    if (0 < it->second.refcount)
+    {
+        --it->second.refcount;
+    }
+    if (0 == it->second.refcount)
+    {
+        if (it->second.on_disk && !directory.empty())
+        {
+            unlink(blob_file(id).c_str());
+        }
+        blobs.erase(it);
+    }
+}
+
+
+std::string InlineBlobStore::Get(const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = blobs.find(id);
+    if (blobs.end() == it)
+    {
+        throw InlineBlobStoreException("Unknown blob ID '" + id + "'");
+    }
+    load(id, it->second);
+    return it->second.data;
+}
+
+
+void InlineBlobStore::Persist(const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (directory.empty())
+    {
+        throw InlineBlobStoreException("No blob directory configured");
+    }
+    auto it = blobs.find(id);
+    if (blobs.end() == it)
+    {
+        throw InlineBlobStoreException("Unknown blob ID '" + id + "'");
+    }
+    if (it->second.on_disk)
+    {
+        return;
+    }
+
+    try
+    {
+        write_file_atomic(blob_file(id), it->second.data);
+    }
+    catch (const AtomicFileException& excp)
+    {
+        throw InlineBlobStoreException(excp.what());
+    }
+    it->second.on_disk = true;
+}
+
+
+size_t InlineBlobStore::Prune()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (directory.empty())
+    {
+        return 0;
+    }
+
+    DIR *dirfd = opendir(directory.c_str());
+    if (nullptr == dirfd)
+    {
+        return 0;
+    }
+
+    size_t removed = 0;
+    struct dirent *entry = nullptr;
+    while (nullptr != (entry = readdir(dirfd)))
+    {
+        std::string fname(entry->d_name);
+        if ("." == fname || ".." == fname
+            || blobs.end() != blobs.find(fname))
+        {
+            continue;
+        }
+        if (0 == unlink(blob_file(fname).c_str()))
+        {
+            ++removed;
+        }
+    }
+    closedir(dirfd);
+    return removed;
+}
+
+
+size_t InlineBlobStore::size() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return blobs.size();
+}
+
+
+size_t InlineBlobStore::MemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    size_t ret = 0;
+    for (const auto& it : blobs)
+    {
+        ret += it.second.data.size();
+    }
+    return ret;
+}
+
+
+unsigned int InlineBlobStore::RefCount(const std::string& id) const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = blobs.find(id);
+    return (blobs.end() != it ? it->second.refcount : 0);
+}
+
+
+std::string InlineBlobStore::blob_file(const std::string& id) const
+{
+    return directory + "/" + id;
+}
+
+
+void InlineBlobStore::load(const std::string& id, Blob& blob)
+{
+    if (blob.loaded)
+    {
+        return;
+    }
+    if (directory.empty())
+    {
+        throw InlineBlobStoreException("Blob '" + id + "' is not available");
+    }
+
+    std::ifstream f(blob_file(id), std::ifstream::binary);
+    if (!f.is_open())
+    {
+        throw InlineBlobStoreException("Could not open '" + blob_file(id)
+                                       + "'");
+    }
+    std::stringstream data;
+    data << f.rdbuf();
+    blob.data = data.str();
+    blob.loaded = true;
+}
+
+
+InlineBlobRefs::~InlineBlobRefs()
+{
+    Release();
+}
+
+
+InlineBlobRefs::InlineBlobRefs(InlineBlobRefs&& other) noexcept
+    : std::map<size_t, std::string>(std::move(other)),
+      store(other.store)
+{
+    other.clear();
+}
+
+
+InlineBlobRefs& InlineBlobRefs::operator=(InlineBlobRefs&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        std::map<size_t, std::string>::operator=(std::move(other));
+        store = other.store;
+        other.clear();
+    }
+    return *this;
+}
+
+
+void InlineBlobRefs::SetStore(InlineBlobStore *s) noexcept
+{
+    store = s;
+}
+
+
+void InlineBlobRefs::Release() noexcept
+{
+    if (store)
+    {
+        for (const auto& b : *this)
+        {
+            store->Release(b.second);
+        }
+    }
+    clear();
+}
@@ -0,0 +1,225 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   blob-store.hpp
+ *
+ * @brief  Content addressed, reference counted storage of large inline
+ *         configuration profile payloads (certificates, keys, etc)
+ */
+
+#pragma once
+
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+
+
+class InlineBlobStoreException : public std::exception
+{
+public:
+    InlineBlobStoreException(const std::string& msg) : message(msg)
+    {
+    }
+
+    const char* what() const noexcept
+    {
+        return message.c_str();
+    }
+
+private:
+    std::string message{};
+};
+
+
+/**
+ *  Keeps a single copy of each distinct payload, such as the contents of
+ *  an inline <ca> or <tls-crypt> block, shared by all the configuration
+ *  profiles containing it.  Each payload is identified by a blob ID
+ *  derived from its contents, which the configuration profiles store
+ *  instead of the payload itself.
+ *
+ *  The blob ID is a 64-bit FNV-1a hash and the length of the payload.
+ *  Payloads are always compared when added, so a hash collision only
+ *  results in a different blob ID.
+ *
+ *  Each blob is reference counted and removed, also from the blob
+ *  directory, when the last reference is released.  Blobs are only
+ *  written to the blob directory when Persist() is called, which must
+ *  happen before a persistent configuration referring to them is saved.
+ *
+ *  All methods are thread-safe.
+ */
+class InlineBlobStore
+{
+public:
+    InlineBlobStore() = default;
+    ~InlineBlobStore() = default;
+
+    InlineBlobStore(const InlineBlobStore&) = delete;
+    InlineBlobStore& operator=(const InlineBlobStore&) = delete;
+
+    /**
+     *  Sets the directory where persistent blobs are stored.  The
+     *  directory is created if it does not exist.
+     *
+     * @param dir  std::string with the blob directory
+     *
+     * @throws  InlineBlobStoreException if the directory cannot be created
+     */
+    void SetDirectory(const std::string& dir);
+
+    /**
+     *  Adds a reference to a payload, storing it if not already present
+     *
+     * @param data  std::string with the payload
+     *
+     * @return  Returns a std::string with the blob ID of the payload
+     */
+    std::string Add(const std::string& data);
+
+    /**
+     *  Adds a reference to an already persisted blob, without loading
+     *  it.  This is used when a persistent configuration is registered
+     *  without parsing its profile.
+     *
+     * @param id  std::string with the blob ID
+     *
+     * @throws  InlineBlobStoreException if the blob ID is invalid
+     */
+    void Ref(const std::string& id);
+
+    /**
+     *  Releases a reference to a blob.  The blob is removed when the last
+     *  reference is released.
+     *
+     * @param id  std::string with the blob ID
+     */
+    void Release(const std::string& id);
+
+    /**
+     *  Retrieve the payload of a blob, loading it from the blob directory
+     *  if needed
+     *
+     * @param id  std::string with the blob ID
+     *
+     * @return  Returns a std::string with the payload
+     *
+     * @throws  InlineBlobStoreException if the blob is unknown or cannot
+     *          be loaded
+     */
+    std::string Get(const std::string& id);
+
+    /**
+     *  Writes a blob to the blob directory, if not already done
+     *
+     * @param id  std::string with the blob ID
+     *
+     * @throws  InlineBlobStoreException if the blob is unknown or cannot
+     *          be written
+     */
+    void Persist(const std::string& id);
+
+    /**
+     *  Removes all files in the blob directory which are not referenced.
+     *  This must be called after all persistent configurations have been
+     *  registered.
+     *
+     * @return  Returns the number of removed files
+     */
+    size_t Prune();
+
+    /**
+     * @return  Returns the number of stored blobs
+     */
+    size_t size() const;
+
+    /**
+     * @return  Returns the number of payload bytes kept in memory
+     */
+    size_t MemoryUsage() const;
+
+    /**
+     * @param id  std::string with the blob ID
+     *
+     * @return  Returns the number of references to a blob, 0 if unknown
+     */
+    unsigned int RefCount(const std::string& id) const;
+
+
+private:
+    struct Blob
+    {
+        std::string data;           ///< Payload, if loaded
+        bool loaded = false;        ///< data contains the payload
+        bool on_disk = false;       ///< Blob is saved in the blob directory
+        unsigned int refcount = 0;  ///< Number of references
+    };
+
+    mutable std::mutex mtx;
+    std::string directory;
+    std::map<std::string, Blob> blobs;
+
+    std::string blob_file(const std::string& id) const;
+    void load(const std::string& id, Blob& blob);
+};
+
+
+/**
+ *  Owns references to blobs in an InlineBlobStore, indexed by the
+ *  position of the option they belong to.  The references still held
+ *  are released when this object is destroyed, so they are not leaked
+ *  if an exception is thrown before they have been handed over.
+ *  Ownership is handed over by moving the object.
+ */
+class InlineBlobRefs : public std::map<size_t, std::string>
+{
+public:
+    InlineBlobRefs() = default;
+    ~InlineBlobRefs();
+
+    InlineBlobRefs(const InlineBlobRefs&) = delete;
+    InlineBlobRefs& operator=(const InlineBlobRefs&) = delete;
+
+    InlineBlobRefs(InlineBlobRefs&& other) noexcept;
+
+    /**
+     *  Releases the references held by this object before taking over
+     *  the references held by other
+     */
+    InlineBlobRefs& operator=(InlineBlobRefs&& other) noexcept;
+
+    /**
+     *  Sets the InlineBlobStore the references belong to.  This must be
+     *  done before the first reference is added.
+     *
+     * @param store  Pointer to the InlineBlobStore
+     */
+    void SetStore(InlineBlobStore *store) noexcept;
+
+    /**
+     *  Releases all the references held by this object
+     */
+    void Release() noexcept;
+
+
+private:
+    InlineBlobStore *store = nullptr;
+};
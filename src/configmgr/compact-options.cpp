@@ -0,0 +1,167 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   compact-options.cpp
+ *
+ * @brief  Compact, read-mostly storage of a parsed configuration profile
+ */
+
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "compact-options.hpp"
+
+
+/**
+ *  Process wide table of interned option names.  Profiles are parsed by
+ *  several threads in parallel, so all access is serialized.  Names are
+ *  never removed; the number of distinct directive names is small.
+ */
+class InternedNameTable
+{
+public:
+    uint32_t Intern(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = ids.find(name);
+        if (ids.end() != it)
+        {
+            return it->second;
+        }
+        uint32_t id = names.size();
+        names.push_back(name);
+        ids[name] = id;
+        return id;
+    }
+
+    const std::string& Get(const uint32_t id)
+    {
+        // The elements of a std::deque do not move when it grows, so
+        // the reference stays valid after the lock is released
+        std::lock_guard<std::mutex> lock(mtx);
+        return names.at(id);
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return names.size();
+    }
+
+private:
+    std::mutex mtx;
+    std::deque<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+
+static InternedNameTable& name_table()
+{
+    static InternedNameTable table;
+    return table;
+}
+
+
+CompactOptionList::CompactOptionList(const openvpn::OptionList& options)
+{
+    // Size everything up front, so each container is allocated once
+    size_t arg_count = 0;
+    size_t arena_size = 0;
+    for (const auto& opt : options)
+    {
+        for (size_t i = 1; i < opt.size(); ++i)
+        {
+            ++arg_count;
+            arena_size += opt.ref(i).size();
+        }
+    }
+    if (arena_size > std::numeric_limits<uint32_t>::max()
+        || arg_count > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::length_error("Profile is too large to be packed");
+    }
+
+    entries.reserve(options.size());
+    offsets.reserve(arg_count);
+    arena.reserve(arena_size);
+
+    InternedNameTable& table = name_table();
+    for (const auto& opt : options)
+    {
+        Entry e;
+        e.name = table.Intern(0 < opt.size() ? opt.ref(0) : "");
+        e.first_arg = offsets.size();
+        e.arg_count = (0 < opt.size() ? opt.size() - 1 : 0);
+        for (size_t i = 1; i < opt.size(); ++i)
+        {
+            offsets.push_back(arena.size());
+            arena += opt.ref(i);
+        }
+        entries.push_back(e);
+    }
+}
+
+
+void CompactOptionList::Expand(openvpn::OptionList& out) const
+{
+    InternedNameTable& table = name_table();
+    out.reserve(out.size() + entries.size());
+    for (const auto& e : entries)
+    {
+        openvpn::Option opt;
+        opt.push_back(table.Get(e.name));
+        for (uint32_t a = e.first_arg; a < e.first_arg + e.arg_count; ++a)
+        {
+            opt.push_back(argument(a));
+        }
+        out.push_back(std::move(opt));
+    }
+}
+
+
+const std::string& CompactOptionList::Name(const size_t idx) const
+{
+    return name_table().Get(entries.at(idx).name);
+}
+
+
+size_t CompactOptionList::MemoryUsage() const noexcept
+{
+    return entries.capacity() * sizeof(Entry)
+           + offsets.capacity() * sizeof(uint32_t)
+           + arena.capacity();
+}
+
+
+size_t CompactOptionList::InternedNames()
+{
+    return name_table().size();
+}
+
+
+std::string CompactOptionList::argument(const size_t arg) const
+{
+    size_t start = offsets[arg];
+    size_t end = (arg + 1 < offsets.size() ? offsets[arg + 1] : arena.size());
+    return arena.substr(start, end - start);
+}
@@ -0,0 +1,117 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   compact-options.hpp
+ *
+ * @brief  Compact, read-mostly storage of a parsed configuration profile
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <openvpn/common/options.hpp>
+
+
+/**
+ *  Stores the options of a parsed configuration profile using a fixed
+ *  number of allocations, regardless of the number of options.
+ *
+ *  An openvpn::OptionList holds each option in its own Option object with
+ *  a std::vector of std::string arguments; that is one heap allocation
+ *  per option plus one per argument not fitting into the small string
+ *  buffer.  The configuration manager keeps the profiles in memory for
+ *  their whole lifetime but rarely reads them, so here all the arguments
+ *  are packed into a single arena with an offset table instead.
+ *
+ *  Option names are interned in a process wide table, so each distinct
+ *  directive name ("remote", "ca", "verb", ...) is only stored once for
+ *  all the profiles.
+ *
+ *  The stored options cannot be modified; replace the whole object
+ *  instead.
+ */
+class CompactOptionList
+{
+public:
+    CompactOptionList() = default;
+
+    /**
+     *  Packs the options of an OptionList
+     *
+     * @param options  openvpn::OptionList to pack
+     *
+     * @throws std::length_error if the options are too large to be packed
+     */
+    explicit CompactOptionList(const openvpn::OptionList& options);
+
+    /**
+     *  Unpacks the stored options, appending them to an OptionList
+     *
+     * @param out  openvpn::OptionList (or a subclass) to append the
+     *             options to
+     */
+    void Expand(openvpn::OptionList& out) const;
+
+    /**
+     * @return Returns the number of stored options
+     */
+    size_t size() const noexcept
+    {
+        return entries.size();
+    }
+
+    /**
+     * @param idx  Index of the option
+     *
+     * @return Returns the name of an option; the first argument in the
+     *         corresponding openvpn::Option
+     */
+    const std::string& Name(const size_t idx) const;
+
+    /**
+     * @return Returns the number of heap bytes used by this object, not
+     *         counting the shared table of interned names
+     */
+    size_t MemoryUsage() const noexcept;
+
+    /**
+     * @return Returns the number of distinct option names interned by
+     *         all CompactOptionList objects
+     */
+    static size_t InternedNames();
+
+
+private:
+    struct Entry
+    {
+        uint32_t name;        ///< ID of the interned option name
+        uint32_t first_arg;   ///< Index of the first argument in offsets
+        uint32_t arg_count;   ///< Number of arguments, excluding the name
+    };
+
+    std::vector<Entry> entries;     ///< One element per option
+    std::vector<uint32_t> offsets;  ///< Start of each argument in arena
+    std::string arena;              ///< All arguments, back to back
+
+    std::string argument(const size_t arg) const;
+};
@@ -0,0 +1,365 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   config-index.cpp
+ *
+ * @brief  Secondary lookup indexes of the configuration objects managed
+ *         by the configuration manager
+ */
+
+#include <algorithm>
+#include <cctype>
+
+#include "config-index.hpp"
+
+
+/**
+ *  Host names are matched case insensitively
+ */
+static std::string lowercase(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return str;
+}
+
+
+/**
+ *  Key of an override name and value pair in the override value index
+ */
+static std::string override_key(const std::string& name,
+                                const std::string& value)
+{
+    return name + "=" + value;
+}
+
+
+void ConfigurationIndex::Update(const std::string& path,
+                                const std::string& name,
+                                const uid_t owner,
+                                const std::vector<uid_t>& acl,
+                                const bool public_access,
+                                const Attributes& attrs)
+{
+    Remove(path);
+
+    Record rec;
+    rec.name = name;
+    rec.owner = owner;
+    rec.acl.insert(acl.begin(), acl.end());
+    rec.public_access = public_access;
+    for (const auto& host : attrs.remote_hosts)
+    {
+        rec.attrs.remote_hosts.insert(lowercase(host));
+    }
+    rec.attrs.remote_ports = attrs.remote_ports;
+    rec.attrs.remote_protos = attrs.remote_protos;
+    rec.attrs.remote_endpoints = attrs.remote_endpoints;
+    rec.attrs.overrides = attrs.overrides;
+
+    index_add(by_name, name, path);
+    index_add(by_owner, owner, path);
+    for (const auto& uid : rec.acl)
+    {
+        index_add(by_grant, uid, path);
+    }
+    if (public_access)
+    {
+        public_paths.insert(path);
+    }
+    for (const auto& host : rec.attrs.remote_hosts)
+    {
+        index_add(by_remote_host, host, path);
+    }
+    for (const auto& port : rec.attrs.remote_ports)
+    {
+        index_add(by_remote_port, port, path);
+    }
+    for (const auto& proto : rec.attrs.remote_protos)
+    {
+        index_add(by_remote_proto, proto, path);
+    }
+    for (const auto& ep : rec.attrs.remote_endpoints)
+    {
+        index_add(by_remote_endpoint, ep, path);
+    }
+    for (const auto& ov : rec.attrs.overrides)
+    {
+        index_add(by_override, ov.first, path);
+        index_add(by_override_value, override_key(ov.first, ov.second), path);
+    }
+    records[path] = std::move(rec);
+}
+
+
+void ConfigurationIndex::Remove(const std::string& path)
+{
+    auto it = records.find(path);
+    if (records.end() == it)
+    {
+        return;
+    }
+
+    const Record& rec = it->second;
+    index_remove(by_name, rec.name, path);
+    index_remove(by_owner, rec.owner, path);
+    for (const auto& uid : rec.acl)
+    {
+        index_remove(by_grant, uid, path);
+    }
+    public_paths.erase(path);
+    for (const auto& host : rec.attrs.remote_hosts)
+    {
+        index_remove(by_remote_host, host, path);
+    }
+    for (const auto& port : rec.attrs.remote_ports)
+    {
+        index_remove(by_remote_port, port, path);
+    }
+    for (const auto& proto : rec.attrs.remote_protos)
+    {
+        index_remove(by_remote_proto, proto, path);
+    }
+    for (const auto& ep : rec.attrs.remote_endpoints)
+    {
+        index_remove(by_remote_endpoint, ep, path);
+    }
+    for (const auto& ov : rec.attrs.overrides)
+    {
+        index_remove(by_override, ov.first, path);
+        index_remove(by_override_value, override_key(ov.first, ov.second),
+                     path);
+    }
+    records.erase(it);
+}
+
+
+bool ConfigurationIndex::Exists(const std::string& path) const
+{
+    return records.end() != records.find(path);
+}
+
+
+bool ConfigurationIndex::HasAccess(const std::string& path,
+                                   const uid_t uid) const
+{
+    auto it = records.find(path);
+    if (records.end() == it)
+    {
+        return false;
+    }
+    const Record& rec = it->second;
+    return rec.public_access
+           || uid == rec.owner
+           || rec.acl.end() != rec.acl.find(uid);
+}
+
+
+ConfigurationIndex::PathList ConfigurationIndex::LookupName(const std::string& name) const
+{
+    PathList ret;
+    index_merge(ret, by_name, name);
+    return ret;
+}
+
+
+ConfigurationIndex::PathList ConfigurationIndex::LookupName(const std::string& name,
+                                                            const uid_t uid) const
+{
+    PathList ret;
+    auto it = by_name.find(name);
+    if (by_name.end() == it)
+    {
+        return ret;
+    }
+    for (const auto& path : it->second)
+    {
+        if (HasAccess(path, uid))
+        {
+            ret.insert(path);
+        }
+    }
+    return ret;
+}
+
+
+ConfigurationIndex::PathList ConfigurationIndex::LookupNamePrefix(const std::string& prefix,
+                                                                  const uid_t uid) const
+{
+    // The name index is sorted, so all names sharing the same prefix
+    // are found next to each other
+    PathList ret;
+    for (auto it = by_name.lower_bound(prefix); by_name.end() != it; ++it)
+    {
+        if (0 != it->first.compare(0, prefix.size(), prefix))
+        {
+            break;
+        }
+        for (const auto& path : it->second)
+        {
+            if (HasAccess(path, uid))
+            {
+                ret.insert(path);
+            }
+        }
+    }
+    return ret;
+}
+
+
+ConfigurationIndex::PathList ConfigurationIndex::AccessibleBy(const uid_t uid) const
+{
+    PathList ret(public_paths);
+    index_merge(ret, by_owner, uid);
+    index_merge(ret, by_grant, uid);
+    return ret;
+}
+
+
+ConfigurationIndex::PathList ConfigurationIndex::OwnedBy(const uid_t uid) const
+{
+    PathList ret;
+    index_merge(ret, by_owner, uid);
+    return ret;
+}
+
+
+ConfigurationIndex::PathList ConfigurationIndex::Search(const Query& query,
+                                                        const uid_t uid) const
+{
+    // Collect the candidate lists of each attribute index in use.  Each
+    // criterion is checked again per candidate, so any one of them is
+    // enough to start from; the smallest one is picked.
+    static const PathList none;
+    std::vector<const PathList *> candidates;
+    auto lookup = [&candidates](const std::map<std::string, PathList>& idx,
+                                const std::string& key)
+                  {
+                      auto it = idx.find(key);
+                      candidates.push_back(idx.end() != it ? &it->second : &none);
+                  };
+
+    if (!query.remote_host.empty())
+    {
+        lookup(by_remote_host, lowercase(query.remote_host));
+    }
+    if (!query.remote_port.empty() && !query.remote_proto.empty())
+    {
+        lookup(by_remote_endpoint, query.remote_port + "/" + query.remote_proto);
+    }
+    else if (!query.remote_port.empty())
+    {
+        lookup(by_remote_port, query.remote_port);
+    }
+    else if (!query.remote_proto.empty())
+    {
+        lookup(by_remote_proto, query.remote_proto);
+    }
+    if (!query.override_name.empty())
+    {
+        if (query.override_value_set)
+        {
+            lookup(by_override_value,
+                   override_key(query.override_name, query.override_value));
+        }
+        else
+        {
+            lookup(by_override, query.override_name);
+        }
+    }
+
+    PathList start;
+    if (!candidates.empty())
+    {
+        start = **std::min_element(candidates.begin(), candidates.end(),
+                                   [](const PathList *a, const PathList *b)
+                                   {
+                                       return a->size() < b->size();
+                                   });
+    }
+    else if (!query.name_prefix.empty())
+    {
+        start = LookupNamePrefix(query.name_prefix, uid);
+    }
+    else if (query.owner_set)
+    {
+        start = OwnedBy(query.owner);
+    }
+    else
+    {
+        start = AccessibleBy(uid);
+    }
+
+    PathList ret;
+    for (const auto& path : start)
+    {
+        auto it = records.find(path);
+        if (records.end() != it && HasAccess(path, uid)
+            && matches(it->second, query))
+        {
+            ret.insert(path);
+        }
+    }
+    return ret;
+}
+
+
+bool ConfigurationIndex::matches(const Record& rec, const Query& query) const
+{
+    const Attributes& a = rec.attrs;
+    if (query.owner_set && query.owner != rec.owner)
+    {
+        return false;
+    }
+    if (0 != rec.name.compare(0, query.name_prefix.size(), query.name_prefix))
+    {
+        return false;
+    }
+    if (!query.remote_host.empty()
+        && a.remote_hosts.end() == a.remote_hosts.find(lowercase(query.remote_host)))
+    {
+        return false;
+    }
+    if (!query.remote_port.empty() && !query.remote_proto.empty())
+    {
+        if (a.remote_endpoints.end()
+            == a.remote_endpoints.find(query.remote_port + "/" + query.remote_proto))
+        {
+            return false;
+        }
+    }
+    else if ((!query.remote_port.empty()
+              && a.remote_ports.end() == a.remote_ports.find(query.remote_port))
+             || (!query.remote_proto.empty()
+                 && a.remote_protos.end() == a.remote_protos.find(query.remote_proto)))
+    {
+        return false;
+    }
+    if (!query.override_name.empty())
+    {
+        auto ov = a.overrides.find(query.override_name);
+        if (a.overrides.end() == ov
+            || (query.override_value_set && query.override_value != ov->second))
+        {
+            return false;
+        }
+    }
+    return true;
+}
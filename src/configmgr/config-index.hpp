@@ -0,0 +1,266 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   config-index.hpp
+ *
+ * @brief  Secondary lookup indexes of the configuration objects managed
+ *         by the configuration manager
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+
+/**
+ *  Keeps track of which configuration object paths carry a specific
+ *  configuration name and which users have access to them.  This allows
+ *  the configuration manager to answer name lookups and per-user listings
+ *  without scanning and ACL checking every configuration object available.
+ *
+ *  In addition, the remote entries and overrides of each configuration
+ *  are indexed, which is used by Search() to find configurations by these
+ *  attributes.
+ *
+ *  The access rules mirrors DBusCredentials::CheckACL(): an object is
+ *  accessible by its owner, by users granted access and by everyone if
+ *  public access is enabled.
+ */
+class ConfigurationIndex
+{
+public:
+    typedef std::set<std::string> PathList;
+
+    /**
+     *  Searchable attributes of a configuration object, besides the name
+     *  and access control information
+     */
+    struct Attributes
+    {
+        std::set<std::string> remote_hosts;   ///< Host names, in lower case
+        std::set<std::string> remote_ports;   ///< Ports of the remotes
+        std::set<std::string> remote_protos;  ///< Protocols of the remotes
+        std::set<std::string> remote_endpoints; ///< "port/proto" of each remote
+        std::map<std::string, std::string> overrides; ///< Override name and value
+    };
+
+    /**
+     *  Search criteria used by Search().  Empty and unset criteria match
+     *  all configurations.
+     */
+    struct Query
+    {
+        bool owner_set = false;
+        uid_t owner = 0;
+        std::string name_prefix = "";
+        std::string remote_host = "";
+        std::string remote_port = "";
+        std::string remote_proto = "";
+        std::string override_name = "";
+        bool override_value_set = false;
+        std::string override_value = "";
+    };
+
+    ConfigurationIndex() = default;
+    ~ConfigurationIndex() = default;
+
+    /**
+     *  Adds a configuration object to the index or refreshes the indexed
+     *  information if the object path is already indexed.  This must be
+     *  called each time the name, owner or access control of the object
+     *  changes.
+     *
+     * @param path           std::string with the D-Bus object path
+     * @param name           std::string with the configuration name
+     * @param owner          uid_t of the configuration owner
+     * @param acl            std::vector<uid_t> with UIDs granted access
+     * @param public_access  Is the configuration publicly accessible?
+     * @param attrs          Attributes with the remote entries and
+     *                       overrides of the configuration
+     */
+    void Update(const std::string& path, const std::string& name,
+                const uid_t owner, const std::vector<uid_t>& acl,
+                const bool public_access,
+                const Attributes& attrs = Attributes());
+
+    /**
+     *  Removes a configuration object from all the indexes.  Unknown
+     *  paths are silently ignored.
+     *
+     * @param path  std::string with the D-Bus object path to remove
+     */
+    void Remove(const std::string& path);
+
+    /**
+     * @param path  std::string with the D-Bus object path to look up
+     *
+     * @return  Returns true if the object path is indexed
+     */
+    bool Exists(const std::string& path) const;
+
+    /**
+     *  Checks if a user has access to a configuration object, according
+     *  to the indexed owner, ACL and public access information.
+     *
+     * @param path  std::string with the D-Bus object path to check
+     * @param uid   uid_t of the user to check
+     *
+     * @return  Returns true if the user has access, false if not or if the
+     *          object is not indexed.
+     */
+    bool HasAccess(const std::string& path, const uid_t uid) const;
+
+    /**
+     *  Retrieve all object paths using a specific configuration name
+     *
+     * @param name  std::string with the configuration name to look up
+     *
+     * @return  Returns a PathList of all matching object paths
+     */
+    PathList LookupName(const std::string& name) const;
+
+    /**
+     *  Retrieve all object paths using a specific configuration name
+     *  the given user has access to.
+     *
+     * @param name  std::string with the configuration name to look up
+     * @param uid   uid_t of the user doing the lookup
+     *
+     * @return  Returns a PathList of all matching object paths
+     */
+    PathList LookupName(const std::string& name, const uid_t uid) const;
+
+    /**
+     *  Retrieve all object paths where the configuration name starts with
+     *  the given prefix and the given user has access to.
+     *
+     * @param prefix  std::string with the start of the configuration name
+     * @param uid     uid_t of the user doing the lookup
+     *
+     * @return  Returns a PathList of all matching object paths
+     */
+    PathList LookupNamePrefix(const std::string& prefix,
+                              const uid_t uid) const;
+
+    /**
+     *  Retrieve all object paths a user has access to; either by being the
+     *  owner, being granted access or the object being public.
+     *
+     * @param uid   uid_t of the user
+     *
+     * @return  Returns a PathList of all accessible object paths
+     */
+    PathList AccessibleBy(const uid_t uid) const;
+
+    /**
+     *  Retrieve all object paths owned by a user
+     *
+     * @param uid   uid_t of the owner
+     *
+     * @return  Returns a PathList of the owned object paths
+     */
+    PathList OwnedBy(const uid_t uid) const;
+
+    /**
+     *  Retrieve all object paths matching all the given search criteria
+     *  which the given user has access to.  The candidates are taken from
+     *  the most selective index and checked against the other criteria.
+     *
+     * @param query  Query with the search criteria
+     * @param uid    uid_t of the user doing the search
+     *
+     * @return  Returns a PathList of all matching object paths
+     */
+    PathList Search(const Query& query, const uid_t uid) const;
+
+    /**
+     * @return  Returns the number of indexed configuration objects
+     */
+    size_t size() const noexcept
+    {
+        return records.size();
+    }
+
+
+private:
+    struct Record
+    {
+        std::string name;
+        uid_t owner;
+        std::set<uid_t> acl;
+        bool public_access;
+        Attributes attrs;
+    };
+
+    std::map<std::string, Record> records;
+    std::map<std::string, PathList> by_name;
+    std::map<uid_t, PathList> by_owner;
+    std::map<uid_t, PathList> by_grant;
+    PathList public_paths;
+    std::map<std::string, PathList> by_remote_host;
+    std::map<std::string, PathList> by_remote_port;
+    std::map<std::string, PathList> by_remote_proto;
+    std::map<std::string, PathList> by_remote_endpoint;
+    std::map<std::string, PathList> by_override;
+    std::map<std::string, PathList> by_override_value;
+
+    bool matches(const Record& rec, const Query& query) const;
+
+
+    template <typename K>
+    static void index_add(std::map<K, PathList>& idx, const K& key,
+                          const std::string& path)
+    {
+        idx[key].insert(path);
+    }
+
+
+    template <typename K>
+    static void index_remove(std::map<K, PathList>& idx, const K& key,
+                             const std::string& path)
+    {
+        auto it = idx.find(key);
+        if (idx.end() == it)
+        {
+            return;
+        }
+        it->second.erase(path);
+        if (it->second.empty())
+        {
+            idx.erase(it);
+        }
+    }
+
+
+    template <typename K>
+    static void index_merge(PathList& result,
+                            const std::map<K, PathList>& idx, const K& key)
+    {
+        auto it = idx.find(key);
+        if (idx.end() != it)
+        {
+            result.insert(it->second.begin(), it->second.end());
+        }
+    }
+};
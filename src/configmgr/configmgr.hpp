@@ -20,19 +20,34 @@
 #ifndef OPENVPN3_DBUS_CONFIGMGR_HPP
 #define OPENVPN3_DBUS_CONFIGMGR_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <map>
+#include <stdexcept>
+#include <thread>
 #include <ctime>
 
 #include <openvpn/log/logsimple.hpp>
+#include "common/atomic-file.hpp"
 #include "common/core-extensions.hpp"
 #include "common/lookup.hpp"
 #include "common/utils.hpp"
+#include "configmgr/config-index.hpp"
 #include "configmgr/overrides.hpp"
+#include "configmgr/blob-store.hpp"
+#include "configmgr/compact-options.hpp"
+#include "configmgr/persistent-index.hpp"
+#include "configmgr/profile-eval.hpp"
+#include "configmgr/profile-text.hpp"
+#include "configmgr/state-log.hpp"
 #include "dbus/core.hpp"
 #include "dbus/connection-creds.hpp"
 #include "dbus/exceptions.hpp"
 #include "dbus/object-property.hpp"
+#include "dbus/sealed-memfd.hpp"
 #include "log/ansicolours.hpp"
 #include "log/dbus-log.hpp"
 #include "log/logwriter.hpp"
@@ -138,7 +153,7 @@ public:
         for (const auto& e : this->value)
         {
             GVariant* value;
-            if (OverrideType::string == e.override.type)
+            if (OverrideType::string == e.override->type)
             {
                 value = g_variant_new("s", e.strValue.c_str());
             }
@@ -146,7 +161,7 @@ public:
             {
                 value = g_variant_new("b", e.boolValue);
             }
-            g_variant_builder_add(bld, "{sv}", e.override.key.c_str(), value);
+            g_variant_builder_add(bld, "{sv}", e.override->key.c_str(), value);
         }
         GVariant* ret = g_variant_builder_end(bld);
         g_variant_builder_unref(bld);
@@ -179,12 +194,30 @@ class ConfigurationObject : public DBusObject,
                             public DBusCredentials
 {
 public:
+    /**
+     *  A parsed configuration profile.  Large inline payloads are kept
+     *  in the InlineBlobStore; the option then contains the blob ID
+     *  instead of the payload.
+     */
+    struct ParsedProfile
+    {
+        OptionListJSON options;
+
+        /// Blob IDs of the inline payloads, indexed by option position.
+        /// The references are released if the profile is not used.
+        InlineBlobRefs inline_blobs;
+    };
+
+
     /**
      *  Constructor creating a new ConfigurationObject
      *
      * @param dbuscon  D-Bus connection this object is tied to
      * @param remove_callback  Callback function which must be called when
      *                 destroying this configuration object.
+     * @param update_callback  Callback function which must be called when
+     *                 the name, access control or overrides of this
+     *                 object changes.
      * @param objpath  D-Bus object path of this object
      * @param default_log_level  Unsigned integer defining the initial log level
      * @param logwr    Pointer to LogWriter object; can be nullptr to disable
@@ -194,20 +227,35 @@ public:
      * @param creator  An uid reference of the owner of this object.  This is
      *                 typically the uid of the front-end user importing this
      *                 VPN configuration profile.
+     * @param state_dir  std::string with the directory where persistent
+     *                 configurations are saved
+     * @param state_log  Pointer to the ConfigStateLog where persistent
+     *                 configurations are saved.  If nullptr, each
+     *                 persistent configuration is saved in its own file in
+     *                 state_dir.
+     * @param blob_store  Pointer to the InlineBlobStore where large inline
+     *                 payloads are kept.  May be nullptr.
      * @param params   Pointer to a GLib2 GVariant object containing both
      *                 meta data as well as the configuration profile itself
      *                 to use when initializing this object
+     * @param parsed   Pointer to a ParsedProfile object with the profile
+     *                 from params already parsed, see ParseImportProfile().
+     *                 If nullptr, the profile is parsed here.
      */
     ConfigurationObject(GDBusConnection *dbuscon,
                         std::function<void()> remove_callback,
+                        std::function<void()> update_callback,
                         std::string objpath, unsigned int default_log_level,
                         LogWriter *logwr, bool signal_broadcast,
-                        uid_t creator, std::string state_dir, GVariant *params)
+                        uid_t creator, std::string state_dir,
+                        ConfigStateLog *state_log, InlineBlobStore *blob_store,
+                        GVariant *params, ParsedProfile *parsed = nullptr)
         : DBusObject(objpath),
           ConfigManagerSignals(dbuscon, objpath, default_log_level, logwr,
                                signal_broadcast),
           DBusCredentials(dbuscon, creator),
           remove_callback(remove_callback),
+          update_callback(update_callback),
           name(""),
           import_tstamp(std::time(nullptr)),
           last_use_tstamp(0),
@@ -216,37 +264,84 @@ public:
           readonly(false),
           single_use(false),
           properties(this),
-          persistent_file("")
+          persistent_file(""),
+          blob_store(blob_store)
     {
         GLibUtils::checkParams(__func__, params, "(ssbb)", 4);
         name = GLibUtils::ExtractValue<std::string>(params, 0);
-        std::string cfgstr(GLibUtils::ExtractValue<std::string>(params, 1));
         single_use = GLibUtils::ExtractValue<bool>(params, 2);
         bool persistent = GLibUtils::ExtractValue<bool>(params, 3);
 
         // Parse the options from the imported configuration
-        OptionList::Limits limits("profile is too large",
-                                  ProfileParseLimits::MAX_PROFILE_SIZE,
-                                  ProfileParseLimits::OPT_OVERHEAD,
-                                  ProfileParseLimits::TERM_OVERHEAD,
-                                  ProfileParseLimits::MAX_LINE_SIZE,
-                                  ProfileParseLimits::MAX_DIRECTIVE_SIZE);
-        options.parse_from_config(cfgstr, &limits);
+        if (nullptr != parsed)
+        {
+            take_profile(*parsed);
+        }
+        else
+        {
+            ParsedProfile prf;
+            ParseImportProfile(GLibUtils::ExtractValue<std::string>(params, 1),
+                               prf, blob_store);
+            take_profile(prf);
+        }
         initialize_configuration(persistent);
 
-        if (persistent && !state_dir.empty())
+        if (persistent && (state_log || !state_dir.empty()))
         {
-            std::string objp = GetObjectPath();
-            std::stringstream p;
-            p << state_dir << "/" << simple_basename(objp) << ".json";
-            persistent_file = std::string(p.str());
+            if (state_log)
+            {
+                this->state_log = state_log;
+            }
+            else
+            {
+                std::string objp = GetObjectPath();
+                std::stringstream p;
+                p << state_dir << "/" << simple_basename(objp) << ".json";
+                persistent_file = std::string(p.str());
+            }
+
+            // A newly imported configuration is written right away
             update_persistent_file();
+            FlushPersistentFile();
         }
     }
 
+    /**
+     *  Constructor registering a persistent configuration loaded from
+     *  the state directory.
+     *
+     * @param dbuscon  D-Bus connection this object is tied to
+     * @param fname    std::string with the persistent configuration file.
+     *                 Empty if state_log is used.
+     * @param state_log  Pointer to the ConfigStateLog this configuration
+     *                 is stored in, nullptr if stored in its own file
+     * @param blob_store  Pointer to the InlineBlobStore where large inline
+     *                 payloads are kept.  May be nullptr.
+     * @param profile  Json::Value with the contents of the persistent
+     *                 configuration file.  If the "profile" section is
+     *                 missing, it is loaded from the file when needed.
+     * @param parsed   Pointer to a ParsedProfile object with the already
+     *                 parsed profile, which will be moved into this
+     *                 object.  May be nullptr.
+     * @param remove_callback  Callback function which must be called when
+     *                 destroying this configuration object.
+     * @param update_callback  Callback function which must be called when
+     *                 the name, access control or overrides of this
+     *                 object changes.
+     * @param default_log_level  Unsigned integer defining the initial log level
+     * @param logwr    Pointer to LogWriter object; can be nullptr to disable
+     *                 file log.
+     * @param signal_broadcast Should signals be broadcasted (true) or
+     *                         targeted for the log service (false)
+     */
     ConfigurationObject(GDBusConnection *dbuscon,
-                        const std::string& fname, Json::Value profile,
+                        const std::string& fname,
+                        ConfigStateLog *state_log,
+                        InlineBlobStore *blob_store,
+                        Json::Value profile,
+                        ParsedProfile *parsed,
                         std::function<void()> remove_callback,
+                        std::function<void()> update_callback,
                         unsigned int default_log_level,
                         LogWriter *logwr, bool signal_broadcast)
         : DBusObject(profile["object_path"].asString()),
@@ -254,9 +349,13 @@ public:
                                default_log_level, logwr, signal_broadcast),
           DBusCredentials(dbuscon, profile["owner"].asUInt64()),
           remove_callback(remove_callback),
+          update_callback(update_callback),
           properties(this),
-          persistent_file(fname)
+          persistent_file(fname),
+          state_log(state_log),
+          blob_store(blob_store)
     {
+        pending_blob_refs.SetStore(blob_store);
         name = profile["name"].asString();
         import_tstamp = profile["import_timestamp"].asUInt64();
         last_use_tstamp = profile["last_used_timestamp"].asUInt64();
@@ -278,10 +377,10 @@ public:
             switch(ov.type())
             {
             case Json::ValueType::booleanValue:
-                set_override(ovkey.c_str(), ov.asBool());
+                set_override(lookup_override(ovkey.c_str()), ov.asBool());
                 break;
             case Json::ValueType::stringValue:
-                set_override(ovkey.c_str(), ov.asString());
+                set_override(lookup_override(ovkey.c_str()), ov.asString());
                 break;
             default:
                 THROW_DBUSEXCEPTION("ConfigurationObject",
@@ -289,21 +388,58 @@ public:
             }
         }
 
-        // Parse the options from the imported configuration
-        OptionList::Limits limits("profile is too large",
-                                  ProfileParseLimits::MAX_PROFILE_SIZE,
-                                  ProfileParseLimits::OPT_OVERHEAD,
-                                  ProfileParseLimits::TERM_OVERHEAD,
-                                  ProfileParseLimits::MAX_LINE_SIZE,
-                                  ProfileParseLimits::MAX_DIRECTIVE_SIZE);
-        ProfileMergeJSON pm(profile["profile"]);
-        options.parse_from_config(pm.profile_content(), &limits);
+        // If only the metadata is provided (from the persistent
+        // metadata index), the profile itself is parsed from the
+        // persistent file the first time it is needed.  The inline
+        // blobs it refers to must be kept until then.
+        //
+        // If the constructor fails, the references taken here are
+        // released by the InlineBlobRefs members.
+        if (nullptr != parsed)
+        {
+            take_profile(*parsed);
+        }
+        else if (profile.isMember("profile"))
+        {
+            parse_profile(profile["profile"]);
+        }
+        else if (blob_store)
+        {
+            try
+            {
+                for (const auto& id : profile["inline_blobs"])
+                {
+                    blob_store->Ref(id.asString());
+                    pending_blob_refs[pending_blob_refs.size()] = id.asString();
+                }
+            }
+            catch (const InlineBlobStoreException& excp)
+            {
+                THROW_DBUSEXCEPTION("ConfigurationObject", excp.what());
+            }
+        }
+
+        // The remote entries are needed by the search indexes.  The
+        // metadata index carries them, unless it was written by an older
+        // version; then they are looked up by IndexRemotes() later on.
+        if (!profile_loaded && profile.isMember("remotes"))
+        {
+            for (const auto& r : profile["remotes"])
+            {
+                remote_list.push_back({r["host"].asString(),
+                                       r["port"].asString(),
+                                       r["proto"].asString()});
+            }
+            remotes_known = true;
+        }
 
         initialize_configuration(true);
     }
 
     ~ConfigurationObject()
     {
+        cancel_persistent_write();
+        release_inline_blobs();
         remove_callback();
         Debug("Configuration removed");
         IdleCheck_RefDec();
@@ -321,14 +457,285 @@ public:
     }
 
 
+    /**
+     * @return Returns the attributes of this configuration used by the
+     *         search indexes of the configuration manager
+     */
+    ConfigurationIndex::Attributes GetSearchAttributes() const
+    {
+        ConfigurationIndex::Attributes ret;
+        for (const auto& r : remote_list)
+        {
+            ret.remote_hosts.insert(r.host);
+            ret.remote_ports.insert(r.port);
+            ret.remote_protos.insert(r.proto);
+            ret.remote_endpoints.insert(r.port + "/" + r.proto);
+        }
+        for (const auto& ov : override_list)
+        {
+            ret.overrides[ov.override->key] =
+                (OverrideType::boolean == ov.override->type
+                 ? (ov.boolValue ? "true" : "false")
+                 : ov.strValue);
+        }
+        return ret;
+    }
+
+
+    /**
+     * @return Returns true if the remote entries of this configuration are
+     *         known, either from the profile or from the metadata index
+     */
+    bool RemotesKnown() const noexcept
+    {
+        return remotes_known;
+    }
+
+
+    /**
+     *  Looks up the remote entries of a configuration whose profile has
+     *  not been loaded yet, for the search indexes.  The profile is read
+     *  and parsed, but not kept; inline payloads are not needed for this
+     *  and are skipped.
+     *
+     * @throws DBusException if the profile could not be read
+     */
+    void IndexRemotes()
+    {
+        if (remotes_known)
+        {
+            return;
+        }
+
+        Json::Value profile = read_persistent_profile();
+        Json::Value stripped(Json::objectValue);
+        for (const auto& optname : profile.getMemberNames())
+        {
+            if (!profile[optname].isObject())
+            {
+                stripped[optname] = profile[optname];
+            }
+        }
+
+        ParsedProfile parsed;
+        try
+        {
+            ParseProfile(stripped, parsed, nullptr);
+        }
+        catch (const std::exception& excp)
+        {
+            THROW_DBUSEXCEPTION("ConfigurationObject",
+                                "Failed to parse profile from '"
+                                + persistent_source() + "': "
+                                + std::string(excp.what()));
+        }
+        remote_list = ProfileEvaluation::Evaluate(parsed.options).remotes;
+        remotes_known = true;
+        update_callback();
+
+        // The metadata in the state log is only rewritten together with
+        // the profile; do that now, so this is only needed once
+        if (state_log)
+        {
+            try
+            {
+                state_log->Put(GetObjectPath(), ExportMetadata(), profile);
+            }
+            catch (const ConfigStateLogException& excp)
+            {
+                LogError(excp.what());
+            }
+        }
+    }
+
+
+    /**
+     * @return Returns the time this configuration was imported
+     */
+    std::time_t GetImportTimestamp() const noexcept
+    {
+        return import_tstamp;
+    }
+
+
+    /**
+     * @return Returns the time this configuration was last used by a
+     *         VPN backend client, 0 if never used
+     */
+    std::time_t GetLastUsedTimestamp() const noexcept
+    {
+        return last_use_tstamp;
+    }
+
+
+    /**
+     * @return Returns the number of times this configuration has been
+     *         used by a VPN backend client
+     */
+    unsigned int GetUsedCount() const noexcept
+    {
+        return used_count;
+    }
+
+
+    /**
+     * @return Returns true if this configuration is saved to disk
+     */
+    bool IsPersistent() const noexcept
+    {
+        return is_persistent();
+    }
+
+
+    /**
+     * @return Returns the file name of the persistent configuration file,
+     *         empty if this configuration is not persistent
+     */
+    const std::string& GetPersistentFile() const noexcept
+    {
+        return persistent_file;
+    }
+
+
+    /**
+     *  Parses the "profile" section of a persistent configuration file.
+     *  This does not depend on any ConfigurationObject and is safe to
+     *  call from any thread.
+     *
+     * @param profile     Json::Value containing the "profile" section
+     * @param parsed      ParsedProfile object where the parsed options
+     *                    will be stored
+     * @param blob_store  Pointer to the InlineBlobStore used to resolve
+     *                    and store inline payloads.  May be nullptr if
+     *                    the profile does not refer to any blobs.
+     */
+    static void ParseProfile(const Json::Value& profile,
+                             ParsedProfile& parsed,
+                             InlineBlobStore *blob_store)
+    {
+        // Persistent profiles refer to inline payloads stored in the
+        // blob directory as {"inline_blob": "<blob ID>"}
+        // The references taken while parsing are released when done;
+        // store_inline_blobs() takes its own references.
+        Json::Value resolved = profile;
+        InlineBlobRefs refs;
+        refs.SetStore(blob_store);
+        for (const auto& optname : profile.getMemberNames())
+        {
+            if (!profile[optname].isObject())
+            {
+                continue;
+            }
+            if (!blob_store)
+            {
+                throw InlineBlobStoreException("No blob storage available");
+            }
+            std::string id = profile[optname]["inline_blob"].asString();
+            blob_store->Ref(id);
+            refs[refs.size()] = id;
+            resolved[optname] = blob_store->Get(id);
+        }
+
+        OptionList::Limits limits("profile is too large",
+                                  ProfileParseLimits::MAX_PROFILE_SIZE,
+                                  ProfileParseLimits::OPT_OVERHEAD,
+                                  ProfileParseLimits::TERM_OVERHEAD,
+                                  ProfileParseLimits::MAX_LINE_SIZE,
+                                  ProfileParseLimits::MAX_DIRECTIVE_SIZE);
+        ProfileMergeJSON pm(resolved);
+        parsed.options.parse_from_config(pm.profile_content(), &limits);
+        if (blob_store)
+        {
+            store_inline_blobs(parsed, *blob_store);
+        }
+    }
+
+
+    /**
+     *  Parses a configuration profile as provided to the Import method.
+     *  This does not depend on any ConfigurationObject and is safe to
+     *  call from any thread.
+     *
+     * @param cfgstr      std::string with the configuration profile
+     * @param parsed      ParsedProfile object where the parsed options
+     *                    will be stored
+     * @param blob_store  Pointer to the InlineBlobStore where large
+     *                    inline payloads are stored.  May be nullptr.
+     */
+    static void ParseImportProfile(const std::string& cfgstr,
+                                   ParsedProfile& parsed,
+                                   InlineBlobStore *blob_store)
+    {
+        OptionList::Limits limits("profile is too large",
+                                  ProfileParseLimits::MAX_PROFILE_SIZE,
+                                  ProfileParseLimits::OPT_OVERHEAD,
+                                  ProfileParseLimits::TERM_OVERHEAD,
+                                  ProfileParseLimits::MAX_LINE_SIZE,
+                                  ProfileParseLimits::MAX_DIRECTIVE_SIZE);
+        parsed.options.parse_from_config(cfgstr, &limits);
+        if (blob_store)
+        {
+            store_inline_blobs(parsed, *blob_store);
+        }
+    }
+
+
+    /**
+     *  Moves the payload of large inline options (<ca>, <cert>,
+     *  <tls-crypt>, etc) into the InlineBlobStore, so identical payloads
+     *  used by several configuration profiles are only kept once.
+     *
+     * @param parsed      ParsedProfile to process
+     * @param blob_store  InlineBlobStore where the payloads are stored
+     */
+    static void store_inline_blobs(ParsedProfile& parsed,
+                                   InlineBlobStore& blob_store)
+    {
+        parsed.inline_blobs.SetStore(&blob_store);
+        for (size_t i = 0; i < parsed.options.size(); ++i)
+        {
+            const Option& opt = parsed.options[i];
+            if (2 != opt.size() || !optparser_inline_file(opt.ref(0))
+                || inline_blob_min_size > opt.ref(1).size())
+            {
+                continue;
+            }
+            std::string optname = opt.ref(0);
+            std::string id = blob_store.Add(opt.ref(1));
+            parsed.options[i] = Option(optname, id);
+            parsed.inline_blobs[i] = id;
+        }
+    }
+
+
     /**
      *  Exports the configuration, including all the available settings
      *  specific to the Linux client.  The output format is JSON.
      *
+     *  If the profile has not been loaded yet, it will be loaded from
+     *  the persistent configuration file first.
+     *
      * @return Returns a Json::Value object containing the serialized
      *         configuration profile
      */
-    Json::Value Export() const
+    Json::Value Export()
+    {
+        load_profile();
+        Json::Value ret = ExportMetadata();
+        ret["profile"] = expanded_options().json_export();
+        return ret;
+    }
+
+
+    /**
+     *  Exports all the information about this configuration, except the
+     *  profile itself.  This is the information needed to register the
+     *  configuration object without parsing the profile.
+     *
+     * @return Returns a Json::Value object containing the serialized
+     *         configuration metadata
+     */
+    Json::Value ExportMetadata() const
     {
         Json::Value ret;
 
@@ -342,29 +749,50 @@ public:
         ret["single_use"] = single_use;
         ret["used_count"] = used_count;
         ret["valid"] = valid;
-        ret["profile"] = options.json_export();
 
         ret["public_access"] = GetPublicAccess();
         for (const auto& e : GetAccessList())
         {
             ret["acl"].append(e);
         }
+        for (const auto& b : inline_blobs)
+        {
+            ret["inline_blobs"].append(b.second);
+        }
+        for (const auto& b : pending_blob_refs)
+        {
+            ret["inline_blobs"].append(b.second);
+        }
+        // Without the "remotes" key, the remote entries are looked up
+        // again the next time the configuration is registered
+        if (remotes_known)
+        {
+            ret["remotes"] = Json::Value(Json::arrayValue);
+            for (const auto& r : remote_list)
+            {
+                Json::Value remote;
+                remote["host"] = r.host;
+                remote["port"] = r.port;
+                remote["proto"] = r.proto;
+                ret["remotes"].append(remote);
+            }
+        }
         for (const auto& ov : override_list)
         {
-            switch (ov.override.type)
+            switch (ov.override->type)
             {
             case OverrideType::boolean:
-                ret["overrides"][ov.override.key] = ov.boolValue;
+                ret["overrides"][ov.override->key] = ov.boolValue;
                 break;
 
             case OverrideType::string:
-                ret["overrides"][ov.override.key] = ov.strValue;
+                ret["overrides"][ov.override->key] = ov.strValue;
                 break;
 
             default:
                 THROW_DBUSEXCEPTION("ConfigurationObject",
                                     "Invalid override type for key "
-                                    "'" + ov.override.key + "'");
+                                    "'" + ov.override->key + "'");
             }
         }
 
@@ -395,7 +823,8 @@ public:
                               GDBusMethodInvocation *invoc)
     {
         IdleCheck_UpdateTimestamp();
-        if ("Fetch" == method_name)
+        if ("Fetch" == method_name || "FetchFD" == method_name
+            || "FetchEvaluated" == method_name)
         {
             try
             {
@@ -411,9 +840,21 @@ public:
                     // owner
                     CheckOwnerAccess(sender, true);
                 }
-                g_dbus_method_invocation_return_value(invoc,
-                                                      g_variant_new("(s)",
-                                                                    options.string_export().c_str()));
+                load_profile();
+                if ("FetchFD" == method_name)
+                {
+                    return_profile_fd(invoc);
+                }
+                else if ("FetchEvaluated" == method_name)
+                {
+                    return_profile_fd(invoc, &cached_profile_evaluation());
+                }
+                else
+                {
+                    g_dbus_method_invocation_return_value(invoc,
+                                                          g_variant_new("(s)",
+                                                                        profile_text().c_str()));
+                }
 
                 // If the fetching user is openvpn (which
                 // openvpn3-service-client runs as), we consider this
@@ -468,6 +909,11 @@ public:
                 LogWarn(excp.what());
                 excp.SetDBusError(invoc);
             }
+            catch (DBusException& excp)
+            {
+                LogError(excp.what());
+                excp.SetDBusError(invoc, "net.openvpn.v3.configmgr.error");
+            }
         }
         else if ("FetchJSON" == method_name)
         {
@@ -484,9 +930,9 @@ public:
                     CheckOwnerAccess(sender);
                 }
 
+                load_profile();
                 std::stringstream jsoncfg;
-                jsoncfg << options.json_export();
-
+                jsoncfg << expanded_options().json_export();
                 g_dbus_method_invocation_return_value(invoc,
                                                       g_variant_new("(s)",
                                                                     jsoncfg.str().c_str()));
@@ -504,6 +950,11 @@ public:
                 LogWarn(excp.what());
                 excp.SetDBusError(invoc);
             }
+            catch (DBusException& excp)
+            {
+                LogError(excp.what());
+                excp.SetDBusError(invoc, "net.openvpn.v3.configmgr.error");
+            }
         }
         else if ("SetOption" == method_name)
         {
@@ -518,6 +969,8 @@ public:
             {
                 CheckOwnerAccess(sender);
                 // TODO: Implement SetOption
+                invalidate_export_cache();
+                update_callback();
                 g_dbus_method_invocation_return_value(invoc, NULL);
                 update_persistent_file();
                 return;
@@ -545,9 +998,11 @@ public:
                 g_variant_get(params, "(sv)", &key, &val);
 
                 const OverrideValue vo = set_override(key, val);
+                invalidate_export_cache();
+                update_callback();
 
                 std::string newValue = vo.strValue;
-                if (OverrideType::boolean == vo.override.type)
+                if (OverrideType::boolean == vo.override->type)
                 {
                     newValue = vo.boolValue ? "true" : "false";
                 }
@@ -586,8 +1041,11 @@ public:
                 CheckOwnerAccess(sender);
                 gchar *key = nullptr;
                 g_variant_get(params, "(s)", &key);
-                if(remove_override(key))
+                const ValidOverride& vo = GetConfigOverride(key);
+                if (vo.valid() && remove_override(vo))
                 {
+                    invalidate_export_cache();
+                    update_callback();
                     LogInfo("Unset configuration override '" + std::string(key)
                                 + "' by UID " + std::to_string(GetUID(sender)));
 
@@ -629,6 +1087,8 @@ public:
                 uid_t uid = -1;
                 g_variant_get(params, "(u)", &uid);
                 GrantAccess(uid);
+                invalidate_export_cache();
+                update_callback();
                 g_dbus_method_invocation_return_value(invoc, NULL);
 
                 LogInfo("Access granted to UID " + std::to_string(uid)
@@ -659,6 +1119,8 @@ public:
                 uid_t uid = -1;
                 g_variant_get(params, "(u)", &uid);
                 RevokeAccess(uid);
+                invalidate_export_cache();
+                update_callback();
                 g_dbus_method_invocation_return_value(invoc, NULL);
 
                 LogInfo("Access revoked for UID " + std::to_string(uid)
@@ -710,8 +1172,23 @@ public:
 
                 // If this is a persistent config, remove it from
                 // the file system too
-                if (!persistent_file.empty())
+                if (state_log)
                 {
+                    cancel_persistent_write();
+                    try
+                    {
+                        state_log->Delete(GetObjectPath());
+                        LogVerb2("Persistent configuration profile removed "
+                                 "from " + state_log->GetFilename());
+                    }
+                    catch (const ConfigStateLogException& excp)
+                    {
+                        LogError(excp.what());
+                    }
+                }
+                else if (!persistent_file.empty())
+                {
+                    cancel_persistent_write();
                     unlink(persistent_file.c_str());
                     LogVerb2("Persistent configuration profile removed: '"
                              + persistent_file + "'");
@@ -795,7 +1272,7 @@ public:
             }
             else if ("persistent" == property_name)
             {
-                ret = g_variant_new_boolean(!persistent_file.empty());
+                ret = g_variant_new_boolean(is_persistent());
             }
             else if (properties.Exists(property_name))
             {
@@ -861,6 +1338,8 @@ public:
             {
                 gsize len = 0;
                 name = std::string(g_variant_get_string(value, &len));
+                invalidate_export_cache();
+                update_callback();
                 ret = build_set_property_response(property_name, name);
             }
             else if (("locked_down" == property_name) && conn)
@@ -874,6 +1353,8 @@ public:
             {
                 bool acl_public = g_variant_get_boolean(value);
                 SetPublicAccess(acl_public);
+                invalidate_export_cache();
+                update_callback();
                 ret = build_set_property_response(property_name, acl_public);
                 LogInfo("Public access set to "
                          + (acl_public ? std::string("true") : std::string("false"))
@@ -904,15 +1385,15 @@ public:
 
 
     /**
-     *  Sets an override value for the configuration profile
+     *  Looks up the descriptor of an override key
      *
-     * @param key    char * of the override key
-     * @param value  GVariant object of the override value to use
+     * @param key  char * of the override key
      *
-     * @return  Returns the OverrideValue object added to the
-     *          array of override settings
+     * @return  Returns a reference to the static ValidOverride descriptor
+     *
+     * @throws  DBusException if the override key is unknown
      */
-    OverrideValue set_override(const gchar *key, GVariant *value)
+    const ValidOverride& lookup_override(const gchar *key)
     {
         const ValidOverride& vo = GetConfigOverride(key);
         if (!vo.valid())
@@ -921,60 +1402,96 @@ public:
                                 "Invalid override key '" + std::string(key)
                                 + "'");
         }
+        return vo;
+    }
+
 
-        // Ensure that a previous override value is remove
-        (void) remove_override(key);
+    /**
+     *  Sets an override value for the configuration profile
+     *
+     * @param key    char * of the override key
+     * @param value  GVariant object of the override value to use
+     *
+     * @return  Returns the OverrideValue object added to the
+     *          array of override settings
+     */
+    OverrideValue set_override(const gchar *key, GVariant *value)
+    {
+        const ValidOverride& vo = lookup_override(key);
 
-        std::string g_type(g_variant_get_type_string(value));
-        if ("s" == g_type)
+        if (g_variant_is_of_type(value, G_VARIANT_TYPE_STRING))
         {
             gsize len = 0;
             std::string v(g_variant_get_string(value, &len));
-            return set_override(key, v);
+            return set_override(vo, v);
         }
-        else if ("b" == g_type)
+        else if (g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN))
         {
-            return set_override(key, g_variant_get_boolean(value));
+            return set_override(vo, (bool) g_variant_get_boolean(value));
         }
         THROW_DBUSEXCEPTION("ConfigurationObject",
-                            "Unsupported override data type: " + g_type);
+                            "Unsupported override data type: "
+                            + std::string(g_variant_get_type_string(value)));
     }
 
 
     /**
-     *  Sets an override value for the configuration profile
+     *  Sets a boolean override value for the configuration profile
      *
-     * @param key    char * of the override key
+     * @param vo     ValidOverride descriptor of the override
      * @param value  Value for the override
      *
      * @return  Returns the OverrideValue object added to the
      *          array of override settings
+     *
+     * @throws  DBusException if the override is not a boolean override
      */
-    template<typename T>
-    OverrideValue set_override(const gchar *key, T value)
+    OverrideValue set_override(const ValidOverride& vo, bool value)
     {
-        const ValidOverride& vo = GetConfigOverride(key);
-        if (!vo.valid())
-        {
-            THROW_DBUSEXCEPTION("ConfigurationObject",
-                                "Invalid override key '" + std::string(key)
-                                + "'");
-        }
+        check_override_type(vo, OverrideType::boolean);
+        (void) remove_override(vo);
+        override_list.push_back(OverrideValue(vo, value));
+        return override_list.back();
+    }
 
-        // Ensure that a previous override value is remove
-        (void) remove_override(key);
 
-        switch (vo.type)
-        {
-        case OverrideType::string:
-        case OverrideType::boolean:
-            override_list.push_back(OverrideValue(vo, value));
-            return override_list.back();
+    /**
+     *  Sets a string override value for the configuration profile
+     *
+     * @param vo     ValidOverride descriptor of the override
+     * @param value  Value for the override
+     *
+     * @return  Returns the OverrideValue object added to the
+     *          array of override settings
+     *
+     * @throws  DBusException if the override is not a string override
+     */
+    OverrideValue set_override(const ValidOverride& vo,
+                               const std::string& value)
+    {
+        check_override_type(vo, OverrideType::string);
+        (void) remove_override(vo);
+        override_list.push_back(OverrideValue(vo, value));
+        return override_list.back();
+    }
+
 
-        default:
+    /**
+     *  Ensures an override value has the data type the override
+     *  descriptor requires
+     *
+     * @param vo    ValidOverride descriptor of the override
+     * @param type  OverrideType of the value being set
+     *
+     * @throws  DBusException if the data type does not match
+     */
+    void check_override_type(const ValidOverride& vo, OverrideType type)
+    {
+        if (type != vo.type)
+        {
             THROW_DBUSEXCEPTION("ConfigurationObject",
-                                "Unsupported data type for key '"
-                                + std::string(key) + "'");
+                                "Invalid data type for key '"
+                                + vo.key + "'");
         }
     }
 
@@ -982,15 +1499,15 @@ public:
     /**
      *  Removes and override from the std::vector<OverrideValue> array
      *
-     * @param key  std::string of the override key to remove
+     * @param vo  ValidOverride descriptor of the override to remove
      *
      * @return Returns true on successful removal, otherwise false.
      */
-    bool remove_override(const gchar *key)
+    bool remove_override(const ValidOverride& vo)
     {
         for (auto it = override_list.begin(); it != override_list.end(); it++)
         {
-            if ((*it).override.key == key)
+            if (vo.id == it->override->id)
             {
                 override_list.erase(it);
                 return true;
@@ -1000,10 +1517,201 @@ public:
     }
 
 
+    /**
+     *  Parses the configuration profile from the JSON representation
+     *  used in the persistent configuration files.
+     *
+     * @param profile  Json::Value containing the "profile" section of a
+     *                 persistent configuration file
+     */
+    void parse_profile(const Json::Value& profile)
+    {
+        ParsedProfile parsed;
+        ParseProfile(profile, parsed, blob_store);
+        take_profile(parsed);
+    }
+
+
+    /**
+     *  Replaces the configuration profile with an already parsed one.
+     *  References to inline blobs held by the previous profile are
+     *  released.
+     *
+     * @param parsed  ParsedProfile to move into this object
+     */
+    void take_profile(ParsedProfile& parsed)
+    {
+        release_inline_blobs();
+        remote_list = ProfileEvaluation::Evaluate(parsed.options).remotes;
+        remotes_known = true;
+        options = CompactOptionList(parsed.options);
+        parsed.options.clear();
+        inline_blobs = std::move(parsed.inline_blobs);
+        invalidate_export_cache();
+        profile_loaded = true;
+    }
+
+
+    /**
+     *  Releases all the references this object holds in the
+     *  InlineBlobStore
+     */
+    void release_inline_blobs()
+    {
+        inline_blobs.Release();
+        pending_blob_refs.Release();
+    }
+
+
+    /**
+     * @return Returns a copy of the parsed options where the blob IDs
+     *         are replaced with the inline payloads they refer to
+     *
+     * @throws DBusException if a payload could not be retrieved
+     */
+    OptionListJSON expanded_options() const
+    {
+        OptionListJSON ret;
+        options.Expand(ret);
+        try
+        {
+            for (const auto& b : inline_blobs)
+            {
+                ret[b.first] = Option(options.Name(b.first),
+                                      blob_store->Get(b.second));
+            }
+        }
+        catch (const InlineBlobStoreException& excp)
+        {
+            THROW_DBUSEXCEPTION("ConfigurationObject", excp.what());
+        }
+        return ret;
+    }
+
+
+    /**
+     *  Generates the "profile" section written to persistent storage.
+     *  Inline payloads are saved in the blob directory and only the
+     *  blob IDs are stored in the profile.
+     *
+     * @return Returns a Json::Value with the profile to store
+     *
+     * @throws InlineBlobStoreException if a blob could not be saved
+     */
+    Json::Value export_persistent_profile()
+    {
+        OptionListJSON opts;
+        options.Expand(opts);
+        Json::Value ret = opts.json_export();
+        for (const auto& b : inline_blobs)
+        {
+            blob_store->Persist(b.second);
+            Json::Value ref;
+            ref["inline_blob"] = b.second;
+            ret[options.Name(b.first)] = ref;
+        }
+        return ret;
+    }
+
+
+    /**
+     *  Ensures the configuration profile has been parsed.  Configurations
+     *  registered from the persistent metadata index are only parsed
+     *  when the profile is needed the first time.
+     *
+     * @throws DBusException if the persistent file could not be loaded
+     */
+    void load_profile()
+    {
+        if (profile_loaded)
+        {
+            return;
+        }
+
+        bool index_remotes = !remotes_known;
+        Json::Value profile = read_persistent_profile();
+        try
+        {
+            parse_profile(profile);
+        }
+        catch (const std::exception& excp)
+        {
+            THROW_DBUSEXCEPTION("ConfigurationObject",
+                                "Failed to parse profile from '"
+                                + persistent_source() + "': "
+                                + std::string(excp.what()));
+        }
+        LogVerb2("Loaded deferred configuration profile from "
+                 + persistent_source());
+
+        // The search indexes did not have the remote entries yet
+        if (index_remotes)
+        {
+            update_callback();
+        }
+    }
+
+
+    /**
+     * @return Returns a std::string with the file the persistent
+     *         configuration is stored in
+     */
+    std::string persistent_source() const
+    {
+        return (state_log ? state_log->GetFilename() : persistent_file);
+    }
+
+
+    /**
+     *  Reads the "profile" section of this configuration from the
+     *  persistent storage, without parsing it.
+     *
+     * @return Returns a Json::Value with the profile section
+     *
+     * @throws DBusException if the profile could not be read
+     */
+    Json::Value read_persistent_profile() const
+    {
+        try
+        {
+            if (state_log)
+            {
+                return state_log->ReadProfile(GetObjectPath());
+            }
+
+            std::ifstream statefile(persistent_file, std::ifstream::binary);
+            if (!statefile.is_open())
+            {
+                throw std::runtime_error("Could not open file");
+            }
+            Json::Value data;
+            statefile >> data;
+            return data["profile"];
+        }
+        catch (const std::exception& excp)
+        {
+            THROW_DBUSEXCEPTION("ConfigurationObject",
+                                "Failed to load profile from '"
+                                + persistent_source() + "': "
+                                + std::string(excp.what()));
+        }
+    }
+
+
+    /**
+     * @return Returns true if this configuration is saved to disk, either
+     *         in its own file or in the state log
+     */
+    bool is_persistent() const noexcept
+    {
+        return nullptr != state_log || !persistent_file.empty();
+    }
+
+
     void initialize_configuration(const bool persistent)
     {
         std::stringstream msg;
-        msg << "Parsed"
+        msg << (profile_loaded ? "Parsed" : "Registered")
             << (persistent ? " persistent" : "")
             << (persistent && single_use ? "," : "")
             << (single_use ? " single-use" : "")
@@ -1029,6 +1737,17 @@ public:
             "        <method name='Fetch'>"
             "            <arg direction='out' type='s' name='config'/>"
             "        </method>"
+            "        <method name='FetchFD'/>"
+                     /* FetchFD returns the profile as a unix_fd, which
+                      * does not belong in the method signature; it is
+                      * passed as auxiliary data, see Establish in netcfg
+                      */
+            "        <method name='FetchEvaluated'>"
+            "            <arg direction='out' type='a{sv}' name='evaluation'/>"
+            "        </method>"
+                     /* FetchEvaluated passes the profile as a unix_fd
+                      * too, in addition to the evaluation result
+                      */
             "        <method name='FetchJSON'>"
             "            <arg direction='out' type='s' name='config_json'/>"
             "        </method>"
@@ -1063,24 +1782,191 @@ public:
     }
 
 
+    /**
+     *  Returns the configuration profile, in the same format as the Fetch
+     *  method, as a sealed memfd passed along with the D-Bus reply.
+     *
+     * @param invoc  GDBusMethodInvocation to respond to
+     * @param eval   Pointer to a ProfileEvaluation to return along with
+     *               the file descriptor, as done by FetchEvaluated.  May
+     *               be nullptr.
+     *
+     * @throws DBusException if the memfd could not be prepared
+     */
+    void return_profile_fd(GDBusMethodInvocation *invoc,
+                           const ProfileEvaluation *eval = nullptr)
+    {
+        int fd = -1;
+        try
+        {
+            fd = sealed_memfd_create("openvpn3-profile", profile_text());
+        }
+        catch (const SealedMemfdException& excp)
+        {
+            THROW_DBUSEXCEPTION("ConfigurationObject", excp.what());
+        }
+
+        GError *error = nullptr;
+        GUnixFDList *fdlist = g_unix_fd_list_new();
+        g_unix_fd_list_append(fdlist, fd, &error);
+        close(fd);
+        if (error)
+        {
+            GLibUtils::unref_fdlist(fdlist);
+            std::string err(error->message);
+            g_error_free(error);
+            THROW_DBUSEXCEPTION("ConfigurationObject",
+                                "Could not prepare the fd list: " + err);
+        }
+        GVariant *value = nullptr;
+        if (eval)
+        {
+            GVariant *evaldict = eval->GetGVariant();
+            value = g_variant_new_tuple(&evaldict, 1);
+        }
+        g_dbus_method_invocation_return_value_with_unix_fd_list(invoc,
+                                                                value,
+                                                                fdlist);
+        GLibUtils::unref_fdlist(fdlist);
+    }
+
+
+    /**
+     *  Discards the cached serialized forms and the evaluation of the
+     *  configuration profile.
+     *  This must be called each time the profile, the overrides, the
+     *  name or the access control list is modified.
+     */
+    void invalidate_export_cache() noexcept
+    {
+        export_cache.text_valid = false;
+        export_cache.eval_valid = false;
+    }
+
+
+    /**
+     *  Writes pending changes to the persistent configuration file
+     *  immediately.  This is called when the write-behind delay has
+     *  passed and must be called for all configuration objects before
+     *  the service shuts down.
+     */
+    void FlushPersistentFile()
+    {
+        cancel_persistent_write();
+        if (!persistent_dirty || !is_persistent())
+        {
+            return;
+        }
+
+        if (state_log)
+        {
+            try
+            {
+                load_profile();
+                Json::Value profile = export_persistent_profile();
+                state_log->Put(GetObjectPath(), ExportMetadata(), profile);
+                persistent_dirty = false;
+                LogVerb2("Updated persistent config in "
+                         + state_log->GetFilename());
+            }
+            catch (const ConfigStateLogException& excp)
+            {
+                LogError(excp.what());
+            }
+            catch (const InlineBlobStoreException& excp)
+            {
+                LogError(excp.what());
+            }
+            catch (const DBusException& excp)
+            {
+                LogError("Could not update persistent config: "
+                         + std::string(excp.what()));
+            }
+            return;
+        }
+
+        try
+        {
+            load_profile();
+            Json::Value cfg = ExportMetadata();
+            cfg["profile"] = export_persistent_profile();
+
+            std::stringstream data;
+            data << cfg;
+            write_file_atomic(persistent_file, data.str());
+            persistent_dirty = false;
+            LogVerb2("Updated persistent config: " + persistent_file);
+        }
+        catch (const AtomicFileException& excp)
+        {
+            // Keep it marked as dirty, so the next change or the
+            // shutdown will retry writing the file
+            LogError(excp.what());
+        }
+        catch (const InlineBlobStoreException& excp)
+        {
+            LogError(excp.what());
+        }
+        catch (const DBusException& excp)
+        {
+            LogError("Could not update persistent config "
+                     + persistent_file + ": " + excp.what());
+        }
+    }
+
+
+    /**
+     *  Marks the persistent configuration file as outdated.  The file
+     *  is written when no other changes have happened for
+     *  persistent_write_delay milliseconds, so a burst of changes only
+     *  results in a single write.
+     */
     void update_persistent_file()
     {
-        if (persistent_file.empty())
+        if (!is_persistent())
         {
             // If this configuration is not configured as persistent,
             // we're done.
             return;
         }
 
-        std::ofstream state(persistent_file);
-        state << Export();
-        state.close();
-        LogVerb2("Updated persistent config: " + persistent_file);
+        persistent_dirty = true;
+        cancel_persistent_write();
+        persistent_write_timer = g_timeout_add(persistent_write_delay,
+                                               _cb_persistent_write,
+                                               this);
+    }
+
+
+    /**
+     *  Cancels the scheduled write of the persistent configuration
+     *  file, if any.  The configuration is still kept marked as dirty.
+     */
+    void cancel_persistent_write()
+    {
+        if (0 < persistent_write_timer)
+        {
+            g_source_remove(persistent_write_timer);
+            persistent_write_timer = 0;
+        }
+    }
+
+
+    /**
+     *  GLib main loop callback used by update_persistent_file()
+     */
+    static gboolean _cb_persistent_write(gpointer data)
+    {
+        ConfigurationObject *obj = static_cast<ConfigurationObject *>(data);
+        obj->persistent_write_timer = 0;
+        obj->FlushPersistentFile();
+        return G_SOURCE_REMOVE;
     }
 
 
 private:
     std::function<void()> remove_callback;
+    std::function<void()> update_callback;
     std::string name;
     std::time_t import_tstamp;
     std::time_t last_use_tstamp;
@@ -1089,10 +1975,94 @@ private:
     bool readonly;
     bool single_use;
     bool locked_down;
+    bool profile_loaded = false;
+    bool remotes_known = false;  ///< remote_list is up-to-date
     PropertyCollection properties;
     std::string persistent_file;
-    OptionListJSON options;
+    ConfigStateLog *state_log = nullptr;
+    bool persistent_dirty = false;
+    guint persistent_write_timer = 0;
+
+    /// Write-behind delay of persistent configuration changes, in ms
+    static constexpr guint persistent_write_delay = 2000;
+    /// The parsed profile, with large inline payloads replaced by blob
+    /// IDs; kept packed as it is only read when the profile is exported
+    CompactOptionList options;
     std::vector<OverrideValue> override_list;
+    std::vector<ProfileEvaluation::Remote> remote_list;
+
+    /// Inline payloads smaller than this are kept in the options
+    static constexpr size_t inline_blob_min_size = 256;
+    InlineBlobStore *blob_store = nullptr;
+    /// Blob IDs of the inline payloads, indexed by option position.
+    /// Declared as members, so the references are also released if a
+    /// constructor fails.
+    InlineBlobRefs inline_blobs;
+    /// References to the blobs of a profile not parsed yet
+    InlineBlobRefs pending_blob_refs;
+
+    /**
+     *  Serializing the parsed profile is expensive, while the result only
+     *  changes when the configuration is modified.  The backend client
+     *  calls Fetch on each session start, so the plain text form and the
+     *  profile evaluation passed to the backend client are kept here
+     *  until invalidate_export_cache() is called.  The cached text does
+     *  not contain the inline payloads, which are only kept once in the
+     *  InlineBlobStore.  The JSON forms are only used by front-ends and
+     *  the persistent storage and are not cached.
+     */
+    struct ExportCache
+    {
+        bool text_valid = false;
+        bool eval_valid = false;
+        ProfileText text;
+        ProfileEvaluation eval;
+    };
+    mutable ExportCache export_cache;
+
+
+    /**
+     * @return Returns the configuration profile in the plain text format,
+     *         as returned by the Fetch method
+     *
+     * @throws DBusException if an inline payload could not be retrieved
+     */
+    std::string profile_text() const
+    {
+        if (!export_cache.text_valid)
+        {
+            OptionListJSON opts;
+            options.Expand(opts);
+            export_cache.text = ProfileText(opts, inline_blobs);
+            export_cache.text_valid = true;
+        }
+        try
+        {
+            return export_cache.text.Render([this](const std::string& id)
+                                            {
+                                                return blob_store->Get(id);
+                                            });
+        }
+        catch (const InlineBlobStoreException& excp)
+        {
+            THROW_DBUSEXCEPTION("ConfigurationObject", excp.what());
+        }
+    }
+
+
+    /**
+     * @return Returns the ProfileEvaluation of the configuration profile,
+     *         as returned by the FetchEvaluated method
+     */
+    const ProfileEvaluation& cached_profile_evaluation() const
+    {
+        if (!export_cache.eval_valid)
+        {
+            export_cache.eval = ProfileEvaluation::Evaluate(expanded_options());
+            export_cache.eval_valid = true;
+        }
+        return export_cache.eval;
+    }
 };
 
 
@@ -1147,9 +2117,29 @@ public:
                           << "          <arg type='b' name='persistent' direction='in'/>"
                           << "          <arg type='o' name='config_path' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='ImportBatch'>"
+                          << "          <arg type='a(ssbb)' name='configs' direction='in'/>"
+                          << "          <arg type='a(os)' name='results' direction='out'/>"
+                          << "        </method>"
+                          << "        <method name='ImportFD'>"
+                          << "          <arg type='s' name='name' direction='in'/>"
+                          << "          <arg type='b' name='single_use' direction='in'/>"
+                          << "          <arg type='b' name='persistent' direction='in'/>"
+                          << "          <arg type='o' name='config_path' direction='out'/>"
+                          << "        </method>"
+                          /* ImportFD also takes the profile as a unix_fd,
+                           * which does not belong in the method signature
+                           */
                           << "        <method name='FetchAvailableConfigs'>"
                           << "          <arg type='ao' name='paths' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='FetchAvailableConfigDetails'>"
+                          << "          <arg type='a{sv}' name='filter' direction='in'/>"
+                          << "          <arg type='u' name='offset' direction='in'/>"
+                          << "          <arg type='u' name='limit' direction='in'/>"
+                          << "          <arg type='u' name='total' direction='out'/>"
+                          << "          <arg type='a(osttuub)' name='configs' direction='out'/>"
+                          << "        </method>"
                           << "        <method name='LookupConfigName'>"
                           << "          <arg type='s' name='config_name' direction='in'/>"
                           << "          <arg type='ao' name='config_paths' direction='out'/>"
@@ -1170,10 +2160,44 @@ public:
     ~ConfigManagerObject()
     {
         LogVerb2("Shutting down");
+        if (0 < remote_index_source)
+        {
+            g_source_remove(remote_index_source);
+        }
         RemoveObject(dbuscon);
     }
 
 
+    /**
+     *  Enables lazy loading of persistent configuration profiles.  The
+     *  configuration objects are registered from the metadata index in
+     *  the state directory and each profile is only parsed when it is
+     *  used the first time.  This must be called before
+     *  SetStateDirectory().
+     *
+     * @param lazy  Bool enabling or disabling lazy loading
+     */
+    void SetLazyLoading(const bool lazy)
+    {
+        lazy_load = lazy;
+    }
+
+
+    /**
+     *  Stores all persistent configuration profiles in a single,
+     *  append-only log file (configs.log) in the state directory instead
+     *  of one file per profile.  Profiles found in the per-profile file
+     *  layout are migrated into the log file.  This must be called
+     *  before SetStateDirectory().
+     *
+     * @param enable  Bool enabling or disabling the state log
+     */
+    void SetStateLog(const bool enable)
+    {
+        use_state_log = enable;
+    }
+
+
     /**
      *  Sets the directory where the configuration manager should store
      *  persistent configuration profiles.
@@ -1192,21 +2216,82 @@ public:
                                 "State directory already set");
         }
         state_dir = stdir;
+        try
+        {
+            blob_store.SetDirectory(state_dir + "/blobs");
+        }
+        catch (const InlineBlobStoreException& excp)
+        {
+            THROW_DBUSEXCEPTION("ConfigManagerObject", excp.what());
+        }
 
-        // Load all the already saved persistent configurations before
-        // continuing.
-        for (const auto& fname : get_persistent_config_file_list(state_dir))
+        // Clean up after writes interrupted by a crash
+        size_t stale = remove_stale_atomic_files(state_dir)
+                       + remove_stale_atomic_files(state_dir + "/blobs");
+        if (0 < stale)
         {
-            try
-            {
-                import_persistent_configuration(fname);
-            }
-            catch (const DBusException& excp)
+            LogVerb1("Removed " + std::to_string(stale)
+                     + " stale temporary files in " + state_dir);
+        }
+
+        std::vector<std::string> files = get_persistent_config_file_list(state_dir);
+        std::vector<PersistentProfile> profiles;
+
+        // Set if any configuration is left on disk without being loaded.
+        // The inline blobs it refers to are then unknown.
+        bool incomplete = false;
+        if (use_state_log)
+        {
+            incomplete = !load_state_log(files, profiles);
+        }
+        else
+        {
+            if (lazy_load)
+            {
+                metadata_index.reset(new PersistentMetadataIndex(state_dir));
+                metadata_index->Load();
+                metadata_index->Prune(files);
+            }
+
+            // Files not covered by the metadata index needs to be parsed
+            profiles.resize(files.size());
+            for (size_t i = 0; i < files.size(); ++i)
+            {
+                profiles[i].fname = files[i];
+                if (metadata_index
+                    && metadata_index->Lookup(files[i], profiles[i].data))
+                {
+                    profiles[i].from_index = true;
+                }
+            }
+        }
+
+        // Load all the already saved persistent configurations before
+        // continuing.  Profiles are parsed in parallel, only the D-Bus
+        // registration happens here.
+        parse_persistent_profiles(profiles);
+
+        for (auto& prf : profiles)
+        {
+            if (!prf.error.empty())
+            {
+                LogCritical("Could not load persistent configuration "
+                            + prf.source() + ": " + prf.error);
+                incomplete = true;
+                continue;
+            }
+
+            try
+            {
+                register_persistent_configuration(prf);
+            }
+            catch (const DBusException& excp)
             {
+                incomplete = true;
                 std::string err(excp.what());
                 if (err.find("failed: An object is already exported for the interface") != std::string::npos)
                 {
-                    LogCritical("Could not import persistent configuration: " + fname);
+                    LogCritical("Could not import persistent configuration: " + prf.source());
                 }
                 else
                 {
@@ -1214,6 +2299,68 @@ public:
                 }
             }
         }
+        SaveMetadataIndex();
+        start_remote_indexing();
+
+        // Configurations which failed to load may still refer to blobs
+        // nothing else uses; removing them would make those
+        // configurations impossible to recover
+        if (incomplete)
+        {
+            LogWarn("Not all persistent configurations could be loaded, "
+                    "unreferenced inline blobs are kept");
+            return;
+        }
+        size_t pruned = blob_store.Prune();
+        if (0 < pruned)
+        {
+            LogVerb1("Removed " + std::to_string(pruned)
+                     + " unreferenced inline blobs");
+        }
+    }
+
+
+    /**
+     *  Writes all pending changes of the persistent configuration
+     *  objects to disk.  This must be called before the service
+     *  shuts down.
+     */
+    void FlushPersistentFiles()
+    {
+        for (const auto& cfg : config_objects)
+        {
+            cfg.second->FlushPersistentFile();
+        }
+    }
+
+
+    /**
+     *  Refreshes the persistent metadata index with the current state of
+     *  all persistent configuration objects and writes it to the state
+     *  directory.  This is called when the service shuts down, so the
+     *  next startup can register all unmodified configurations without
+     *  parsing them.
+     */
+    void SaveMetadataIndex()
+    {
+        if (!metadata_index)
+        {
+            return;
+        }
+
+        for (const auto& cfg : config_objects)
+        {
+            if (cfg.second->IsPersistent())
+            {
+                metadata_index->Update(cfg.second->GetPersistentFile(),
+                                       cfg.second->ExportMetadata());
+            }
+        }
+        if (!metadata_index->Save())
+        {
+            LogError("Could not save the persistent metadata index: "
+                     + metadata_index->GetFilename());
+        }
     }
 
 
@@ -1242,43 +2389,63 @@ public:
         IdleCheck_UpdateTimestamp();
         if ("Import" == method_name)
         {
-            // Import the configuration
-            std::string cfgpath = generate_path_uuid(OpenVPN3DBus_rootp_configuration, 'x');
-            ConfigurationObject *cfgobj;
-            cfgobj = new ConfigurationObject(dbuscon,
-                                             [self=Ptr(this), cfgpath]()
-                                             {
-                                                self->remove_config_object(cfgpath);
-                                             },
-                                             cfgpath,
-                                             GetLogLevel(),
-                                             GetLogWriterPtr(),
-                                             GetSignalBroadcast(),
-                                             creds.GetUID(sender),
-                                             state_dir,
-                                             params);
-
-            register_config_object(cfgobj, "created");
+            std::string cfgpath = import_configuration(sender, params);
             g_dbus_method_invocation_return_value(invoc, g_variant_new("(o)", cfgpath.c_str()));
         }
-        else if ("FetchAvailableConfigs" == method_name)
+        else if ("ImportBatch" == method_name)
         {
-            // Build up an array of object paths to available config objects
-            GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("ao"));
-            for (auto& item : config_objects)
-            {
-                try {
-                    // We check if the caller is allowed to access this
-                    // configuration object.  If not, an exception is thrown
-                    // and we will just ignore that exception and continue
-                    item.second->CheckACL(sender);
-                    g_variant_builder_add(bld, "o", item.first.c_str());
+            try
+            {
+                GVariant *res = import_batch(sender, params);
+                g_dbus_method_invocation_return_value(invoc, res);
+            }
+            catch (DBusException& excp)
+            {
+                LogError(excp.what());
+                excp.SetDBusError(invoc, "net.openvpn.v3.configmgr.error");
+            }
+            return;
+        }
+        else if ("ImportFD" == method_name)
+        {
+            try
+            {
+                ConfigurationObject::ParsedProfile parsed;
+                GVariant *import_params = read_import_fd(invoc, params,
+                                                         parsed);
+                std::string cfgpath;
+                try
+                {
+                    cfgpath = import_configuration(sender, import_params,
+                                                   &parsed);
                 }
-                catch (DBusCredentialsException& excp)
+                catch (...)
                 {
-                    // Ignore credentials exceptions.  It means the
-                    // caller does not have access this configuration object
+                    // The blobs of parsed are released when it goes out
+                    // of scope
+                    g_variant_unref(import_params);
+                    throw;
                 }
+                g_variant_unref(import_params);
+                g_dbus_method_invocation_return_value(invoc, g_variant_new("(o)", cfgpath.c_str()));
+            }
+            catch (DBusException& excp)
+            {
+                LogError(excp.what());
+                excp.SetDBusError(invoc, "net.openvpn.v3.configmgr.error");
+            }
+            return;
+        }
+        else if ("FetchAvailableConfigs" == method_name)
+        {
+            // Build up an array of object paths to available config objects.
+            // The index only contains the objects the caller is allowed
+            // to access
+            GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("ao"));
+            uid_t caller = creds.GetUID(sender);
+            for (const auto& path : config_index.AccessibleBy(caller))
+            {
+                g_variant_builder_add(bld, "o", path.c_str());
             }
 
             // Wrap up the result into a tuple, which GDBus expects and
@@ -1292,6 +2459,20 @@ public:
             g_variant_builder_unref(bld);
             g_variant_builder_unref(ret);
         }
+        else if ("FetchAvailableConfigDetails" == method_name)
+        {
+            try
+            {
+                GVariant *res = fetch_config_details(creds.GetUID(sender),
+                                                     params);
+                g_dbus_method_invocation_return_value(invoc, res);
+            }
+            catch (DBusException& excp)
+            {
+                excp.SetDBusError(invoc, "net.openvpn.v3.error.filter");
+            }
+            return;
+        }
         else if ("LookupConfigName" == method_name)
         {
             gchar *cfgname_c = nullptr;
@@ -1309,26 +2490,12 @@ public:
             g_free(cfgname_c);
 
             // Build up an array of object paths to available config objects
+            // with this name the caller is allowed to access
             GVariantBuilder *found_paths = g_variant_builder_new(G_VARIANT_TYPE("ao"));
-            for (const auto& item : config_objects)
+            uid_t caller = creds.GetUID(sender);
+            for (const auto& path : config_index.LookupName(cfgname, caller))
             {
-                if (item.second->GetConfigName() == cfgname)
-                {
-                    try
-                    {
-                        // We check if the caller is allowed to access this
-                        // configuration object.  If not, an exception is thrown
-                        // and we will just ignore that exception and continue
-                        item.second->CheckACL(sender);
-                        g_variant_builder_add(found_paths,
-                                              "o", item.first.c_str());
-                    }
-                    catch (DBusCredentialsException& excp)
-                    {
-                        // Ignore credentials exceptions.  It means the
-                        // caller does not have access this configuration object
-                    }
-                }
+                g_variant_builder_add(found_paths, "o", path.c_str());
             }
             g_dbus_method_invocation_return_value(invoc, GLibUtils::wrapInTuple(found_paths));
             return;
@@ -1351,22 +2518,23 @@ public:
             uid_t new_uid = 0;
             g_variant_get(params, "(ou)", &cfgpath, &new_uid);
 
-            for (const auto& ci : config_objects)
+            auto ci = config_objects.find(cfgpath);
+            if (config_objects.end() != ci)
             {
-                if (ci.first == cfgpath)
-                {
-                    uid_t cur_owner = ci.second->GetOwnerUID();
-                    ci.second->TransferOwnership(new_uid);
-                    g_dbus_method_invocation_return_value(invoc, NULL);
+                uid_t cur_owner = ci->second->GetOwnerUID();
+                ci->second->TransferOwnership(new_uid);
+                update_config_index(ci->first);
+                g_dbus_method_invocation_return_value(invoc, NULL);
 
-                    std::stringstream msg;
-                    msg << "Transfered ownership from " << cur_owner
-                        << " to " << new_uid
-                        << " on configuration " << cfgpath;
-                    LogInfo(msg.str());
-                    return;
-                }
+                std::stringstream msg;
+                msg << "Transfered ownership from " << cur_owner
+                    << " to " << new_uid
+                    << " on configuration " << cfgpath;
+                LogInfo(msg.str());
+                g_free(cfgpath);
+                return;
             }
+            g_free(cfgpath);
             GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.path",
                                                           "Invalid configuration path");
             g_dbus_method_invocation_return_gerror(invoc, err);
@@ -1454,6 +2622,14 @@ private:
     DBusConnectionCreds creds;
     std::string state_dir;
     std::map<std::string, ConfigurationObject *> config_objects;
+    ConfigurationIndex config_index;
+    bool lazy_load = false;
+    std::unique_ptr<PersistentMetadataIndex> metadata_index;
+    bool use_state_log = false;
+    std::unique_ptr<ConfigStateLog> state_log;
+    InlineBlobStore blob_store;
+    std::deque<std::string> remote_index_queue;
+    guint remote_index_source = 0;
 
 
     /**
@@ -1472,6 +2648,7 @@ private:
         cfgobj->IdleCheck_Register(IdleCheck_Get());
         cfgobj->RegisterObject(dbuscon);
         config_objects[cfgobj->GetObjectPath()] = cfgobj;
+        update_config_index(cfgobj->GetObjectPath());
 
         Debug("New configuration object " + operation + ": "
               + cfgobj->GetObjectPath()
@@ -1479,6 +2656,144 @@ private:
     }
 
 
+    /**
+     *  Builds the response of the FetchAvailableConfigDetails method; a
+     *  list of details for all configuration objects the caller has access
+     *  to and which matches the filter provided by the caller.
+     *
+     *  Supported filter keys:
+     *    - owner        (u)  Only configurations owned by this UID
+     *    - name_prefix  (s)  Only configurations where the name starts with
+     *                        this string
+     *    - persistent   (b)  If true, only persistent configurations
+     *    - remote_host  (s)  Only configurations with this remote host
+     *    - remote_port  (s)  Only configurations with a remote using this
+     *                        port
+     *    - remote_proto (s)  Only configurations with a remote using this
+     *                        protocol.  Combined with remote_port, both
+     *                        must match the same remote entry.
+     *    - override     (s)  Only configurations with this override set.
+     *                        With "name=value", the override must also
+     *                        have this value.
+     *
+     *  All filters except persistent are answered by the indexes kept in
+     *  ConfigurationIndex.
+     *
+     * @param caller  uid_t of the D-Bus caller
+     * @param params  GVariant object with the method call arguments
+     *
+     * @return  Returns a GVariant tuple with the total number of matching
+     *          configurations and the requested slice of them.
+     *
+     * @throws  DBusException if an unknown filter key is used
+     */
+    GVariant * fetch_config_details(const uid_t caller, GVariant *params)
+    {
+        GLibUtils::checkParams(__func__, params, "(a{sv}uu)", 3);
+        GVariant *filter = g_variant_get_child_value(params, 0);
+        guint32 offset = GLibUtils::ExtractValue<uint32_t>(params, 1);
+        guint32 limit = GLibUtils::ExtractValue<uint32_t>(params, 2);
+
+        ConfigurationIndex::Query query;
+        bool persistent_only = false;
+
+        GVariantIter iter;
+        gchar *key = nullptr;
+        GVariant *val = nullptr;
+        g_variant_iter_init(&iter, filter);
+        while (g_variant_iter_next(&iter, "{sv}", &key, &val))
+        {
+            std::string k(key);
+            std::string type(g_variant_get_type_string(val));
+            if ("owner" == k && "u" == type)
+            {
+                query.owner_set = true;
+                query.owner = g_variant_get_uint32(val);
+            }
+            else if ("name_prefix" == k && "s" == type)
+            {
+                query.name_prefix = GLibUtils::GetVariantValue<std::string>(val);
+            }
+            else if ("persistent" == k && "b" == type)
+            {
+                persistent_only = g_variant_get_boolean(val);
+            }
+            else if ("remote_host" == k && "s" == type)
+            {
+                query.remote_host = GLibUtils::GetVariantValue<std::string>(val);
+            }
+            else if ("remote_port" == k && "s" == type)
+            {
+                query.remote_port = GLibUtils::GetVariantValue<std::string>(val);
+            }
+            else if ("remote_proto" == k && "s" == type)
+            {
+                query.remote_proto = GLibUtils::GetVariantValue<std::string>(val);
+            }
+            else if ("override" == k && "s" == type)
+            {
+                std::string ov = GLibUtils::GetVariantValue<std::string>(val);
+                size_t sep = ov.find('=');
+                query.override_name = ov.substr(0, sep);
+                if (std::string::npos != sep)
+                {
+                    query.override_value_set = true;
+                    query.override_value = ov.substr(sep + 1);
+                }
+            }
+            else
+            {
+                g_free(key);
+                g_variant_unref(val);
+                g_variant_unref(filter);
+                THROW_DBUSEXCEPTION("ConfigManagerObject",
+                                    "Invalid filter '" + k + "' ("
+                                    + type + ")");
+            }
+            g_free(key);
+            g_variant_unref(val);
+        }
+        g_variant_unref(filter);
+
+        ConfigurationIndex::PathList paths = config_index.Search(query, caller);
+
+        GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("a(osttuub)"));
+        guint32 total = 0;
+        for (const auto& p : paths)
+        {
+            auto it = config_objects.find(p);
+            if (config_objects.end() == it)
+            {
+                continue;
+            }
+            const ConfigurationObject *cfg = it->second;
+            if (persistent_only && !cfg->IsPersistent())
+            {
+                continue;
+            }
+
+            ++total;
+            if (total <= offset
+                || (0 < limit && total > (guint64) offset + limit))
+            {
+                // Outside the requested page, just count it
+                continue;
+            }
+            g_variant_builder_add(bld, "(osttuub)",
+                                  p.c_str(),
+                                  cfg->GetConfigName().c_str(),
+                                  (guint64) cfg->GetImportTimestamp(),
+                                  (guint64) cfg->GetLastUsedTimestamp(),
+                                  (guint32) cfg->GetOwnerUID(),
+                                  (guint32) cfg->GetUsedCount(),
+                                  cfg->IsPersistent());
+        }
+        GVariant *configs = g_variant_builder_end(bld);
+        g_variant_builder_unref(bld);
+        return g_variant_new("(u@a(osttuub))", total, configs);
+    }
+
+
     /**
      *  Get a list (std::vector<std::string>) of all persistent configuration
      *  files in the given directory.
@@ -1561,47 +2876,565 @@ private:
 
 
     /**
-     *  Loads a persistent configuration file from the file system.  It
-     *  will register the configuration with the D-Bus path provided in
-     *  the file.
+     *  A persistent configuration file being loaded at startup
+     */
+    struct PersistentProfile
+    {
+        std::string fname;          ///< Persistent configuration file
+        ConfigStateLog *log = nullptr; ///< State log, if not in a file
+        Json::Value data;           ///< File contents or indexed metadata
+        bool from_index = false;    ///< data is from the metadata index
+        std::unique_ptr<ConfigurationObject::ParsedProfile> parsed; ///< Parsed profile
+        std::string error;          ///< Set if loading the file failed
+
+        /// Describes where the configuration is loaded from, for logging
+        std::string source() const
+        {
+            return (log ? data["object_path"].asString() + " in "
+                          + log->GetFilename()
+                        : fname);
+        }
+    };
+
+
+    /**
+     *  Loads the state log from the state directory, migrating any
+     *  configuration stored in the per-profile file layout into it.
+     *
+     * @param files     std::vector<std::string> of persistent configuration
+     *                  files found in the state directory
+     * @param profiles  std::vector<PersistentProfile> where the
+     *                  configurations to register will be added
+     *
+     * @return  Returns false if any of the files could not be migrated
+     */
+    bool load_state_log(const std::vector<std::string>& files,
+                        std::vector<PersistentProfile>& profiles)
+    {
+        bool migrated = true;
+        state_log.reset(new ConfigStateLog(state_dir));
+        ConfigStateLog::MetadataMap stored;
+        try
+        {
+            stored = state_log->Load();
+            if (0 < state_log->DiscardedBytes())
+            {
+                LogWarn("Discarded an incomplete record ("
+                        + std::to_string(state_log->DiscardedBytes())
+                        + " bytes) at the end of "
+                        + state_log->GetFilename());
+            }
+            if (0 < state_log->SkippedRecords())
+            {
+                LogWarn("Skipped "
+                        + std::to_string(state_log->SkippedRecords())
+                        + " damaged record(s) in "
+                        + state_log->GetFilename());
+            }
+
+            for (const auto& fname : files)
+            {
+                migrated &= migrate_to_state_log(fname, stored);
+            }
+        }
+        catch (const ConfigStateLogException& excp)
+        {
+            THROW_DBUSEXCEPTION("ConfigManagerObject", excp.what());
+        }
+
+        for (auto& md : stored)
+        {
+            PersistentProfile prf;
+            prf.log = state_log.get();
+            prf.data = std::move(md.second);
+
+            // With lazy loading, the profiles are parsed when first used
+            prf.from_index = lazy_load;
+            profiles.push_back(std::move(prf));
+        }
+        return migrated;
+    }
+
+
+    /**
+     *  Moves a configuration from its own persistent configuration file
+     *  into the state log.  The file is removed once the configuration
+     *  has been safely stored in the log.  Files which cannot be parsed
+     *  are left untouched.
+     *
+     * @param fname   std::string with the configuration file to migrate
+     * @param stored  ConfigStateLog::MetadataMap with the configurations
+     *                in the state log, which will be updated
+     *
+     * @return  Returns true if the file was migrated
+     */
+    bool migrate_to_state_log(const std::string& fname,
+                              ConfigStateLog::MetadataMap& stored)
+    {
+        Json::Value data;
+        try
+        {
+            std::ifstream statefile(fname, std::ifstream::binary);
+            statefile >> data;
+        }
+        catch (const std::exception& excp)
+        {
+            LogCritical("Could not migrate persistent configuration "
+                        + fname + ": " + excp.what());
+            return false;
+        }
+
+        std::string cfgpath = data["object_path"].asString();
+        if (!state_log->Exists(cfgpath))
+        {
+            Json::Value profile = data["profile"];
+            data.removeMember("profile");
+            state_log->Put(cfgpath, data, profile);
+            stored[cfgpath] = data;
+        }
+        unlink(fname.c_str());
+        LogInfo("Migrated persistent configuration " + fname
+                + " to " + state_log->GetFilename());
+        return true;
+    }
+
+
+    /**
+     *  Reads and parses a persistent configuration file.  This is run
+     *  by the worker threads of parse_persistent_profiles() and must not
+     *  touch anything outside of the PersistentProfile object.
      *
      *  The file must be a JSON formatted text file based on the file
      *  format generated by @ConfigurationObject::Export()
      *
-     * @param fname  std::string with the filename to import
+     * @param prf  PersistentProfile to load
+     */
+    static void parse_persistent_file(PersistentProfile& prf,
+                                      InlineBlobStore *blob_store)
+    {
+        try
+        {
+            if (prf.log)
+            {
+                prf.parsed.reset(new ConfigurationObject::ParsedProfile());
+                Json::Value profile = prf.log->ReadProfile(prf.data["object_path"].asString());
+                ConfigurationObject::ParseProfile(profile, *prf.parsed,
+                                                  blob_store);
+                return;
+            }
+
+            std::ifstream statefile(prf.fname, std::ifstream::binary);
+            if (!statefile.is_open())
+            {
+                prf.error = "Could not open the file";
+                return;
+            }
+            statefile >> prf.data;
+            statefile.close();
+
+            prf.parsed.reset(new ConfigurationObject::ParsedProfile());
+            ConfigurationObject::ParseProfile(prf.data["profile"],
+                                              *prf.parsed, blob_store);
+        }
+        catch (const std::exception& excp)
+        {
+            prf.parsed.reset();
+            prf.error = std::string(excp.what());
+        }
+    }
+
+
+    /**
+     *  Parses all the persistent configuration files not found in the
+     *  metadata index, using one worker thread per available CPU core.
+     *  Errors are recorded in each PersistentProfile object, so a
+     *  failing file does not affect the rest.
+     *
+     * @param profiles  std::vector<PersistentProfile> of the files to load
      */
-    void import_persistent_configuration(const std::string& fname)
+    void parse_persistent_profiles(std::vector<PersistentProfile>& profiles)
     {
-        LogVerb1("Loading persistent configuration: " + fname);
+        std::vector<PersistentProfile *> jobs;
+        for (auto& prf : profiles)
+        {
+            if (!prf.from_index)
+            {
+                jobs.push_back(&prf);
+            }
+        }
+        if (jobs.empty())
+        {
+            return;
+        }
 
-        // Load the JSON file and parse it
-        std::ifstream statefile(fname, std::ifstream::binary);
-        Json::Value data;
-        statefile >> data;
-        statefile.close();
+        InlineBlobStore *blobs = &blob_store;
+        size_t num_threads = parallel_for(jobs.size(),
+                                          [&jobs, blobs](size_t i)
+                                          {
+                                              parse_persistent_file(*jobs[i],
+                                                                    blobs);
+                                          });
+        LogVerb2("Parsed " + std::to_string(jobs.size())
+                 + " persistent configurations using "
+                 + std::to_string(num_threads) + " threads");
+    }
+
+
+    /**
+     *  Runs a function for each index in [0, count), spread over one
+     *  worker thread per available CPU core.  The calling thread is one
+     *  of the workers.  The function must not throw exceptions and must
+     *  not touch anything shared without proper locking.
+     *
+     * @param count  Number of items to process
+     * @param func   Function called with the index of each item
+     *
+     * @return Returns the number of threads used
+     */
+    static size_t parallel_for(const size_t count,
+                               const std::function<void(size_t)>& func)
+    {
+        std::atomic<size_t> next(0);
+        auto worker = [count, &next, &func]()
+                      {
+                          for (size_t i = next++; i < count; i = next++)
+                          {
+                              func(i);
+                          }
+                      };
+
+        size_t num_threads = std::max(1U, std::thread::hardware_concurrency());
+        num_threads = std::min(num_threads, count);
+
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < num_threads; ++t)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        return num_threads;
+    }
+
+
+    /**
+     *  Registers a loaded persistent configuration on the D-Bus, using
+     *  the D-Bus path provided in the file.
+     *
+     * @param prf  PersistentProfile which has been loaded
+     */
+    void register_persistent_configuration(PersistentProfile& prf)
+    {
+        LogVerb1((prf.from_index ? "Registering" : "Loading")
+                 + std::string(" persistent configuration: ") + prf.source());
 
         // Extract the configuration path and prepare the
         // remove callback function required to create the
         // configuration object
-        std::string cfgpath = data["object_path"].asString();
-        auto remove_cb = [self=Ptr(this), cfgpath]()
+        std::string cfgpath = prf.data["object_path"].asString();
+
+        // If registering fails, the object path may belong to another
+        // configuration object.  Removing this object must then not
+        // touch the entry of the other one.
+        auto registered = std::make_shared<bool>(false);
+        auto remove_cb = [self=Ptr(this), cfgpath, registered]()
                            {
-                              self->remove_config_object(cfgpath);
+                              if (*registered)
+                              {
+                                  self->remove_config_object(cfgpath);
+                              }
+                           };
+        auto update_cb = [self=Ptr(this), cfgpath]()
+                           {
+                              self->update_config_index(cfgpath);
                            };
 
         // Create the internal representation of the configuration,
         // which is used when registering the configuration on the D-Bus
+        ConfigurationObject *cfgobj = nullptr;
+        try
+        {
+            cfgobj = new ConfigurationObject(dbuscon,
+                                             prf.fname,
+                                             prf.log,
+                                             &blob_store,
+                                             prf.data,
+                                             prf.parsed.get(),
+                                             remove_cb,
+                                             update_cb,
+                                             GetLogLevel(),
+                                             GetLogWriterPtr(),
+                                             GetSignalBroadcast());
+        }
+        catch (...)
+        {
+            // Releases the blobs not yet moved into the object
+            prf.parsed.reset();
+            throw;
+        }
+        prf.parsed.reset();
+
+        // Register the configuration object in this D-Bus service
+        try
+        {
+            register_config_object(cfgobj, "loaded");
+        }
+        catch (...)
+        {
+            // Releases the inline blob references the object holds
+            delete cfgobj;
+            throw;
+        }
+        *registered = true;
+
+        if (metadata_index
+            && (!prf.from_index || !prf.data.isMember("remotes")))
+        {
+            metadata_index->Update(prf.fname, cfgobj->ExportMetadata());
+        }
+    }
+
+
+    /**
+     *  Creates a new configuration object and registers it on the D-Bus
+     *
+     * @param sender  std::string with the D-Bus bus name of the caller,
+     *                which becomes the owner of the configuration
+     * @param params  GVariant object with the arguments of the Import
+     *                method
+     * @param parsed  Pointer to a ParsedProfile with the profile in params
+     *                already parsed.  May be nullptr.
+     *
+     * @return Returns a std::string with the D-Bus object path of the new
+     *         configuration object
+     */
+    std::string import_configuration(const std::string& sender,
+                                     GVariant *params,
+                                     ConfigurationObject::ParsedProfile *parsed = nullptr)
+    {
+        std::string cfgpath = generate_path_uuid(OpenVPN3DBus_rootp_configuration, 'x');
         ConfigurationObject *cfgobj;
         cfgobj = new ConfigurationObject(dbuscon,
-                                         fname,
-                                         data,
-                                         remove_cb,
+                                         [self=Ptr(this), cfgpath]()
+                                         {
+                                            self->remove_config_object(cfgpath);
+                                         },
+                                         [self=Ptr(this), cfgpath]()
+                                         {
+                                            self->update_config_index(cfgpath);
+                                         },
+                                         cfgpath,
                                          GetLogLevel(),
                                          GetLogWriterPtr(),
-                                         GetSignalBroadcast());
+                                         GetSignalBroadcast(),
+                                         creds.GetUID(sender),
+                                         state_dir,
+                                         state_log.get(),
+                                         &blob_store,
+                                         params,
+                                         parsed);
+
+        register_config_object(cfgobj, "created");
+        return cfgpath;
+    }
 
-        // Register the configuration object in this D-Bus service
-        register_config_object(cfgobj, "loaded");
+
+    /**
+     *  Imports several configuration profiles in one operation.  The
+     *  profiles are parsed in parallel and then registered on the D-Bus.
+     *  A profile failing to import does not stop the others.
+     *
+     * @param sender  std::string with the D-Bus bus name of the caller
+     * @param params  GVariant object with the ImportBatch arguments; an
+     *                array of the same (name, profile, single_use,
+     *                persistent) tuples the Import method takes
+     *
+     * @return Returns a GVariant tuple with an array of (object path,
+     *         error message) tuples, in the same order as the input.  On
+     *         success the error message is empty, on failure the object
+     *         path is "/".
+     */
+    GVariant * import_batch(const std::string& sender, GVariant *params)
+    {
+        GLibUtils::checkParams(__func__, params, "(a(ssbb))", 1);
+        GVariant *configs = g_variant_get_child_value(params, 0);
+
+        // Anything still held by an item, the Import arguments and the
+        // blobs of a profile which was not imported, is released when
+        // the batch goes out of scope
+        struct BatchItem
+        {
+            BatchItem() = default;
+            BatchItem(const BatchItem&) = delete;
+            BatchItem& operator=(const BatchItem&) = delete;
+            ~BatchItem()
+            {
+                if (params)
+                {
+                    g_variant_unref(params);
+                }
+            }
+
+            GVariant *params = nullptr;
+            ConfigurationObject::ParsedProfile parsed;
+            std::string path;
+            std::string error;
+        };
+        std::vector<BatchItem> batch(g_variant_n_children(configs));
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            batch[i].params = g_variant_get_child_value(configs, i);
+        }
+        g_variant_unref(configs);
+
+        InlineBlobStore *blobs = &blob_store;
+        parallel_for(batch.size(),
+                     [&batch, blobs](size_t i)
+                     {
+                         try
+                         {
+                             std::string cfgstr = GLibUtils::ExtractValue<std::string>(batch[i].params, 1);
+                             ConfigurationObject::ParseImportProfile(cfgstr,
+                                                                     batch[i].parsed,
+                                                                     blobs);
+                         }
+                         catch (const std::exception& excp)
+                         {
+                             batch[i].error = std::string(excp.what());
+                         }
+                     });
+
+        size_t imported = 0;
+        for (auto& item : batch)
+        {
+            if (!item.error.empty())
+            {
+                continue;
+            }
+            try
+            {
+                item.path = import_configuration(sender, item.params,
+                                                 &item.parsed);
+                ++imported;
+            }
+            catch (const std::exception& excp)
+            {
+                item.error = std::string(excp.what());
+            }
+        }
+
+        GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("a(os)"));
+        for (const auto& item : batch)
+        {
+            g_variant_builder_add(bld, "(os)",
+                                  (item.path.empty() ? "/" : item.path.c_str()),
+                                  item.error.c_str());
+        }
+
+        LogInfo("Imported " + std::to_string(imported) + " of "
+                + std::to_string(batch.size()) + " configurations in a batch");
+
+        GVariantBuilder *ret = g_variant_builder_new(G_VARIANT_TYPE_TUPLE);
+        g_variant_builder_add_value(ret, g_variant_builder_end(bld));
+        GVariant *res = g_variant_builder_end(ret);
+        g_variant_builder_unref(bld);
+        g_variant_builder_unref(ret);
+        return res;
+    }
+
+
+    /**
+     *  Parses the configuration profile passed as a sealed memfd to the
+     *  ImportFD method, directly from a read-only mapping of the memfd.
+     *  The request is converted into the arguments of the Import method,
+     *  without the profile itself.
+     *
+     * @param invoc   GDBusMethodInvocation of the ImportFD call
+     * @param params  GVariant object with the ImportFD arguments
+     * @param parsed  ParsedProfile where the parsed profile is stored
+     *
+     * @return Returns a GVariant object with the Import method arguments.
+     *         The caller must unref it.
+     *
+     * @throws DBusException if the profile could not be retrieved or
+     *         parsed
+     */
+    GVariant * read_import_fd(GDBusMethodInvocation *invoc, GVariant *params,
+                              ConfigurationObject::ParsedProfile& parsed)
+    {
+        GLibUtils::checkParams(__func__, params, "(sbb)", 3);
+
+        GDBusMessage *dmsg = g_dbus_method_invocation_get_message(invoc);
+        GUnixFDList *fdlist = g_dbus_message_get_unix_fd_list(dmsg);
+        if (nullptr == fdlist || 1 != g_unix_fd_list_get_length(fdlist))
+        {
+            THROW_DBUSEXCEPTION("ConfigManagerObject",
+                                "ImportFD requires a single file descriptor");
+        }
+
+        GError *error = nullptr;
+        int fd = g_unix_fd_list_get(fdlist, 0, &error);
+        if (error)
+        {
+            std::string err(error->message);
+            g_error_free(error);
+            THROW_DBUSEXCEPTION("ConfigManagerObject",
+                                "Could not retrieve the file descriptor: "
+                                + err);
+        }
+
+        size_t len = 0;
+        const char *cfg = nullptr;
+        try
+        {
+            cfg = sealed_memfd_map(fd, ProfileParseLimits::MAX_PROFILE_SIZE,
+                                   len);
+            close(fd);
+        }
+        catch (const SealedMemfdException& excp)
+        {
+            close(fd);
+            THROW_DBUSEXCEPTION("ConfigManagerObject", excp.what());
+        }
+
+        // A profile is text; the Import method cannot carry NUL bytes
+        // either, so the same profile is accepted by both methods
+        std::string err;
+        if (nullptr != cfg && nullptr != memchr(cfg, '\0', len))
+        {
+            err = "The configuration profile contains NUL bytes";
+        }
+        else
+        {
+            try
+            {
+                ConfigurationObject::ParseImportProfile((cfg ? std::string(cfg, len)
+                                                         : std::string()),
+                                                        parsed, &blob_store);
+            }
+            catch (const std::exception& excp)
+            {
+                err = std::string(excp.what());
+            }
+        }
+        if (nullptr != cfg)
+        {
+            munmap(const_cast<char *>(cfg), len);
+        }
+        if (!err.empty())
+        {
+            THROW_DBUSEXCEPTION("ConfigManagerObject", err);
+        }
+
+        GVariant *ret = g_variant_new("(ssbb)",
+                                      GLibUtils::ExtractValue<std::string>(params, 0).c_str(),
+                                      "",
+                                      GLibUtils::ExtractValue<bool>(params, 1),
+                                      GLibUtils::ExtractValue<bool>(params, 2));
+        return g_variant_ref_sink(ret);
     }
 
 
@@ -1616,6 +3449,106 @@ private:
     void remove_config_object(const std::string cfgpath)
     {
         config_objects.erase(cfgpath);
+        config_index.Remove(cfgpath);
+    }
+
+
+    /**
+     *  Starts looking up the remote entries of the registered
+     *  configurations where these are not known.  This is the case for
+     *  lazy loaded configurations saved by older versions.  Each profile
+     *  is handled in a separate GLib main loop idle callback, so D-Bus
+     *  requests are not held up.
+     */
+    void start_remote_indexing()
+    {
+        for (const auto& cfg : config_objects)
+        {
+            if (!cfg.second->RemotesKnown())
+            {
+                remote_index_queue.push_back(cfg.first);
+            }
+        }
+        if (remote_index_queue.empty() || 0 < remote_index_source)
+        {
+            return;
+        }
+        LogVerb1("Indexing remote entries of "
+                 + std::to_string(remote_index_queue.size())
+                 + " configurations in the background");
+        remote_index_source = g_idle_add(_cb_index_remotes, this);
+    }
+
+
+    /**
+     *  GLib main loop callback used by start_remote_indexing()
+     */
+    static gboolean _cb_index_remotes(gpointer data)
+    {
+        ConfigManagerObject *mgr = static_cast<ConfigManagerObject *>(data);
+        return mgr->index_next_remotes();
+    }
+
+
+    /**
+     *  Looks up the remote entries of the next configuration queued by
+     *  start_remote_indexing().  The metadata index is saved once the
+     *  queue is empty, so the next start-up does not need to do this
+     *  again.
+     *
+     * @return Returns G_SOURCE_CONTINUE while more configurations are
+     *         queued, otherwise G_SOURCE_REMOVE
+     */
+    gboolean index_next_remotes()
+    {
+        if (!remote_index_queue.empty())
+        {
+            auto it = config_objects.find(remote_index_queue.front());
+            remote_index_queue.pop_front();
+            if (config_objects.end() != it)
+            {
+                try
+                {
+                    it->second->IndexRemotes();
+                }
+                catch (const DBusException& excp)
+                {
+                    LogWarn(excp.what());
+                }
+            }
+        }
+        if (!remote_index_queue.empty())
+        {
+            return G_SOURCE_CONTINUE;
+        }
+        remote_index_source = 0;
+        SaveMetadataIndex();
+        return G_SOURCE_REMOVE;
+    }
+
+
+    /**
+     *  Refreshes the name, access control information and search
+     *  attributes of a configuration object in the lookup indexes.  This is also used by
+     *  ConfigurationObject instances, whenever these details changes.
+     *
+     * @param cfgpath  std::string containing the object path to the object
+     *                 to update
+     */
+    void update_config_index(const std::string cfgpath)
+    {
+        auto it = config_objects.find(cfgpath);
+        if (config_objects.end() == it)
+        {
+            return;
+        }
+        ConfigurationObject *cfgobj = it->second;
+        config_index.Update(cfgpath,
+                            cfgobj->GetConfigName(),
+                            cfgobj->GetOwnerUID(),
+                            cfgobj->GetAccessList(),
+                            cfgobj->GetPublicAccess(),
+                            cfgobj->GetSearchAttributes());
     }
 };
 
@@ -1657,6 +3590,11 @@ public:
 
     ~ConfigManagerDBus()
     {
+        if (cfgmgr)
+        {
+            cfgmgr->FlushPersistentFiles();
+            cfgmgr->SaveMetadataIndex();
+        }
         procsig->ProcessChange(StatusMinor::PROC_STOPPED);
     }
 
@@ -1687,6 +3625,30 @@ public:
     }
 
 
+    /**
+     *  Enables lazy loading of persistent configuration profiles.  See
+     *  ConfigManagerObject::SetLazyLoading() for details.
+     *
+     * @param lazy  Bool enabling or disabling lazy loading
+     */
+    void SetLazyLoading(const bool lazy)
+    {
+        lazy_load = lazy;
+    }
+
+
+    /**
+     *  Stores persistent configurations in a single log file.  See
+     *  ConfigManagerObject::SetStateLog() for details.
+     *
+     * @param enable  Bool enabling or disabling the state log
+     */
+    void SetStateLog(const bool enable)
+    {
+        use_state_log = enable;
+    }
+
+
     /**
      *  This callback is called when the service was successfully registered
      *  on the D-Bus.
@@ -1700,6 +3662,8 @@ public:
 
         if (!state_dir.empty())
         {
+            cfgmgr->SetLazyLoading(lazy_load);
+            cfgmgr->SetStateLog(use_state_log);
             cfgmgr->SetStateDirectory(state_dir);
         }
         procsig->ProcessChange(StatusMinor::PROC_STARTED);
@@ -1746,6 +3710,8 @@ private:
     LogWriter *logwr = nullptr;
     bool signal_broadcast = true;
     std::string state_dir = "";
+    bool lazy_load = false;
+    bool use_state_log = false;
     ConfigManagerObject::Ptr cfgmgr;
     ProcessSignalProducer::Ptr procsig;
 };
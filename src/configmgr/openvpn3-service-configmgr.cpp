@@ -98,6 +98,8 @@ static int config_manager(ParsedArgs args)
     if (args.Present("state-dir"))
     {
         cfgmgr.SetStateDirectory(args.GetValue("state-dir", 0));
+        cfgmgr.SetLazyLoading(args.Present("lazy-load"));
+        cfgmgr.SetStateLog(args.Present("state-log"));
         umask(077);
     }
 
@@ -157,6 +159,12 @@ int main(int argc, char **argv)
                         "0 disables it (Default: 3 minutes)");
     argparser.AddOption("state-dir", 0, "DIRECTORY", true,
                         "Directory where to save persistent data");
+    argparser.AddOption("lazy-load", 0,
+                        "Parse persistent configuration profiles when "
+                        "first used instead of at startup");
+    argparser.AddOption("state-log", 0,
+                        "Store persistent configuration profiles in a "
+                        "single append-only log file");
 
 
     try
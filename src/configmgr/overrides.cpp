@@ -23,26 +23,166 @@
  * @brief  Code needed to handle configuration overrides
  */
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include "overrides.hpp"
 
+
+namespace {
+
+/**
+ *  The override keys, in OverrideID order.  These are only used to
+ *  generate the perfect hash table at compile time; the lookup compares
+ *  against the key in configProfileOverrides[].
+ */
+constexpr const char *override_keys[] = {
+    "server-override", "port-override", "proto-override", "ipv6",
+    "persist-tun", "dns-fallback-google", "dns-setup-disabled",
+    "dns-sync-lookup", "auth-fail-retry", "allow-compression",
+    "force-cipher-aes-cbc", "tls-version-min", "tls-cert-profile",
+    "proxy-host", "proxy-port", "proxy-username", "proxy-password",
+    "proxy-auth-cleartext"
+};
+
+constexpr size_t override_count = sizeof(override_keys) / sizeof(override_keys[0]);
+
+/**
+ *  The FNV-1a offset basis is adjusted to give each key its own slot.
+ *  If a new override breaks the static_assert below, pick a new seed
+ *  which does not cause any collisions.
+ */
+constexpr uint32_t override_hash_seed = 0x811c9df6;
+constexpr size_t override_slots = 32;
+
+
+constexpr char fold_case(char c)
+{
+    return ('A' <= c && 'Z' >= c) ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+
+/**
+ *  One step of the case insensitive 32-bit FNV-1a hash of an override key
+ */
+constexpr uint32_t override_hash_step(uint32_t hash, char c)
+{
+    return (hash ^ static_cast<uint8_t>(fold_case(c))) * 16777619u;
+}
+
+
+/**
+ *  Compile time variant of override_hash(), only used on the keys in
+ *  override_keys[].  C++11 constexpr functions cannot contain loops, so
+ *  this recurses once per character.
+ */
+constexpr uint32_t override_hash_static(const char *key,
+                                        uint32_t hash = override_hash_seed)
+{
+    return ('\0' == *key
+            ? hash
+            : override_hash_static(key + 1, override_hash_step(hash, *key)));
+}
+
+
+constexpr size_t override_slot(const char *key)
+{
+    return override_hash_static(key) >> 27;
+}
+
+
+/**
+ *  Case insensitive 32-bit FNV-1a hash of an override key.  This is used
+ *  at runtime on keys of any length provided by users, so it must not
+ *  recurse.
+ */
+uint32_t override_hash(const std::string& key)
+{
+    uint32_t hash = override_hash_seed;
+    for (char c : key)
+    {
+        hash = override_hash_step(hash, c);
+    }
+    return hash;
+}
+
+
+constexpr bool slot_unique(size_t i, size_t j)
+{
+    return (override_count <= j
+            ? true
+            : (override_slot(override_keys[i]) != override_slot(override_keys[j])
+               && slot_unique(i, j + 1)));
+}
+
+
+constexpr bool perfect_hash(size_t i = 0)
+{
+    return (override_count <= i
+            ? true
+            : slot_unique(i, i + 1) && perfect_hash(i + 1));
+}
+
+
+constexpr int8_t slot_index(size_t slot, size_t i = 0)
+{
+    return (override_count <= i
+            ? -1
+            : (override_slot(override_keys[i]) == slot
+               ? static_cast<int8_t>(i)
+               : slot_index(slot, i + 1)));
+}
+
+
+static_assert(override_slots == (1 << (32 - 27)),
+              "override_slot() does not match the table size");
+static_assert(static_cast<size_t>(OverrideID::invalid) == override_count,
+              "override_keys[] does not match OverrideID");
+static_assert(sizeof(configProfileOverrides) / sizeof(configProfileOverrides[0])
+              == override_count,
+              "override_keys[] does not match configProfileOverrides[]");
+static_assert(perfect_hash(),
+              "override_hash_seed causes collisions, select a new seed");
+
+
+#define SLOT4(n) slot_index(n), slot_index(n + 1), slot_index(n + 2), slot_index(n + 3)
+/**
+ *  Maps each hash slot to the index in configProfileOverrides[],
+ *  -1 for unused slots
+ */
+constexpr int8_t override_table[override_slots] = {
+    SLOT4(0), SLOT4(4), SLOT4(8), SLOT4(12),
+    SLOT4(16), SLOT4(20), SLOT4(24), SLOT4(28)
+};
+#undef SLOT4
+
+} // anonymous namespace
+
+
 const ValidOverride & GetConfigOverride(const std::string & key, bool ignoreCase)
 {
-    for (const auto& vo: configProfileOverrides)
+    int8_t idx = override_table[override_hash(key) >> 27];
+    if (0 > idx)
     {
-        if (vo.key==key)
-        {
-           return vo;
-        }
+        return invalidOverride;
+    }
 
-        // This is appearently the best way to do a case insenstive
-        // comparision in C++
-        if (ignoreCase && std::equal(vo.key.begin(), vo.key.end(), key.begin(),
-            [](char a, char b) { return std::tolower(a) == std::tolower(b);} ))
+    const ValidOverride& vo = configProfileOverrides[idx];
+    if (vo.key == key)
+    {
+        return vo;
+    }
+    if (ignoreCase && vo.key.size() == key.size())
+    {
+        for (size_t i = 0; i < key.size(); ++i)
         {
-            return vo;
+            if (fold_case(key[i]) != vo.key[i])
+            {
+                return invalidOverride;
+            }
         }
+        return vo;
     }
 
     // Override not found
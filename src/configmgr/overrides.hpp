@@ -25,6 +25,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <string>
+
 enum class OverrideType
 {
     string,
@@ -32,18 +35,49 @@ enum class OverrideType
     invalid
 };
 
+
+/**
+ *  Identifies each override.  The order must match the
+ *  configProfileOverrides[] table.
+ */
+enum class OverrideID : uint8_t
+{
+    server_override,
+    port_override,
+    proto_override,
+    ipv6,
+    persist_tun,
+    dns_fallback_google,
+    dns_setup_disabled,
+    dns_sync_lookup,
+    auth_fail_retry,
+    allow_compression,
+    force_cipher_aes_cbc,
+    tls_version_min,
+    tls_cert_profile,
+    proxy_host,
+    proxy_port,
+    proxy_username,
+    proxy_password,
+    proxy_auth_cleartext,
+    invalid
+};
+
+
 /**
  * Helper classes to store the list of overrides
  */
 struct ValidOverride {
-    ValidOverride(std::string key, OverrideType type, std::string help)
-        : key(key), type(type), help(help)
+    ValidOverride(OverrideID id, std::string key, OverrideType type,
+                  std::string help)
+        : id(id), key(key), type(type), help(help)
     {
     }
 
-    ValidOverride(std::string key, OverrideType type,
+    ValidOverride(OverrideID id, std::string key, OverrideType type,
                   std::string help, std::string (*argument_helper)())
-        : key(key), type(type), help(help), argument_helper(argument_helper)
+        : id(id), key(key), type(type), help(help),
+          argument_helper(argument_helper)
     {
     }
 
@@ -54,6 +88,7 @@ struct ValidOverride {
     }
 
 
+    OverrideID id;
     std::string key;
     OverrideType type;
     std::string help;
@@ -61,90 +96,106 @@ struct ValidOverride {
 };
 
 
+/**
+ *  An override value set in a configuration profile.  It refers to the
+ *  descriptor returned by GetConfigOverride(), which must outlive it.
+ */
 struct OverrideValue {
     OverrideValue(const ValidOverride& override, bool value)
-        : override(override), boolValue(value)
+        : override(&override), boolValue(value)
     {
     }
 
 
     OverrideValue(const ValidOverride& override, std::string value)
-        : override(override), strValue(value)
+        : override(&override), strValue(value)
     {
     }
 
 
-    ValidOverride override;
-    bool boolValue;
+    const ValidOverride *override;
+    bool boolValue = false;
     std::string strValue;
 };
 
 
 const ValidOverride configProfileOverrides[] = {
-    {"server-override", OverrideType::string,
+    {OverrideID::server_override, "server-override", OverrideType::string,
      "Replace the remote, connecting to this server instead the server specified in the configuration"},
 
-    {"port-override", OverrideType::string,
+    {OverrideID::port_override, "port-override", OverrideType::string,
      "Replace the remote port, connecting to this port instead of the configuration value"},
 
-    {"proto-override", OverrideType::string,
+    {OverrideID::proto_override, "proto-override", OverrideType::string,
      "Overrides the protocol being used",
      [] {return std::string("tcp udp");}},
 
-    {"ipv6", OverrideType::string,
+    {OverrideID::ipv6, "ipv6", OverrideType::string,
      "Sets the IPv6 policy of the client",
      [] { return std::string("yes no default");}},
 
-    {"persist-tun", OverrideType::boolean,
+    {OverrideID::persist_tun, "persist-tun", OverrideType::boolean,
      "The tun interface should persist during reconnect"},
 
-    {"dns-fallback-google", OverrideType::boolean,
+    {OverrideID::dns_fallback_google, "dns-fallback-google", OverrideType::boolean,
      "Uses Google DNS servers (8.8.8.8/8.8.4.4) if no DNS server are provided"},
 
-    {"dns-setup-disabled", OverrideType::boolean,
+    {OverrideID::dns_setup_disabled, "dns-setup-disabled", OverrideType::boolean,
      "Do not change the DNS settings on the system"},
 
-    {"dns-sync-lookup", OverrideType::boolean,
+    {OverrideID::dns_sync_lookup, "dns-sync-lookup", OverrideType::boolean,
      "Use synchronous DNS Lookups"},
 
-    {"auth-fail-retry", OverrideType::boolean,
+    {OverrideID::auth_fail_retry, "auth-fail-retry", OverrideType::boolean,
      "Should failed authentication be considered a temporary error"},
 
-    {"allow-compression", OverrideType::string,
+    {OverrideID::allow_compression, "allow-compression", OverrideType::string,
      "Set compression mode",
      [] {return std::string("no asym yes");}},
 
-    {"force-cipher-aes-cbc", OverrideType::boolean,
+    {OverrideID::force_cipher_aes_cbc, "force-cipher-aes-cbc", OverrideType::boolean,
      "Forces AES-CBC ciphersuites for control channel and disables AES-GCM data channel support"},
 
-    {"tls-version-min", OverrideType::string,
+    {OverrideID::tls_version_min, "tls-version-min", OverrideType::string,
      "Sets the minimal TLS version for the control channel",
      [] {return std::string("tls_1_0 tls_1_1 tls_1_2 tls_1_3");}},
 
-    {"tls-cert-profile", OverrideType::string,
+    {OverrideID::tls_cert_profile, "tls-cert-profile", OverrideType::string,
      "Sets the control channel tls profile",
      [] {return std::string("legacy preferred suiteb");}},
 
-    {"proxy-host", OverrideType::string,
+    {OverrideID::proxy_host, "proxy-host", OverrideType::string,
      "HTTP Proxy to connect via, overrides configuration file http-proxy"},
 
-    {"proxy-port", OverrideType::string,
+    {OverrideID::proxy_port, "proxy-port", OverrideType::string,
      "HTTP Proxy port to connect on"},
 
-    {"proxy-username", OverrideType::string,
+    {OverrideID::proxy_username, "proxy-username", OverrideType::string,
      "HTTP Proxy username to authenticate as"},
 
-    {"proxy-password", OverrideType::string,
+    {OverrideID::proxy_password, "proxy-password", OverrideType::string,
      "HTTP Proxy password to use for authentication"},
 
-    {"proxy-auth-cleartext", OverrideType::boolean,
+    {OverrideID::proxy_auth_cleartext, "proxy-auth-cleartext", OverrideType::boolean,
      "Allows clear text HTTP authentication"}
 };
 
 
-const ValidOverride invalidOverride(std::string("invalid"),
+const ValidOverride invalidOverride(OverrideID::invalid,
+                                    std::string("invalid"),
                                     OverrideType::invalid, "Invalid override");
 
 
+/**
+ *  Looks up an override descriptor.  This is a constant time lookup in
+ *  a perfect hash table generated at compile time.
+ *
+ * @param key         std::string with the override key to look up
+ * @param ignoreCase  Do a case insensitive key comparison
+ *
+ * @return  Returns a reference to the override descriptor, or to
+ *          invalidOverride if the key is unknown.  The reference stays
+ *          valid for the life time of the program.
+ */
 const ValidOverride & GetConfigOverride(const std::string& key,
                                         bool ignoreCase = false);
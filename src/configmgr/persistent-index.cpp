@@ -0,0 +1,170 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   persistent-index.cpp
+ *
+ * @brief  Metadata index of the persistent configuration profiles, used
+ *         to register them without parsing each profile at startup
+ */
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "common/atomic-file.hpp"
+#include "persistent-index.hpp"
+
+
+/**
+ *  Retrieves the modification time and size of a file, as a string
+ *  used to detect if the file has changed since it was indexed.
+ *
+ * @param fname  std::string with the file name to check
+ *
+ * @return  Returns a std::string with the file signature, or an empty
+ *          string if the file could not be accessed.
+ */
+static std::string file_signature(const std::string& fname)
+{
+    struct stat st;
+    if (0 != stat(fname.c_str(), &st))
+    {
+        return "";
+    }
+    return std::to_string(st.st_mtim.tv_sec) + "."
+           + std::to_string(st.st_mtim.tv_nsec) + ":"
+           + std::to_string(st.st_size);
+}
+
+
+PersistentMetadataIndex::PersistentMetadataIndex(const std::string& state_dir)
+    : index_file(state_dir + "/metadata-index.json"),
+      entries(Json::objectValue)
+{
+}
+
+
+bool PersistentMetadataIndex::Load()
+{
+    entries = Json::Value(Json::objectValue);
+    modified = false;
+
+    std::ifstream idxfile(index_file, std::ifstream::binary);
+    if (!idxfile.is_open())
+    {
+        return false;
+    }
+
+    try
+    {
+        Json::Value data;
+        idxfile >> data;
+        if (data.isObject() && data["entries"].isObject())
+        {
+            entries = data["entries"];
+            return true;
+        }
+    }
+    catch (const Json::Exception&)
+    {
+        // Ignore it; all configuration files will be parsed instead
+    }
+    return false;
+}
+
+
+bool PersistentMetadataIndex::Save()
+{
+    if (!modified)
+    {
+        return true;
+    }
+
+    Json::Value data;
+    data["entries"] = entries;
+
+    std::stringstream idx;
+    idx << data;
+    try
+    {
+        write_file_atomic(index_file, idx.str());
+    }
+    catch (const AtomicFileException&)
+    {
+        return false;
+    }
+    modified = false;
+    return true;
+}
+
+
+bool PersistentMetadataIndex::Lookup(const std::string& fname,
+                                     Json::Value& metadata) const
+{
+    if (!entries.isMember(fname))
+    {
+        return false;
+    }
+    const Json::Value& entry = entries[fname];
+    std::string sig = file_signature(fname);
+    if (sig.empty() || entry["signature"].asString() != sig)
+    {
+        return false;
+    }
+    metadata = entry["metadata"];
+    return true;
+}
+
+
+void PersistentMetadataIndex::Update(const std::string& fname,
+                                     const Json::Value& metadata)
+{
+    std::string sig = file_signature(fname);
+    if (sig.empty())
+    {
+        if (entries.isMember(fname))
+        {
+            entries.removeMember(fname);
+            modified = true;
+        }
+        return;
+    }
+
+    Json::Value entry;
+    entry["signature"] = sig;
+    entry["metadata"] = metadata;
+    entries[fname] = entry;
+    modified = true;
+}
+
+
+void PersistentMetadataIndex::Prune(const std::vector<std::string>& files)
+{
+    std::set<std::string> current(files.begin(), files.end());
+    for (const auto& fname : entries.getMemberNames())
+    {
+        if (current.end() == current.find(fname))
+        {
+            entries.removeMember(fname);
+            modified = true;
+        }
+    }
+}
@@ -0,0 +1,114 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   persistent-index.hpp
+ *
+ * @brief  Metadata index of the persistent configuration profiles, used
+ *         to register them without parsing each profile at startup
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+
+/**
+ *  Keeps a copy of the metadata (object path, name, owner, ACL,
+ *  timestamps, overrides, etc) of each persistent configuration file in
+ *  a single file in the state directory.  Each entry also records the
+ *  modification time and size of the configuration file it was
+ *  generated from.  An entry is only used if the configuration file has
+ *  not changed since, otherwise the caller must parse the configuration
+ *  file itself.  A lost or corrupted index file only results in all the
+ *  configuration files being parsed again.
+ */
+class PersistentMetadataIndex
+{
+public:
+    /**
+     * @param state_dir  std::string with the directory containing the
+     *                   persistent configuration files
+     */
+    PersistentMetadataIndex(const std::string& state_dir);
+    ~PersistentMetadataIndex() = default;
+
+    /**
+     *  Loads the index file from the state directory.  A missing or
+     *  unparsable index file results in an empty index.
+     *
+     * @return  Returns true if the index file was loaded
+     */
+    bool Load();
+
+    /**
+     *  Writes the index to the state directory, if it has been modified
+     *  since it was loaded or last saved.  The index file is replaced
+     *  atomically, see write_file_atomic().
+     *
+     * @return  Returns false if the index file could not be written
+     */
+    bool Save();
+
+    /**
+     *  Retrieve the metadata of a configuration file, if the indexed
+     *  information is still valid.
+     *
+     * @param fname     std::string with the configuration file name
+     * @param metadata  Json::Value where the metadata will be stored
+     *
+     * @return  Returns true if the metadata was found and the configuration
+     *          file has not been modified since it was indexed.
+     */
+    bool Lookup(const std::string& fname, Json::Value& metadata) const;
+
+    /**
+     *  Adds or replaces the metadata of a configuration file.  This must
+     *  be called after the configuration file has been written.
+     *
+     * @param fname     std::string with the configuration file name
+     * @param metadata  Json::Value with the metadata of the configuration
+     */
+    void Update(const std::string& fname, const Json::Value& metadata);
+
+    /**
+     *  Removes all entries which are not in the provided list of
+     *  configuration files.
+     *
+     * @param files  std::vector<std::string> of the current configuration
+     *               files in the state directory
+     */
+    void Prune(const std::vector<std::string>& files);
+
+    /**
+     * @return  Returns the full path of the index file
+     */
+    const std::string& GetFilename() const noexcept
+    {
+        return index_file;
+    }
+
+
+private:
+    std::string index_file;
+    Json::Value entries;
+    bool modified = false;
+};
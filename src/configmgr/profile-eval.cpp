@@ -0,0 +1,133 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   profile-eval.cpp
+ *
+ * @brief  Pre-evaluated properties of a configuration profile, computed
+ *         by the configuration manager and passed to the backend client
+ *         together with the profile itself
+ */
+
+#include <string>
+#include <vector>
+
+#include "profile-eval.hpp"
+
+
+ProfileEvaluation::ProfileEvaluation(GVariant *dict)
+{
+    GVariantIter *iter = g_variant_iter_new(dict);
+    const gchar *key = nullptr;
+    GVariant *val = nullptr;
+    while (g_variant_iter_next(iter, "{&sv}", &key, &val))
+    {
+        std::string k(key);
+        if ("client_cert" == k)
+        {
+            client_cert = g_variant_get_boolean(val);
+        }
+        else if ("remotes" == k)
+        {
+            GVariantIter *riter = g_variant_iter_new(val);
+            const gchar *host = nullptr;
+            const gchar *port = nullptr;
+            const gchar *proto = nullptr;
+            while (g_variant_iter_next(riter, "(&s&s&s)", &host, &port, &proto))
+            {
+                remotes.push_back({host, port, proto});
+            }
+            g_variant_iter_free(riter);
+        }
+        g_variant_unref(val);
+    }
+    g_variant_iter_free(iter);
+}
+
+
+ProfileEvaluation ProfileEvaluation::Evaluate(const openvpn::OptionList& options)
+{
+    ProfileEvaluation ret;
+    std::string default_port = "1194";
+    std::string default_proto = "udp";
+
+    for (const auto& opt : options)
+    {
+        if (0 == opt.size())
+        {
+            continue;
+        }
+        const std::string& name = opt.ref(0);
+
+        if ("cert" == name)
+        {
+            ret.client_cert = true;
+        }
+        else if ("remote" == name && 1 < opt.size())
+        {
+            ret.remotes.push_back({opt.ref(1),
+                                   (2 < opt.size() ? opt.ref(2) : ""),
+                                   (3 < opt.size() ? opt.ref(3) : "")});
+        }
+        else if ("port" == name && 1 < opt.size())
+        {
+            default_port = opt.ref(1);
+        }
+        else if ("proto" == name && 1 < opt.size())
+        {
+            default_proto = opt.ref(1);
+        }
+    }
+
+    // The port and proto options are defaults for all remote entries,
+    // regardless of where they appear in the profile
+    for (auto& r : ret.remotes)
+    {
+        if (r.port.empty())
+        {
+            r.port = default_port;
+        }
+        if (r.proto.empty())
+        {
+            r.proto = default_proto;
+        }
+    }
+    return ret;
+}
+
+
+GVariant * ProfileEvaluation::GetGVariant() const
+{
+    GVariantBuilder *rb = g_variant_builder_new(G_VARIANT_TYPE("a(sss)"));
+    for (const auto& r : remotes)
+    {
+        g_variant_builder_add(rb, "(sss)", r.host.c_str(), r.port.c_str(),
+                              r.proto.c_str());
+    }
+    GVariant *remotelist = g_variant_builder_end(rb);
+    g_variant_builder_unref(rb);
+
+    GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(b, "{sv}", "client_cert",
+                          g_variant_new_boolean(client_cert));
+    g_variant_builder_add(b, "{sv}", "remotes", remotelist);
+    GVariant *ret = g_variant_builder_end(b);
+    g_variant_builder_unref(b);
+    return ret;
+}
@@ -0,0 +1,91 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   profile-eval.hpp
+ *
+ * @brief  Pre-evaluated properties of a configuration profile, computed
+ *         by the configuration manager and passed to the backend client
+ *         together with the profile itself
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glib.h>
+
+#include <openvpn/common/options.hpp>
+
+
+/**
+ *  The properties of a configuration profile which are needed outside
+ *  of the OpenVPN 3 Core library's own configuration evaluation.
+ *
+ *  The configuration manager computes this once per profile modification
+ *  from the options it has already parsed.  This saves the backend
+ *  client from parsing the profile an extra time on each session start
+ *  just to look up a few options.
+ *
+ *  Anything the Core library evaluates itself, like the credentials
+ *  required, is deliberately not covered here; the Core library's
+ *  evaluation is the only authoritative one.
+ */
+struct ProfileEvaluation
+{
+    /**
+     *  A single remote entry, with the port and protocol defaults of
+     *  the profile applied
+     */
+    struct Remote
+    {
+        std::string host;
+        std::string port;
+        std::string proto;
+    };
+
+    ProfileEvaluation() = default;
+
+    /**
+     *  Restores an evaluation from an a{sv} dictionary created by
+     *  GetGVariant().  Unknown keys are ignored and missing keys keep
+     *  their default values.
+     *
+     * @param dict  GVariant a{sv} dictionary
+     */
+    ProfileEvaluation(GVariant *dict);
+
+    /**
+     *  Evaluates a parsed configuration profile
+     *
+     * @param options  OptionList containing the parsed profile, with
+     *                 all inline payloads present
+     *
+     * @return Returns a ProfileEvaluation of the profile
+     */
+    static ProfileEvaluation Evaluate(const openvpn::OptionList& options);
+
+    /**
+     * @return Returns the evaluation as a GVariant a{sv} dictionary
+     */
+    GVariant * GetGVariant() const;
+
+    bool client_cert = false;      ///< Profile contains a client certificate
+    std::vector<Remote> remotes;   ///< All remote entries, in profile order
+};
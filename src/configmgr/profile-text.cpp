@@ -0,0 +1,88 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   profile-text.cpp
+ *
+ * @brief  Pre-rendered plain text form of a configuration profile, with
+ *         the inline payloads kept as references
+ */
+
+#include "profile-text.hpp"
+
+using namespace openvpn;
+
+
+ProfileText::ProfileText(const OptionListJSON& options,
+                         const std::map<size_t, std::string>& blobs)
+{
+    // Render each run of options between two payloads with
+    // string_export(), so the output is identical to rendering the
+    // whole expanded profile
+    OptionListJSON run;
+    for (size_t i = 0; i < options.size(); ++i)
+    {
+        auto it = blobs.find(i);
+        if (blobs.end() == it)
+        {
+            run.push_back(options[i]);
+            continue;
+        }
+        text += run.string_export();
+        run.clear();
+        splices.push_back({text.size(), options[i].ref(0), it->second});
+    }
+    text += run.string_export();
+    text.shrink_to_fit();
+}
+
+
+std::string ProfileText::Render(const BlobLookup& lookup) const
+{
+    std::vector<std::string> payloads;
+    size_t size = text.size();
+    for (const auto& s : splices)
+    {
+        payloads.push_back(optparser_mkline(s.name, lookup(s.blob_id)) + "\n");
+        size += payloads.back().size();
+    }
+
+    std::string ret;
+    ret.reserve(size);
+    size_t pos = 0;
+    for (size_t i = 0; i < splices.size(); ++i)
+    {
+        ret.append(text, pos, splices[i].offset - pos);
+        ret += payloads[i];
+        pos = splices[i].offset;
+    }
+    ret.append(text, pos, std::string::npos);
+    return ret;
+}
+
+
+size_t ProfileText::MemoryUsage() const noexcept
+{
+    size_t ret = text.capacity() + splices.capacity() * sizeof(Splice);
+    for (const auto& s : splices)
+    {
+        ret += s.name.capacity() + s.blob_id.capacity();
+    }
+    return ret;
+}
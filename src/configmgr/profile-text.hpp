@@ -0,0 +1,92 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   profile-text.hpp
+ *
+ * @brief  Pre-rendered plain text form of a configuration profile, with
+ *         the inline payloads kept as references
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/core-extensions.hpp"
+
+
+/**
+ *  Keeps the plain text form of a configuration profile, as returned by
+ *  the Fetch method, without the large inline payloads (<ca>, <cert>,
+ *  <key>, ...) which are kept in the InlineBlobStore.  Only the position
+ *  and blob ID of each payload is stored; the payloads are spliced in
+ *  when the text is rendered.  This keeps the rendered profile cheap to
+ *  produce on each Fetch, while the memory used per profile stays close
+ *  to the size of the directives outside the payloads.
+ */
+class ProfileText
+{
+public:
+    /// Looks up the payload of a blob ID
+    typedef std::function<std::string(const std::string& id)> BlobLookup;
+
+    ProfileText() = default;
+
+    /**
+     *  Renders all the options except the inline payloads
+     *
+     * @param options  openvpn::OptionListJSON of the profile, where the
+     *                 options listed in blobs contain the blob ID
+     *                 instead of the payload
+     * @param blobs    std::map of option indexes to blob IDs
+     */
+    ProfileText(const openvpn::OptionListJSON& options,
+                const std::map<size_t, std::string>& blobs);
+
+    /**
+     *  Produces the complete plain text profile
+     *
+     * @param lookup  BlobLookup returning the payload of a blob ID
+     *
+     * @return Returns a std::string with the same contents as
+     *         OptionListJSON::string_export() of the expanded profile
+     */
+    std::string Render(const BlobLookup& lookup) const;
+
+    /**
+     * @return Returns the number of heap bytes used by this object
+     */
+    size_t MemoryUsage() const noexcept;
+
+
+private:
+    /// An inline payload to insert into text
+    struct Splice
+    {
+        size_t offset;          ///< Position in text
+        std::string name;       ///< Option name, like "ca"
+        std::string blob_id;    ///< ID of the payload
+    };
+
+    std::string text;
+    std::vector<Splice> splices;
+};
@@ -20,13 +20,77 @@
 #ifndef OPENVPN3_DBUS_PROXY_CONFIG_HPP
 #define OPENVPN3_DBUS_PROXY_CONFIG_HPP
 
+#include <ctime>
 #include <vector>
 
+#include <openvpn/client/cliconstants.hpp>
+
 #include "dbus/core.hpp"
+#include "dbus/sealed-memfd.hpp"
 #include "configmgr/overrides.hpp"
+#include "configmgr/profile-eval.hpp"
 
 using namespace openvpn;
 
+
+/**
+ *  Filter criteria used by
+ *  OpenVPN3ConfigurationProxy::FetchAvailableConfigDetails().  Unset
+ *  criteria are not sent to the configuration manager.
+ */
+struct ConfigurationFilter
+{
+    bool owner_set = false;
+    uid_t owner = 0;
+    std::string name_prefix = "";
+    bool persistent_only = false;
+    std::string remote_host = "";
+    std::string remote_port = "";
+    std::string remote_proto = "";
+    std::string override_filter = "";  ///< Override "name" or "name=value"
+};
+
+
+/**
+ *  Details about a single configuration profile, as returned by
+ *  OpenVPN3ConfigurationProxy::FetchAvailableConfigDetails()
+ */
+struct ConfigurationDetails
+{
+    std::string path;
+    std::string name;
+    std::time_t import_tstamp;
+    std::time_t last_used_tstamp;
+    uid_t owner;
+    unsigned int used_count;
+    bool persistent;
+};
+
+/**
+ *  A configuration profile to import with
+ *  OpenVPN3ConfigurationProxy::ImportBatch()
+ */
+struct ConfigurationImport
+{
+    std::string name;
+    std::string config;
+    bool single_use = false;
+    bool persistent = false;
+};
+
+
+/**
+ *  The result of importing a single configuration profile with
+ *  OpenVPN3ConfigurationProxy::ImportBatch().  If the import failed,
+ *  path is empty and error contains the reason.
+ */
+struct ConfigurationImportResult
+{
+    std::string path;
+    std::string error;
+};
+
+
 class OpenVPN3ConfigurationProxy : public DBusProxy {
 public:
     OpenVPN3ConfigurationProxy(GBusType bus_type, std::string object_path)
@@ -41,6 +105,7 @@ public:
         property_proxy = SetupProxy(OpenVPN3DBus_name_configuration,
                                     "org.freedesktop.DBus.Properties",
                                     object_path);
+        SetGDBusCallTimeout(OpenVPN3DBus_timeout_configuration);
 
         // Only try to ensure the configuration manager service is available
         // when accessing the main management object
@@ -62,6 +127,7 @@ public:
         property_proxy = SetupProxy(OpenVPN3DBus_name_configuration,
                                     "org.freedesktop.DBus.Properties",
                                     object_path);
+        SetGDBusCallTimeout(OpenVPN3DBus_timeout_configuration);
         // Only try to ensure the configuration manager service is available
         // when accessing the main management object
         if (OpenVPN3DBus_rootp_configuration == object_path)
@@ -96,6 +162,118 @@ public:
     }
 
 
+    /**
+     *  Imports several configuration profiles in a single call.  The
+     *  configuration manager parses the profiles in parallel.
+     *
+     * @param configs  std::vector<ConfigurationImport> of the profiles to
+     *                 import
+     *
+     * @return Returns a std::vector<ConfigurationImportResult> with the
+     *         result of each profile, in the same order as configs
+     */
+    std::vector<ConfigurationImportResult> ImportBatch(const std::vector<ConfigurationImport>& configs)
+    {
+        GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("a(ssbb)"));
+        for (const auto& cfg : configs)
+        {
+            g_variant_builder_add(bld, "(ssbb)",
+                                  cfg.name.c_str(), cfg.config.c_str(),
+                                  cfg.single_use, cfg.persistent);
+        }
+        GVariant *items = g_variant_builder_end(bld);
+        g_variant_builder_unref(bld);
+
+        GVariant *res = Call("ImportBatch", g_variant_new_tuple(&items, 1));
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
+                                "Failed to import configurations");
+        }
+
+        std::vector<ConfigurationImportResult> ret;
+        GVariantIter *iter = nullptr;
+        g_variant_get(res, "(a(os))", &iter);
+
+        gchar *path = nullptr;
+        gchar *error = nullptr;
+        while (g_variant_iter_next(iter, "(os)", &path, &error))
+        {
+            ConfigurationImportResult r;
+            r.error = std::string(error);
+            if (r.error.empty())
+            {
+                r.path = std::string(path);
+            }
+            ret.push_back(r);
+            g_free(path);
+            g_free(error);
+        }
+        g_variant_iter_free(iter);
+        g_variant_unref(res);
+
+        return ret;
+    }
+
+
+    /**
+     *  Imports a configuration profile, passing the profile itself as a
+     *  sealed memfd instead of a D-Bus string argument.  This avoids
+     *  copying large profiles through the D-Bus daemon.
+     *
+     * @param name         std::string with the name of the configuration
+     * @param config_blob  std::string with the configuration profile
+     * @param single_use   Bool, remove the configuration after first use
+     * @param persistent   Bool, save the configuration to disk
+     *
+     * @return Returns a std::string with the D-Bus object path of the
+     *         imported configuration
+     */
+    std::string ImportFD(std::string name, std::string config_blob,
+                         bool single_use, bool persistent)
+    {
+        int fd = -1;
+        try
+        {
+            fd = sealed_memfd_create("openvpn3-profile", config_blob);
+        }
+        catch (const SealedMemfdException& excp)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy", excp.what());
+        }
+
+        GVariant *res = nullptr;
+        try
+        {
+            res = CallSendFD("ImportFD",
+                             g_variant_new("(sbb)",
+                                           name.c_str(),
+                                           single_use,
+                                           persistent),
+                             fd);
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+        close(fd);
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
+                                "Failed to import configuration");
+        }
+
+        gchar *buf = nullptr;
+        g_variant_get(res, "(o)", &buf);
+        std::string ret(buf);
+        g_variant_unref(res);
+        g_free(buf);
+
+        return ret;
+    }
+
+
     /**
      * Retrieves a string array of configuration paths which are available
      * to the calling user
@@ -127,6 +305,109 @@ public:
     }
 
 
+    /**
+     *  Retrieves details about all configuration profiles available to
+     *  the calling user in a single D-Bus call.
+     *
+     * @param filter  ConfigurationFilter with criteria the profiles must
+     *                match
+     * @param offset  Number of matching profiles to skip
+     * @param limit   Maximum number of profiles to return, 0 returns all
+     * @param total   Optional pointer where the total number of matching
+     *                profiles will be stored, regardless of offset/limit
+     *
+     * @return Returns a std::vector<ConfigurationDetails> with the
+     *         requested profiles, sorted by their object path.
+     */
+    std::vector<ConfigurationDetails> FetchAvailableConfigDetails(const ConfigurationFilter& filter = ConfigurationFilter(),
+                                                                  const unsigned int offset = 0,
+                                                                  const unsigned int limit = 0,
+                                                                  unsigned int *total = nullptr)
+    {
+        GVariantBuilder *flt = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
+        if (filter.owner_set)
+        {
+            g_variant_builder_add(flt, "{sv}", "owner",
+                                  g_variant_new_uint32(filter.owner));
+        }
+        if (!filter.name_prefix.empty())
+        {
+            g_variant_builder_add(flt, "{sv}", "name_prefix",
+                                  g_variant_new_string(filter.name_prefix.c_str()));
+        }
+        if (filter.persistent_only)
+        {
+            g_variant_builder_add(flt, "{sv}", "persistent",
+                                  g_variant_new_boolean(true));
+        }
+        if (!filter.remote_host.empty())
+        {
+            g_variant_builder_add(flt, "{sv}", "remote_host",
+                                  g_variant_new_string(filter.remote_host.c_str()));
+        }
+        if (!filter.remote_port.empty())
+        {
+            g_variant_builder_add(flt, "{sv}", "remote_port",
+                                  g_variant_new_string(filter.remote_port.c_str()));
+        }
+        if (!filter.remote_proto.empty())
+        {
+            g_variant_builder_add(flt, "{sv}", "remote_proto",
+                                  g_variant_new_string(filter.remote_proto.c_str()));
+        }
+        if (!filter.override_filter.empty())
+        {
+            g_variant_builder_add(flt, "{sv}", "override",
+                                  g_variant_new_string(filter.override_filter.c_str()));
+        }
+        GVariant *params = g_variant_new("(a{sv}uu)", flt, offset, limit);
+        g_variant_builder_unref(flt);
+
+        GVariant *res = Call("FetchAvailableConfigDetails", params);
+        if (nullptr == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
+                                "Failed to retrieve configuration details");
+        }
+
+        guint32 count = 0;
+        GVariantIter *cfgs = nullptr;
+        g_variant_get(res, "(ua(osttuub))", &count, &cfgs);
+        if (total)
+        {
+            *total = count;
+        }
+
+        std::vector<ConfigurationDetails> ret;
+        gchar *path = nullptr;
+        gchar *name = nullptr;
+        guint64 imp_tstamp = 0;
+        guint64 last_tstamp = 0;
+        guint32 owner = 0;
+        guint32 used_count = 0;
+        gboolean persistent = false;
+        while (g_variant_iter_next(cfgs, "(osttuub)", &path, &name,
+                                   &imp_tstamp, &last_tstamp,
+                                   &owner, &used_count, &persistent))
+        {
+            ConfigurationDetails d;
+            d.path = std::string(path);
+            d.name = std::string(name);
+            d.import_tstamp = imp_tstamp;
+            d.last_used_tstamp = last_tstamp;
+            d.owner = owner;
+            d.used_count = used_count;
+            d.persistent = persistent;
+            ret.push_back(d);
+            g_free(path);
+            g_free(name);
+        }
+        g_variant_iter_free(cfgs);
+        g_variant_unref(res);
+        return ret;
+    }
+
+
     /**
      *  Lookup the configuration paths for a given configuration name.
      *
@@ -197,6 +478,50 @@ public:
         return ret;
     }
 
+    /**
+     *  Retrieves the configuration profile, like GetConfig(), but passed
+     *  as a sealed memfd instead of a D-Bus string.
+     *
+     * @return Returns a std::string with the configuration profile
+     */
+    std::string GetConfigFD()
+    {
+        int fd = -1;
+        GVariant *res = CallGetFD("FetchFD", fd);
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
+                                "Failed to retrieve configuration");
+        }
+        g_variant_unref(res);
+        return read_profile_fd(fd);
+    }
+
+    /**
+     *  Retrieves the configuration profile, like GetConfigFD(), together
+     *  with the evaluation of the profile done by the configuration
+     *  manager.  Both are retrieved in a single D-Bus call.
+     *
+     * @param eval  ProfileEvaluation object where the evaluation is stored
+     *
+     * @return Returns a std::string with the configuration profile
+     */
+    std::string GetConfigEvaluated(ProfileEvaluation& eval)
+    {
+        int fd = -1;
+        GVariant *res = CallGetFD("FetchEvaluated", fd);
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
+                                "Failed to retrieve configuration");
+        }
+        GVariant *dict = g_variant_get_child_value(res, 0);
+        eval = ProfileEvaluation(dict);
+        g_variant_unref(dict);
+        g_variant_unref(res);
+        return read_profile_fd(fd);
+    }
+
     void Remove()
     {
         GVariant *res = Call("Remove");
@@ -348,24 +673,33 @@ public:
             GVariant *val = nullptr;
             g_variant_get(override, "{sv}", &key, &val);
 
-
+            // The descriptor decides which value type is accepted
             const ValidOverride& vo = GetConfigOverride(key);
-            if (!vo.valid())
-            {
-                THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
-                                    "Invalid override found");
-            }
-            if (OverrideType::string == vo.type)
+            bool valid = false;
+            if (OverrideType::string == vo.type
+                && g_variant_is_of_type(val, G_VARIANT_TYPE_STRING))
             {
                 gsize len = 0;
                 std::string v(g_variant_get_string(val, &len));
                 ret.push_back(OverrideValue(vo, v));
-
+                valid = true;
             }
-            else if (OverrideType::boolean == vo.type)
+            else if (OverrideType::boolean == vo.type
+                     && g_variant_is_of_type(val, G_VARIANT_TYPE_BOOLEAN))
             {
                 bool v = g_variant_get_boolean(val);
                 ret.push_back(OverrideValue(vo, v));
+                valid = true;
+            }
+            g_free(key);
+            g_variant_unref(val);
+            g_variant_unref(override);
+            if (!valid)
+            {
+                g_variant_unref(res);
+                g_variant_iter_free(override_iter);
+                THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
+                                    "Invalid override found");
             }
         }
         g_variant_unref(res);
@@ -415,12 +749,10 @@ public:
 
     const ValidOverride& LookupOverride(const std::string key)
     {
-        for (const ValidOverride& vo: configProfileOverrides)
+        const ValidOverride& vo = GetConfigOverride(key);
+        if (vo.valid())
         {
-            if (vo.key == key)
-            {
-                return vo;
-            }
+            return vo;
         }
         THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
                             "Invalid override key:" + key);
@@ -469,6 +801,31 @@ public:
         g_variant_iter_free(acl);
         return ret;
     }
+
+
+private:
+    /**
+     *  Reads the configuration profile from a sealed memfd returned by
+     *  the configuration manager.  The file descriptor is closed.
+     *
+     * @param fd  File descriptor to read the profile from
+     *
+     * @return Returns a std::string with the configuration profile
+     */
+    std::string read_profile_fd(int fd)
+    {
+        try
+        {
+            std::string ret = sealed_memfd_read(fd, ProfileParseLimits::MAX_PROFILE_SIZE);
+            close(fd);
+            return ret;
+        }
+        catch (const SealedMemfdException& excp)
+        {
+            close(fd);
+            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy", excp.what());
+        }
+    }
 };
 
 #endif // OPENVPN3_DBUS_PROXY_CONFIG_HPP
@@ -0,0 +1,406 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   state-log.cpp
+ *
+ * @brief  Append-only, single file storage of persistent configuration
+ *         profiles
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "common/atomic-file.hpp"
+#include "state-log.hpp"
+
+
+static const std::string log_magic = "OPENVPN3-CONFIG-LOG 1\n";
+
+/// Minimum number of garbage records before the log is compacted
+static const size_t compact_min_garbage = 64;
+
+
+static std::string errmsg(const std::string& msg, const std::string& fname)
+{
+    return msg + " '" + fname + "': " + std::string(strerror(errno));
+}
+
+
+static std::string corrupt_msg(const std::string& fname, size_t offset)
+{
+    return "Corrupted record at offset " + std::to_string(offset)
+           + " of '" + fname + "', refusing to use it";
+}
+
+
+/**
+ *  Serializes a Json::Value into a compact, single line string
+ */
+static std::string json_compact(const Json::Value& value)
+{
+    Json::StreamWriterBuilder wb;
+    wb["indentation"] = "";
+    return Json::writeString(wb, value);
+}
+
+
+static Json::Value json_parse(const std::string& data)
+{
+    Json::Value ret;
+    std::istringstream in(data);
+    in >> ret;
+    return ret;
+}
+
+
+static void check_path(const std::string& path)
+{
+    if (path.empty()
+        || std::string::npos != path.find_first_of(" \n"))
+    {
+        throw ConfigStateLogException("Invalid object path '" + path + "'");
+    }
+}
+
+
+ConfigStateLog::ConfigStateLog(const std::string& state_dir)
+    : log_file(state_dir + "/configs.log")
+{
+}
+
+
+ConfigStateLog::~ConfigStateLog()
+{
+    if (-1 != fd)
+    {
+        close(fd);
+    }
+}
+
+
+ConfigStateLog::MetadataMap ConfigStateLog::Load()
+{
+    if (-1 != fd)
+    {
+        close(fd);
+    }
+    entries.clear();
+    garbage = 0;
+    discarded = 0;
+    skipped = 0;
+
+    fd = open(log_file.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC,
+              0600);
+    if (-1 == fd)
+    {
+        throw ConfigStateLogException(errmsg("Could not open", log_file));
+    }
+
+    // Read the complete file in one go
+    struct stat st;
+    if (0 != fstat(fd, &st))
+    {
+        throw ConfigStateLogException(errmsg("Could not access", log_file));
+    }
+    std::string data = read_range(0, st.st_size);
+    file_size = st.st_size;
+
+    if (0 == file_size)
+    {
+        append(log_magic);
+        return MetadataMap();
+    }
+    if (0 != data.compare(0, log_magic.size(), log_magic))
+    {
+        throw ConfigStateLogException("Unknown file format: " + log_file);
+    }
+
+    MetadataMap ret;
+    size_t pos = log_magic.size();
+    while (pos < data.size())
+    {
+        size_t eol = data.find('\n', pos);
+        if (std::string::npos == eol)
+        {
+            break;
+        }
+
+        std::istringstream hdr(data.substr(pos, eol - pos));
+        char type = 0;
+        std::string path;
+        hdr >> type >> path;
+
+        if ('P' == type)
+        {
+            size_t meta_len = 0;
+            size_t profile_len = 0;
+            hdr >> meta_len >> profile_len;
+            if (hdr.fail())
+            {
+                throw ConfigStateLogException(corrupt_msg(log_file, pos));
+            }
+            size_t start = eol + 1;
+            if (meta_len + profile_len >= data.size() - start)
+            {
+                // The record runs past the end of the file
+                break;
+            }
+            size_t end = start + meta_len + profile_len;
+            if ('\n' != data[end])
+            {
+                // The lengths do not match the record, so the start of
+                // the next record is unknown
+                throw ConfigStateLogException(corrupt_msg(log_file, pos));
+            }
+
+            Json::Value metadata;
+            try
+            {
+                metadata = json_parse(data.substr(start, meta_len));
+            }
+            catch (const Json::Exception&)
+            {
+                // The record is complete, only its contents is damaged.
+                // Skip it; an older revision of the configuration is
+                // kept if there is one.
+                ++skipped;
+                ++garbage;
+                pos = end + 1;
+                continue;
+            }
+
+            if (Exists(path))
+            {
+                ++garbage;
+            }
+            entries[path] = {(off_t) start, meta_len, profile_len};
+            ret[path] = metadata;
+            pos = end + 1;
+        }
+        else if ('D' == type && !path.empty())
+        {
+            if (Exists(path))
+            {
+                entries.erase(path);
+                ret.erase(path);
+                ++garbage;
+            }
+            ++garbage;
+            pos = eol + 1;
+        }
+        else
+        {
+            throw ConfigStateLogException(corrupt_msg(log_file, pos));
+        }
+    }
+
+    // Anything after the last complete record is the remains of an
+    // interrupted write
+    if (pos < data.size())
+    {
+        discarded = data.size() - pos;
+        if (0 != ftruncate(fd, pos))
+        {
+            throw ConfigStateLogException(errmsg("Could not truncate",
+                                                 log_file));
+        }
+        file_size = pos;
+    }
+
+    return ret;
+}
+
+
+void ConfigStateLog::Put(const std::string& path, const Json::Value& metadata,
+                         const Json::Value& profile)
+{
+    check_path(path);
+
+    std::string meta_str = json_compact(metadata);
+    std::string profile_str = json_compact(profile);
+
+    std::stringstream hdr;
+    hdr << "P " << path << " " << meta_str.size()
+        << " " << profile_str.size() << "\n";
+    std::string header = hdr.str();
+
+    Entry e = {(off_t) (file_size + header.size()),
+               meta_str.size(), profile_str.size()};
+    append(header + meta_str + profile_str + "\n");
+
+    if (Exists(path))
+    {
+        ++garbage;
+    }
+    entries[path] = e;
+    compact_if_needed();
+}
+
+
+void ConfigStateLog::Delete(const std::string& path)
+{
+    if (!Exists(path))
+    {
+        return;
+    }
+    append("D " + path + "\n");
+    entries.erase(path);
+    garbage += 2;
+    compact_if_needed();
+}
+
+
+Json::Value ConfigStateLog::ReadProfile(const std::string& path) const
+{
+    auto it = entries.find(path);
+    if (entries.end() == it)
+    {
+        throw ConfigStateLogException("Configuration '" + path
+                                      + "' not found in " + log_file);
+    }
+    const Entry& e = it->second;
+    try
+    {
+        return json_parse(read_range(e.offset + e.meta_len, e.profile_len));
+    }
+    catch (const Json::Exception& excp)
+    {
+        throw ConfigStateLogException("Could not parse the profile of '"
+                                      + path + "': " + excp.what());
+    }
+}
+
+
+void ConfigStateLog::Compact()
+{
+    std::string data = log_magic;
+    std::map<std::string, Entry> compacted;
+    for (const auto& it : entries)
+    {
+        const Entry& e = it.second;
+        std::stringstream hdr;
+        hdr << "P " << it.first << " " << e.meta_len
+            << " " << e.profile_len << "\n";
+        data += hdr.str();
+        compacted[it.first] = {(off_t) data.size(), e.meta_len, e.profile_len};
+        data += read_range(e.offset, e.meta_len + e.profile_len) + "\n";
+    }
+
+    try
+    {
+        write_file_atomic(log_file, data);
+    }
+    catch (const AtomicFileException& excp)
+    {
+        throw ConfigStateLogException(excp.what());
+    }
+
+    int newfd = open(log_file.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+    if (-1 == newfd)
+    {
+        throw ConfigStateLogException(errmsg("Could not reopen", log_file));
+    }
+    close(fd);
+    fd = newfd;
+    file_size = data.size();
+    entries = std::move(compacted);
+    garbage = 0;
+}
+
+
+void ConfigStateLog::append(const std::string& record)
+{
+    if (-1 == fd)
+    {
+        throw ConfigStateLogException("Log file is not loaded: " + log_file);
+    }
+
+    const char *p = record.data();
+    size_t left = record.size();
+    while (left > 0)
+    {
+        ssize_t r = write(fd, p, left);
+        if (0 > r)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            std::string err = errmsg("Could not write to", log_file);
+
+            // Do not leave a partial record behind, later appends
+            // would otherwise be lost when loading the file
+            (void) ftruncate(fd, file_size);
+            throw ConfigStateLogException(err);
+        }
+        p += r;
+        left -= r;
+    }
+    if (0 != fdatasync(fd))
+    {
+        std::string err = errmsg("Could not flush", log_file);
+        (void) ftruncate(fd, file_size);
+        throw ConfigStateLogException(err);
+    }
+    file_size += record.size();
+}
+
+
+void ConfigStateLog::compact_if_needed()
+{
+    if (garbage < compact_min_garbage || garbage < entries.size())
+    {
+        return;
+    }
+    try
+    {
+        Compact();
+    }
+    catch (const ConfigStateLogException&)
+    {
+        // The log file is still consistent; compaction will be
+        // retried on the next change
+    }
+}
+
+
+std::string ConfigStateLog::read_range(off_t offset, size_t len) const
+{
+    std::string ret(len, '\0');
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t r = pread(fd, &ret[done], len - done, offset + done);
+        if (0 > r && EINTR == errno)
+        {
+            continue;
+        }
+        if (0 >= r)
+        {
+            throw ConfigStateLogException(errmsg("Could not read", log_file));
+        }
+        done += r;
+    }
+    return ret;
+}
@@ -0,0 +1,223 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   state-log.hpp
+ *
+ * @brief  Append-only, single file storage of persistent configuration
+ *         profiles
+ */
+
+#pragma once
+
+#include <exception>
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <json/json.h>
+
+
+class ConfigStateLogException : public std::exception
+{
+public:
+    ConfigStateLogException(const std::string& msg) : message(msg)
+    {
+    }
+
+    const char* what() const noexcept
+    {
+        return message.c_str();
+    }
+
+private:
+    std::string message{};
+};
+
+
+/**
+ *  Stores all persistent configuration profiles in a single log
+ *  structured file, keyed by the D-Bus object path of the configuration.
+ *  Each change is a sequential append of a record to the end of the file,
+ *  followed by fdatasync().  The last record of an object path is the
+ *  current one; older records are garbage which is removed by a
+ *  compaction once there is more garbage than live records.
+ *
+ *  File format:
+ *
+ *    OPENVPN3-CONFIG-LOG 1\n
+ *    P <object path> <metadata length> <profile length>\n
+ *    <metadata JSON><profile JSON>\n
+ *    D <object path>\n
+ *
+ *  The metadata and profile parts are stored separately, so the
+ *  configuration objects can be registered at startup without parsing
+ *  the profiles.  A record cut short by a crash is detected and removed
+ *  when loading the file.  A complete record with damaged metadata is
+ *  skipped.  If the framing of a record in the middle of the file is
+ *  damaged, the file is not used at all, as removing everything after
+ *  it would lose the following records.
+ */
+class ConfigStateLog
+{
+public:
+    typedef std::map<std::string, Json::Value> MetadataMap;
+
+    /**
+     * @param state_dir  std::string with the directory where the log
+     *                   file is stored
+     */
+    ConfigStateLog(const std::string& state_dir);
+    ~ConfigStateLog();
+
+    ConfigStateLog(const ConfigStateLog&) = delete;
+    ConfigStateLog& operator=(const ConfigStateLog&) = delete;
+
+    /**
+     *  Opens the log file, creating it if needed, and reads it
+     *  sequentially.  An incomplete record at the end of the file is
+     *  removed and records with unparsable metadata are skipped.  This
+     *  must be called before any other operation.
+     *
+     * @return  Returns a MetadataMap with the metadata of all the stored
+     *          configurations, indexed by the object path
+     *
+     * @throws  ConfigStateLogException if the file cannot be used, which
+     *          includes a record whose header or lengths are damaged
+     */
+    MetadataMap Load();
+
+    /**
+     *  Stores a new revision of a configuration
+     *
+     * @param path      std::string with the D-Bus object path
+     * @param metadata  Json::Value with the configuration metadata, as
+     *                  returned by ConfigurationObject::ExportMetadata()
+     * @param profile   Json::Value with the configuration profile
+     *
+     * @throws  ConfigStateLogException on write errors
+     */
+    void Put(const std::string& path, const Json::Value& metadata,
+             const Json::Value& profile);
+
+    /**
+     *  Removes a configuration.  Unknown object paths are ignored.
+     *
+     * @param path  std::string with the D-Bus object path
+     *
+     * @throws  ConfigStateLogException on write errors
+     */
+    void Delete(const std::string& path);
+
+    /**
+     *  Reads the profile part of the current revision of a
+     *  configuration.  This is safe to call from several threads at the
+     *  same time, as long as the log is not modified meanwhile.
+     *
+     * @param path  std::string with the D-Bus object path
+     *
+     * @return  Returns a Json::Value with the configuration profile
+     *
+     * @throws  ConfigStateLogException if the profile cannot be read
+     */
+    Json::Value ReadProfile(const std::string& path) const;
+
+    /**
+     * @param path  std::string with the D-Bus object path
+     *
+     * @return  Returns true if the configuration is stored in the log
+     */
+    bool Exists(const std::string& path) const
+    {
+        return entries.end() != entries.find(path);
+    }
+
+    /**
+     *  Rewrites the log file with only the current revision of each
+     *  configuration.  This is done automatically by Put() and Delete()
+     *  when needed.
+     *
+     * @throws  ConfigStateLogException on errors.  The old log file is
+     *          still used in this case.
+     */
+    void Compact();
+
+    /**
+     * @return  Returns the number of stored configurations
+     */
+    size_t size() const noexcept
+    {
+        return entries.size();
+    }
+
+    /**
+     * @return  Returns the number of outdated records in the log file
+     */
+    size_t GarbageRecords() const noexcept
+    {
+        return garbage;
+    }
+
+    /**
+     * @return  Returns the number of bytes of an incomplete record which
+     *          was removed by the last Load() call
+     */
+    size_t DiscardedBytes() const noexcept
+    {
+        return discarded;
+    }
+
+    /**
+     * @return  Returns the number of complete records with unparsable
+     *          metadata which were skipped by the last Load() call
+     */
+    size_t SkippedRecords() const noexcept
+    {
+        return skipped;
+    }
+
+    /**
+     * @return  Returns the full path of the log file
+     */
+    const std::string& GetFilename() const noexcept
+    {
+        return log_file;
+    }
+
+
+private:
+    /// Location of the current record of a configuration
+    struct Entry
+    {
+        off_t offset;           ///< File offset of the metadata part
+        size_t meta_len;        ///< Length of the metadata part
+        size_t profile_len;     ///< Length of the profile part
+    };
+
+    std::string log_file;
+    int fd = -1;
+    off_t file_size = 0;
+    std::map<std::string, Entry> entries;
+    size_t garbage = 0;
+    size_t discarded = 0;
+    size_t skipped = 0;
+
+    void append(const std::string& record);
+    void compact_if_needed();
+    std::string read_range(off_t offset, size_t len) const;
+};
@@ -70,6 +70,46 @@ const std::string OpenVPN3DBus_rootp_netcfg = "/net/openvpn/v3/netcfg";
 const std::string OpenVPN3DBus_interf_netcfg = "net.openvpn.v3.netcfg";
 
 
+/*
+ *  Default D-Bus method call timeouts, in milliseconds, used by the proxy
+ *  classes for each service.  A service calling another service uses a
+ *  shorter budget than its own callers, so a stalled service further down
+ *  the chain results in an error being returned instead of all callers
+ *  hanging until the D-Bus default timeout (25 seconds) kicks in.
+ *
+ *    openvpn3 CLI -> sessions -> backends -> netcfg
+ */
+const int OpenVPN3DBus_timeout_log = 5000;
+const int OpenVPN3DBus_timeout_configuration = 10000;
+const int OpenVPN3DBus_timeout_sessions = 15000;
+const int OpenVPN3DBus_timeout_backends = 10000;
+const int OpenVPN3DBus_timeout_netcfg = 8000;
+
+/* Time reserved by each hop to report an error back to its caller */
+const int OpenVPN3DBus_timeout_margin = 250;
+
+/*
+ *  Time a VPN client backend process gets to stop after it has been asked
+ *  to.  The session manager waits for this twice before killing it; once
+ *  after Disconnect and once after ForceShutdown.  This must stay well
+ *  below OpenVPN3DBus_timeout_sessions / 2.
+ */
+const int OpenVPN3DBus_timeout_backend_stop = 5000;
+
+/*
+ *  Time the session manager waits for each VPN client backend process
+ *  when collecting the statistics of all sessions.  The backends are
+ *  queried in parallel, so this also bounds the complete request.
+ */
+const int OpenVPN3DBus_timeout_statistics = 2000;
+
+/*
+ *  Shortest interval, in milliseconds, front-ends can subscribe to
+ *  StatisticsUpdate signals with
+ */
+const unsigned int OpenVPN3DBus_statistics_interval_min = 500;
+
+
 /**
  *  Status - major codes
  *  These codes represents a type of master group
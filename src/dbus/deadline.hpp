@@ -0,0 +1,320 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   deadline.hpp
+ *
+ * @brief  Tracks the remaining time budget of a chain of D-Bus calls
+ */
+
+#ifndef OPENVPN3_DBUS_DEADLINE_HPP
+#define OPENVPN3_DBUS_DEADLINE_HPP
+
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+
+
+/**
+ *  A DBusCallDeadline is a point in time a D-Bus operation must have
+ *  completed by.  When a service handles a request which again needs to
+ *  call other services, the remaining budget of the deadline is used as
+ *  the timeout of those calls.  This way a stalled service further down
+ *  the chain fails the complete request within the original budget
+ *  instead of each hop waiting for the full D-Bus default timeout.
+ *
+ *  The remaining budget is passed on to the next service with the
+ *  SetCallBudget method, see DBusCallBudgets.
+ */
+class DBusCallDeadline
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /**
+     *  Creates an unset deadline, which does not restrict anything
+     */
+    DBusCallDeadline()
+        : enabled(false)
+    {
+    }
+
+
+    /**
+     *  Creates a deadline which expires a given number of milliseconds
+     *  from now.
+     *
+     * @param budget_ms  Time budget in milliseconds.  A negative value
+     *                   results in an unset deadline.
+     */
+    explicit DBusCallDeadline(const int budget_ms)
+        : enabled(0 <= budget_ms),
+          expires(clock::now() + std::chrono::milliseconds(budget_ms))
+    {
+    }
+
+
+    /**
+     * @return  Returns true if this deadline restricts calls
+     */
+    bool IsSet() const noexcept
+    {
+        return enabled;
+    }
+
+
+    /**
+     * @return  Returns true if the deadline is set and has passed
+     */
+    bool Expired() const noexcept
+    {
+        return enabled && clock::now() >= expires;
+    }
+
+
+    /**
+     *  Retrieve the remaining budget of this deadline
+     *
+     * @return  Returns the number of milliseconds left, 0 if it has expired
+     *          or -1 if no deadline is set.
+     */
+    int Remaining() const noexcept
+    {
+        if (!enabled)
+        {
+            return -1;
+        }
+        clock::time_point now = clock::now();
+        if (now >= expires)
+        {
+            return 0;
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            expires - now).count();
+        // Never round a running deadline down to 0, GDBus would
+        // consider that an immediate timeout
+        return (0 < left ? static_cast<int>(left) : 1);
+    }
+
+
+    /**
+     *  Calculates the timeout to use for a single D-Bus call restricted
+     *  by this deadline.
+     *
+     * @param timeout_ms  The timeout the call would use otherwise, in
+     *                    milliseconds.  -1 means the D-Bus default timeout.
+     *
+     * @return  Returns the smallest value of the remaining budget and
+     *          the provided timeout.  If no deadline is set, the provided
+     *          timeout is returned as-is.
+     */
+    int Timeout(const int timeout_ms) const noexcept
+    {
+        int left = Remaining();
+        if (0 > left)
+        {
+            return timeout_ms;
+        }
+        if (0 > timeout_ms || left < timeout_ms)
+        {
+            return left;
+        }
+        return timeout_ms;
+    }
+
+
+    /**
+     * @param a  DBusCallDeadline to compare
+     * @param b  DBusCallDeadline to compare
+     *
+     * @return  Returns the deadline which expires first.  An unset
+     *          deadline never wins over a set one.
+     */
+    static DBusCallDeadline Earliest(const DBusCallDeadline& a,
+                                     const DBusCallDeadline& b)
+    {
+        if (!a.enabled)
+        {
+            return b;
+        }
+        if (!b.enabled)
+        {
+            return a;
+        }
+        return (a.expires < b.expires ? a : b);
+    }
+
+
+    /**
+     *  Retrieve the deadline of the current DBusCallDeadlineScope in the
+     *  calling thread.
+     *
+     * @return  Returns a reference to the active DBusCallDeadline.  If no
+     *          scope is active, the deadline is unset.
+     */
+    static const DBusCallDeadline& Current()
+    {
+        return current();
+    }
+
+
+private:
+    friend class DBusCallDeadlineScope;
+
+    bool enabled;
+    clock::time_point expires;
+
+    static DBusCallDeadline& current()
+    {
+        static thread_local DBusCallDeadline active;
+        return active;
+    }
+};
+
+
+/**
+ *  Keeps the time budgets callers announce with the SetCallBudget
+ *  method, until the next request of the same caller picks it up.
+ *
+ *  D-Bus messages have no header field for a deadline.  A DBusProxy with
+ *  call budget propagation enabled therefore sends a SetCallBudget call
+ *  without waiting for a reply right before each method call or
+ *  property access.  D-Bus keeps the order of the messages from a
+ *  single connection, so the service receives the budget right before
+ *  the request it belongs to.
+ */
+class DBusCallBudgets
+{
+public:
+    /**
+     *  Records the time budget announced by a caller
+     *
+     * @param sender     std::string with the unique bus name of the caller
+     * @param budget_ms  Time budget of the next request, in milliseconds
+     */
+    static void Set(const std::string& sender, const unsigned int budget_ms)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        std::map<std::string, DBusCallDeadline>& b = budgets();
+
+        // Budgets of requests which never reached a handler are not
+        // picked up; drop them once they have expired
+        if (64 < b.size())
+        {
+            for (auto it = b.begin(); it != b.end();)
+            {
+                it = (it->second.Expired() ? b.erase(it) : std::next(it));
+            }
+        }
+        b[sender] = DBusCallDeadline(static_cast<int>(budget_ms));
+    }
+
+
+    /**
+     *  Retrieve and forget the time budget announced by a caller
+     *
+     * @param sender  std::string with the unique bus name of the caller
+     *
+     * @return  Returns the DBusCallDeadline of the announced budget, or an
+     *          unset deadline if the caller did not announce one.  An
+     *          expired budget is ignored as well, as it may belong to an
+     *          earlier request which never reached a handler.
+     */
+    static DBusCallDeadline Take(const std::string& sender)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        std::map<std::string, DBusCallDeadline>& b = budgets();
+        auto it = b.find(sender);
+        if (b.end() == it)
+        {
+            return DBusCallDeadline();
+        }
+        DBusCallDeadline ret = it->second;
+        b.erase(it);
+        return (ret.Expired() ? DBusCallDeadline() : ret);
+    }
+
+
+private:
+    static std::mutex& mutex()
+    {
+        static std::mutex m;
+        return m;
+    }
+
+    static std::map<std::string, DBusCallDeadline>& budgets()
+    {
+        static std::map<std::string, DBusCallDeadline> b;
+        return b;
+    }
+};
+
+
+/**
+ *  Makes a deadline the active one for all D-Bus calls done by
+ *  DBusProxy objects in the calling thread, for as long as this object
+ *  exists.  Nested scopes can only shorten the active deadline, never
+ *  extend it.
+ *
+ *  This is typically declared at the beginning of a D-Bus method
+ *  callback, so all the calls to other services needed to complete
+ *  the request share the same time budget.
+ */
+class DBusCallDeadlineScope
+{
+public:
+    explicit DBusCallDeadlineScope(const DBusCallDeadline& dl)
+        : previous(DBusCallDeadline::current())
+    {
+        if (dl.enabled
+            && (!previous.enabled || dl.expires < previous.expires))
+        {
+            DBusCallDeadline::current() = dl;
+        }
+    }
+
+    /**
+     *  Makes the remaining budget of a caller the active deadline.  If
+     *  the caller has not announced a budget with SetCallBudget, or it
+     *  is longer than budget_ms, budget_ms is used.
+     *
+     * @param sender     std::string with the unique bus name of the caller
+     * @param budget_ms  Longest budget to allow, in milliseconds
+     */
+    DBusCallDeadlineScope(const std::string& sender, const int budget_ms)
+        : DBusCallDeadlineScope(DBusCallDeadline::Earliest(DBusCallBudgets::Take(sender),
+                                                           DBusCallDeadline(budget_ms)))
+    {
+    }
+
+    ~DBusCallDeadlineScope()
+    {
+        DBusCallDeadline::current() = previous;
+    }
+
+    DBusCallDeadlineScope(const DBusCallDeadlineScope&) = delete;
+    DBusCallDeadlineScope& operator=(const DBusCallDeadlineScope&) = delete;
+
+private:
+    DBusCallDeadline previous;
+};
+
+#endif // OPENVPN3_DBUS_DEADLINE_HPP
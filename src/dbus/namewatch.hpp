@@ -0,0 +1,124 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   namewatch.hpp
+ *
+ * @brief  Watches a D-Bus bus name appearing and vanishing
+ */
+
+#ifndef OPENVPN3_DBUS_NAMEWATCH_HPP
+#define OPENVPN3_DBUS_NAMEWATCH_HPP
+
+#include <functional>
+#include <string>
+#include <gio/gio.h>
+
+
+/**
+ *  Calls a function whenever a D-Bus bus name gets an owner or loses it,
+ *  using the NameOwnerChanged tracking in GDBus.  This avoids polling a
+ *  service to find out if it is running.
+ *
+ *  The callbacks are run from the thread-default main context of the
+ *  thread creating the DBusNameWatch.  The watch may be deleted from
+ *  within one of its own callbacks.
+ */
+class DBusNameWatch
+{
+public:
+    typedef std::function<void(const std::string& owner)> AppearedCallback;
+    typedef std::function<void()> VanishedCallback;
+
+    /**
+     *  Starts watching a bus name.  One of the callbacks is always
+     *  called once the initial owner lookup completes.
+     *
+     * @param conn      GDBusConnection to watch the bus name on
+     * @param name      std::string with the bus name to watch
+     * @param appeared  Called with the unique bus name of the new owner
+     *                  when the bus name gets an owner.  May be nullptr.
+     * @param vanished  Called when the bus name has no owner.  May be
+     *                  nullptr.
+     */
+    DBusNameWatch(GDBusConnection *conn, const std::string& name,
+                  AppearedCallback appeared, VanishedCallback vanished)
+        : data(new WatchData{appeared, vanished, true})
+    {
+        watch_id = g_bus_watch_name_on_connection(conn, name.c_str(),
+                                                  G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                  name_appeared,
+                                                  name_vanished,
+                                                  data,
+                                                  watch_data_free);
+    }
+
+    ~DBusNameWatch()
+    {
+        // Callbacks already queued in the main context may still be
+        // dispatched after g_bus_unwatch_name(); they are ignored
+        data->active = false;
+        g_bus_unwatch_name(watch_id);
+    }
+
+    DBusNameWatch(const DBusNameWatch&) = delete;
+    DBusNameWatch& operator=(const DBusNameWatch&) = delete;
+
+
+private:
+    struct WatchData
+    {
+        AppearedCallback appeared;
+        VanishedCallback vanished;
+        bool active;
+    };
+
+    WatchData *data = nullptr;
+    guint watch_id = 0;
+
+
+    static void name_appeared(GDBusConnection *conn, const gchar *name,
+                              const gchar *owner, gpointer user_data)
+    {
+        WatchData *d = static_cast<WatchData *>(user_data);
+        if (d->active && d->appeared)
+        {
+            d->appeared(std::string(owner));
+        }
+    }
+
+
+    static void name_vanished(GDBusConnection *conn, const gchar *name,
+                              gpointer user_data)
+    {
+        WatchData *d = static_cast<WatchData *>(user_data);
+        if (d->active && d->vanished)
+        {
+            d->vanished();
+        }
+    }
+
+
+    static void watch_data_free(gpointer user_data)
+    {
+        delete static_cast<WatchData *>(user_data);
+    }
+};
+
+#endif // OPENVPN3_DBUS_NAMEWATCH_HPP
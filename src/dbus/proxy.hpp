@@ -23,7 +23,9 @@
 
 #include <gio-unix-2.0/gio/gunixfdlist.h>
 
+#include "constants.hpp"
 #include "glibutils.hpp"
+#include "deadline.hpp"
 
 namespace openvpn
 {
@@ -71,6 +73,7 @@ namespace openvpn
               interface(std::move(interf)),
               object_path(std::move(objpath)),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
+              call_timeout(-1),
               proxy_init(false),
               property_proxy_init(false)
         {
@@ -93,6 +96,7 @@ namespace openvpn
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
+              call_timeout(-1),
               proxy_init(false),
               property_proxy_init(false)
         {
@@ -117,6 +121,7 @@ namespace openvpn
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
+              call_timeout(-1),
               proxy_init(false),
               property_proxy_init(false)
         {
@@ -139,6 +144,7 @@ namespace openvpn
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
+              call_timeout(-1),
               proxy_init(false),
               property_proxy_init(false)
         {
@@ -163,6 +169,7 @@ namespace openvpn
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
+              call_timeout(-1),
               proxy_init(false),
               property_proxy_init(false)
         {
@@ -185,6 +192,7 @@ namespace openvpn
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
+              call_timeout(-1),
               proxy_init(false),
               property_proxy_init(false)
         {
@@ -237,6 +245,43 @@ namespace openvpn
         }
 
 
+        /**
+         *  Sets the default timeout used for all method calls and
+         *  property operations done through this proxy.
+         *
+         * @param timeout_ms  Timeout in milliseconds.  -1 uses the D-Bus
+         *                    default timeout.
+         */
+        void SetGDBusCallTimeout(const int timeout_ms)
+        {
+            call_timeout = timeout_ms;
+        }
+
+
+        /**
+         * @return  Returns the default call timeout of this proxy in
+         *          milliseconds, -1 if the D-Bus default is used.
+         */
+        int GetGDBusCallTimeout() const
+        {
+            return call_timeout;
+        }
+
+
+        /**
+         *  Passes the time budget of each method call and property
+         *  operation done through this proxy on to the service, by
+         *  calling its SetCallBudget method first.  The budget is the
+         *  timeout of the call, which already includes the remaining
+         *  budget of the active DBusCallDeadlineScope.  Only enable this
+         *  for services implementing SetCallBudget.
+         */
+        void EnableCallBudgetPropagation()
+        {
+            propagate_budget = true;
+        }
+
+
         /**
          *  Some service expose a 'version' property in the main manager
          *  object.  This retrieves this but has a retry logic in case the
@@ -454,7 +499,7 @@ namespace openvpn
                 }
                 catch (DBusException& excp)
                 {
-                    if (2 == i)
+                    if (2 == i || DBusCallDeadline::Current().Expired())
                     {
                         THROW_DBUSEXCEPTION("DBusProxy",
                                             "D-Bus service '"
@@ -479,6 +524,7 @@ namespace openvpn
                                    call_flags);
         }
 
+
         GVariant * CallGetFD(std::string method, int& fd, bool noresponse = false) const
         {
             return dbus_proxy_call(proxy, method, NULL, noresponse,
@@ -508,6 +554,8 @@ namespace openvpn
             // instead of going via a list of cached properties.  The cache
             // might not be updated and we get the wrong values.
 
+            int timeout = get_call_timeout(property + " property");
+            announce_call_budget(timeout);
             GError *error = NULL;
             GVariant *response = g_dbus_proxy_call_sync(property_proxy,
                                                         "Get",
@@ -515,7 +563,7 @@ namespace openvpn
                                                                       interface.c_str(),
                                                                       property.c_str()),
                                                         G_DBUS_CALL_FLAGS_NONE,
-                                                        -1,          // timeout, -1 == default
+                                                        timeout,
                                                         NULL,        // GCancellable
                                                         &error);
             if (!response && !error)
@@ -594,6 +642,8 @@ namespace openvpn
             // proxy connection.  But that only updates the local cache, the
             // change is never sent to the backend service.
 
+            int timeout = get_call_timeout(property + " property");
+            announce_call_budget(timeout);
             GError *error = NULL;
             GVariant *ret = g_dbus_proxy_call_sync(property_proxy,
                                                    "Set",
@@ -602,7 +652,7 @@ namespace openvpn
                                                                  property.c_str(),
                                                                  value),
                                                    G_DBUS_CALL_FLAGS_NONE,
-                                                   -1,          // timeout, -1 == default
+                                                   timeout,
                                                    NULL,        // GCancellable
                                                    &error);
             if (!ret && !error)
@@ -727,8 +777,63 @@ namespace openvpn
         std::string interface;
         std::string object_path;
         GDBusCallFlags call_flags;
+        int call_timeout;
         bool proxy_init;
         bool property_proxy_init;
+        bool propagate_budget = false;
+
+
+        /**
+         *  Calculates the timeout to use for the next D-Bus call, based on
+         *  the proxy default and the deadline of the current
+         *  DBusCallDeadlineScope
+         *
+         * @param what  Description of the operation, used in the error
+         *              message
+         *
+         * @return  Returns the timeout in milliseconds to give to GDBus.
+         *          Throws DBusException if the deadline has already passed.
+         */
+        int get_call_timeout(const std::string& what) const
+        {
+            const DBusCallDeadline& deadline = DBusCallDeadline::Current();
+            if (deadline.Expired())
+            {
+                THROW_DBUSEXCEPTION("DBusProxy",
+                                    "Deadline exceeded before calling "
+                                    + what);
+            }
+            return deadline.Timeout(call_timeout);
+        }
+
+
+        /**
+         *  Announces the time budget of the next call to the service, if
+         *  enabled by EnableCallBudgetPropagation().  No reply is
+         *  requested; D-Bus delivers the messages of a connection in
+         *  order, so the budget arrives right before the call.
+         *
+         * @param timeout  Timeout of the next call, as returned by
+         *                 get_call_timeout().  Nothing is announced when
+         *                 the D-Bus default timeout is used.
+         */
+        void announce_call_budget(const int timeout) const
+        {
+            if (!propagate_budget || 0 > timeout)
+            {
+                return;
+            }
+
+            // Leave the service time to report an error back to us
+            int budget = timeout - OpenVPN3DBus_timeout_margin;
+            g_dbus_proxy_call(proxy, "SetCallBudget",
+                              g_variant_new("(u)", (guint) (0 < budget ? budget : 1)),
+                              call_flags,
+                              -1,
+                              nullptr,     // GCancellable
+                              nullptr,     // No response callback, no reply is sent
+                              nullptr);
+        }
 
         // Note we only implement single fd out/in for the fd API since that
         // is all we currently need and handling fd extraction here makes
@@ -752,6 +857,12 @@ namespace openvpn
             GUnixFDList *out_fdlist = nullptr;
             if (!noresponse)
             {
+                int timeout = get_call_timeout(method);
+                if (prx == proxy)
+                {
+                    announce_call_budget(timeout);
+                }
+
                 // Where we care about the response, we use a synchronous call
                 // and wait for the response
                 if (!fd_out && fd_in == -1)
@@ -760,7 +871,7 @@ namespace openvpn
                                                  method.c_str(),
                                                  params,      // parameters to method
                                                  flags,
-                                                 -1,          // timeout, -1 == default
+                                                 timeout,
                                                  nullptr,        // GCancellable
                                                  &error);
                 }
@@ -785,7 +896,7 @@ namespace openvpn
                                                                        method.c_str(),
                                                                        params,      // parameters to method
                                                                        flags,
-                                                                       -1,          // timeout, -1 == default
+                                                                       timeout,
                                                                        fdlist,     // fd_list (to send)
                                                                        out_fdlist_ptr,
                                                                        nullptr,        // GCancellable
@@ -793,8 +904,23 @@ namespace openvpn
                     }
                     if(ret && !error && fd_out)
                     {
-                        *fd_out = g_unix_fd_list_get(out_fdlist, 0, &error);
-                        GLibUtils::unref_fdlist(out_fdlist);
+                        if (out_fdlist)
+                        {
+                            *fd_out = g_unix_fd_list_get(out_fdlist, 0, &error);
+                            GLibUtils::unref_fdlist(out_fdlist);
+                        }
+                        else
+                        {
+                            g_set_error_literal(&error, G_IO_ERROR,
+                                                G_IO_ERROR_FAILED,
+                                                "No file descriptor in the reply");
+                        }
+                        if (error)
+                        {
+                            // The caller cannot use the reply without the fd
+                            g_variant_unref(ret);
+                            ret = nullptr;
+                        }
                     }
                     if (fdlist)
                     {
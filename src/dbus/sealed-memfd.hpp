@@ -0,0 +1,410 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   sealed-memfd.hpp
+ *
+ * @brief  Passing of large data blobs and shared memory segments as
+ *         sealed memfd file descriptors over D-Bus
+ */
+
+#ifndef OPENVPN3_DBUS_SEALED_MEMFD_HPP
+#define OPENVPN3_DBUS_SEALED_MEMFD_HPP
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+class SealedMemfdException : public std::exception
+{
+public:
+    SealedMemfdException(const std::string& msg) : message(msg)
+    {
+    }
+
+    const char* what() const noexcept
+    {
+        return message.c_str();
+    }
+
+private:
+    std::string message{};
+};
+
+
+/// Seals required on a memfd before its contents are trusted
+static const int sealed_memfd_required_seals = F_SEAL_SHRINK | F_SEAL_GROW
+                                               | F_SEAL_WRITE;
+
+
+inline std::string sealed_memfd_errmsg(const std::string& msg)
+{
+    return msg + ": " + std::string(strerror(errno));
+}
+
+
+/**
+ *  Creates an anonymous memory backed file containing the provided
+ *  data.  The file is sealed, so neither the sender nor the receiver can
+ *  modify it once it has been passed to another process.
+ *
+ * @param name  std::string with the name of the memfd, only used for
+ *              debugging purposes (visible in /proc/$PID/fd)
+ * @param data  std::string with the contents of the file
+ *
+ * @return  Returns the file descriptor of the sealed memfd.  The caller
+ *          is responsible for closing it.
+ *
+ * @throws  SealedMemfdException on errors
+ */
+inline int sealed_memfd_create(const std::string& name,
+                               const std::string& data)
+{
+    int fd = memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (-1 == fd)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("Could not create memfd"));
+    }
+
+    const char *p = data.data();
+    size_t left = data.size();
+    while (left > 0)
+    {
+        ssize_t r = write(fd, p, left);
+        if (0 > r)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            std::string err = sealed_memfd_errmsg("Could not write to memfd");
+            close(fd);
+            throw SealedMemfdException(err);
+        }
+        p += r;
+        left -= r;
+    }
+
+    if (0 != fcntl(fd, F_ADD_SEALS, sealed_memfd_required_seals | F_SEAL_SEAL)
+        || 0 != lseek(fd, 0, SEEK_SET))
+    {
+        std::string err = sealed_memfd_errmsg("Could not seal memfd");
+        close(fd);
+        throw SealedMemfdException(err);
+    }
+    return fd;
+}
+
+
+/**
+ *  Reads the contents of a sealed memfd, as created by
+ *  sealed_memfd_create().  Any file descriptor which is not a memfd
+ *  sealed against writing, growing and shrinking is rejected, as the
+ *  sending process could otherwise modify or block the data while it is
+ *  being processed.
+ *
+ * @param fd        File descriptor to read.  It is not closed.
+ * @param max_size  Maximum accepted size of the data
+ *
+ * @return  Returns a std::string with the contents of the memfd
+ *
+ * @throws  SealedMemfdException on errors or if the file descriptor
+ *          is not acceptable
+ */
+inline std::string sealed_memfd_read(int fd, size_t max_size)
+{
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (-1 == seals)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("File descriptor is not a memfd"));
+    }
+    if (sealed_memfd_required_seals != (seals & sealed_memfd_required_seals))
+    {
+        throw SealedMemfdException("The memfd is not sealed");
+    }
+
+    struct stat st;
+    if (0 != fstat(fd, &st))
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("Could not access memfd"));
+    }
+    if (max_size < (size_t) st.st_size)
+    {
+        throw SealedMemfdException("The memfd contents is too large");
+    }
+
+    std::string ret(st.st_size, '\0');
+    size_t done = 0;
+    while (done < ret.size())
+    {
+        // The sealed size cannot change, so reading less than
+        // requested is only possible on errors
+        ssize_t r = pread(fd, &ret[done], ret.size() - done, done);
+        if (0 > r && EINTR == errno)
+        {
+            continue;
+        }
+        if (0 > r)
+        {
+            throw SealedMemfdException(
+                    sealed_memfd_errmsg("Could not read memfd"));
+        }
+        if (0 == r)
+        {
+            throw SealedMemfdException("Unexpected end of memfd");
+        }
+        done += r;
+    }
+    return ret;
+}
+
+
+/**
+ *  Maps the contents of a sealed memfd, as created by
+ *  sealed_memfd_create(), read-only into memory.  The same seals as
+ *  sealed_memfd_read() requires are checked, so the data cannot change
+ *  while the mapping is in use.  This avoids copying large data before
+ *  it is processed.
+ *
+ * @param fd        File descriptor to map.  It is not closed.
+ * @param max_size  Maximum accepted size of the data
+ * @param size      Set to the size of the data
+ *
+ * @return  Returns the address of the mapping, which is released with
+ *          munmap().  If the memfd is empty, nullptr is returned and
+ *          there is nothing to release.
+ *
+ * @throws  SealedMemfdException on errors or if the file descriptor
+ *          is not acceptable
+ */
+inline const char * sealed_memfd_map(int fd, size_t max_size, size_t& size)
+{
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (-1 == seals)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("File descriptor is not a memfd"));
+    }
+    if (sealed_memfd_required_seals != (seals & sealed_memfd_required_seals))
+    {
+        throw SealedMemfdException("The memfd is not sealed");
+    }
+
+    struct stat st;
+    if (0 != fstat(fd, &st))
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("Could not access memfd"));
+    }
+    if (max_size < (size_t) st.st_size)
+    {
+        throw SealedMemfdException("The memfd contents is too large");
+    }
+
+    size = st.st_size;
+    if (0 == size)
+    {
+        return nullptr;
+    }
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == addr)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("Could not map memfd"));
+    }
+    return static_cast<const char *>(addr);
+}
+
+
+/**
+ *  Creates an anonymous memory backed file of a fixed size, shared
+ *  between a single writer and any number of readers.  The file is
+ *  mapped writable in the calling process and its size is sealed, so
+ *  readers can map it without risking a SIGBUS.  Where the kernel
+ *  supports it (Linux 5.1 and newer), F_SEAL_FUTURE_WRITE is added as
+ *  well, which prevents any new write or writable mapping; only the
+ *  mapping returned here can modify the contents.
+ *
+ *  Readers should be given a descriptor from sealed_memfd_reopen_readonly()
+ *  and map it with sealed_memfd_map_readonly().
+ *
+ * @param name  std::string with the name of the memfd, only used for
+ *              debugging purposes (visible in /proc/$PID/fd)
+ * @param size  Size of the file, in bytes
+ * @param map   Pointer where the address of the writable mapping is
+ *              stored.  It is released with munmap().
+ *
+ * @return  Returns the file descriptor of the memfd.  The caller is
+ *          responsible for closing it.
+ *
+ * @throws  SealedMemfdException on errors
+ */
+inline int sealed_memfd_create_shared(const std::string& name, size_t size,
+                                      void **map)
+{
+    int fd = memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (-1 == fd)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("Could not create memfd"));
+    }
+    if (0 != ftruncate(fd, size))
+    {
+        std::string err = sealed_memfd_errmsg("Could not resize memfd");
+        close(fd);
+        throw SealedMemfdException(err);
+    }
+
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+    if (MAP_FAILED == addr)
+    {
+        std::string err = sealed_memfd_errmsg("Could not map memfd");
+        close(fd);
+        throw SealedMemfdException(err);
+    }
+
+    int seals = F_SEAL_SHRINK | F_SEAL_GROW;
+#ifdef F_SEAL_FUTURE_WRITE
+    seals |= F_SEAL_FUTURE_WRITE;
+    if (0 != fcntl(fd, F_ADD_SEALS, seals) && EINVAL == errno)
+    {
+        // Kernels before 5.1 do not know about F_SEAL_FUTURE_WRITE
+        seals &= ~F_SEAL_FUTURE_WRITE;
+    }
+#endif
+    if (0 != fcntl(fd, F_ADD_SEALS, seals | F_SEAL_SEAL))
+    {
+        std::string err = sealed_memfd_errmsg("Could not seal memfd");
+        munmap(addr, size);
+        close(fd);
+        throw SealedMemfdException(err);
+    }
+    *map = addr;
+    return fd;
+}
+
+
+/**
+ *  Opens a new, read-only file descriptor of a memfd created by
+ *  sealed_memfd_create_shared().  This is the descriptor to pass to other
+ *  processes.
+ *
+ *  The read-only open mode alone does not protect the contents, as the
+ *  receiver can open /proc/self/fd/N of its copy again with write access.
+ *  Only F_SEAL_FUTURE_WRITE stops that, so a memfd without this seal is
+ *  refused.
+ *
+ * @param fd  File descriptor of the memfd.  It is not closed.
+ *
+ * @return  Returns the new file descriptor.  The caller is responsible
+ *          for closing it.
+ *
+ * @throws  SealedMemfdException on errors or if the memfd is not sealed
+ *          with F_SEAL_FUTURE_WRITE
+ */
+inline int sealed_memfd_reopen_readonly(int fd)
+{
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (-1 == seals)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("File descriptor is not a memfd"));
+    }
+#ifdef F_SEAL_FUTURE_WRITE
+    if (0 == (seals & F_SEAL_FUTURE_WRITE))
+#endif
+    {
+        throw SealedMemfdException("The memfd cannot be shared read-only, "
+                                   "F_SEAL_FUTURE_WRITE is not available");
+    }
+
+    std::string path = "/proc/self/fd/" + std::to_string(fd);
+    int rofd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (-1 == rofd)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("Could not reopen memfd"));
+    }
+    return rofd;
+}
+
+
+/**
+ *  Maps a memfd created by sealed_memfd_create_shared() read-only.  Any
+ *  file descriptor which is not a memfd sealed against growing and
+ *  shrinking is rejected, as the sending process could otherwise
+ *  truncate the file and make any access to the mapping fail.
+ *
+ * @param fd        File descriptor to map.  It is not closed.
+ * @param min_size  Minimum accepted size of the file
+ * @param max_size  Maximum accepted size of the file
+ * @param size      Set to the size of the mapping
+ *
+ * @return  Returns the address of the mapping, which is released with
+ *          munmap()
+ *
+ * @throws  SealedMemfdException on errors or if the file descriptor
+ *          is not acceptable
+ */
+inline const void * sealed_memfd_map_readonly(int fd, size_t min_size,
+                                              size_t max_size, size_t& size)
+{
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (-1 == seals)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("File descriptor is not a memfd"));
+    }
+    if ((F_SEAL_SHRINK | F_SEAL_GROW) != (seals & (F_SEAL_SHRINK | F_SEAL_GROW)))
+    {
+        throw SealedMemfdException("The memfd size is not sealed");
+    }
+
+    struct stat st;
+    if (0 != fstat(fd, &st))
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("Could not access memfd"));
+    }
+    if (min_size > (size_t) st.st_size || max_size < (size_t) st.st_size)
+    {
+        throw SealedMemfdException("Unexpected size of the memfd");
+    }
+
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == addr)
+    {
+        throw SealedMemfdException(
+                sealed_memfd_errmsg("Could not map memfd"));
+    }
+    size = st.st_size;
+    return addr;
+}
+
+#endif // OPENVPN3_DBUS_SEALED_MEMFD_HPP
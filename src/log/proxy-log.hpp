@@ -74,6 +74,7 @@ public:
                     OpenVPN3DBus_interf_log,
                     OpenVPN3DBus_rootp_log)
     {
+        SetGDBusCallTimeout(OpenVPN3DBus_timeout_log);
         CheckServiceAvail();
         try
         {
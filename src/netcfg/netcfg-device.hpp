@@ -211,6 +211,7 @@ public:
                    << "        <property type='b'  name='modified' access='read'/>"
                    << "        <property type='as'  name='dns_name_servers' access='read'/>"
                    << "        <property type='as'  name='dns_search_domains' access='read'/>"
+                   << "        <property type='(xx)' name='dns_commit_timing' access='read'/>"
                    << properties.GetIntrospectionXML()
                    << signal.GetLogIntrospection()
                    << NetCfgChangeEvent::IntrospectionXML()
@@ -409,7 +410,9 @@ public:
                                  "Activating DNS/resolver settings: "
                                  + details.str());
 
+                    dns_commit_begin = g_get_monotonic_time();
                     resolver->ApplySettings(&signal);
+                    dns_commit_end = g_get_monotonic_time();
                     modified = false;
                 }
                 if (!tunimpl)
@@ -576,6 +579,11 @@ public:
             {
                 return GLibUtils::GVariantFromVector(dnsconfig->GetSearchDomains());
             }
+            else if ("dns_commit_timing" == property_name)
+            {
+                return g_variant_new("(xx)", (gint64) dns_commit_begin,
+                                     (gint64) dns_commit_end);
+            }
             else if (properties.Exists(property_name))
             {
                 return properties.GetValue(property_name);
@@ -695,6 +703,8 @@ private:
     bool modified = false;
     NetCfgOptions options;
     bool active = false;
+    int64_t dns_commit_begin = 0;  ///< Monotonic time of the last DNS commit
+    int64_t dns_commit_end = 0;
 
     pid_t creatorPid;
 
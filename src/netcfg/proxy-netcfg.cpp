@@ -53,6 +53,7 @@ namespace NetCfgProxy
                     OpenVPN3DBus_interf_netcfg,
                     OpenVPN3DBus_rootp_netcfg)
     {
+        SetGDBusCallTimeout(OpenVPN3DBus_timeout_netcfg);
     }
 
 
@@ -297,6 +298,7 @@ namespace NetCfgProxy
                     OpenVPN3DBus_interf_netcfg,
                     devpath)
     {
+        SetGDBusCallTimeout(OpenVPN3DBus_timeout_netcfg);
     }
 
 
@@ -532,4 +534,17 @@ namespace NetCfgProxy
         std::vector<std::string> ret;
         return ret;
     }
+
+
+    bool Device::GetDNSCommitTiming(int64_t& begin, int64_t& end)
+    {
+        GVariant *res = GetProperty("dns_commit_timing");
+        gint64 b = 0;
+        gint64 e = 0;
+        g_variant_get(res, "(xx)", &b, &e);
+        g_variant_unref(res);
+        begin = b;
+        end = e;
+        return 0 < begin;
+    }
 } // namespace NetCfgProxy
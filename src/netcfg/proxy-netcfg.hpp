@@ -240,6 +240,19 @@ namespace NetCfgProxy
         std::vector<std::string> GetDNS();
         std::vector<std::string> GetDNSSearch();
 
+        /**
+         *  Retrieves when the DNS settings were last applied by
+         *  Establish()
+         *
+         * @param begin  Set to the CLOCK_MONOTONIC timestamp of the
+         *               start, in microseconds
+         * @param end    Set to the CLOCK_MONOTONIC timestamp of the
+         *               end, in microseconds
+         *
+         * @return Returns false if the DNS settings have not been applied
+         */
+        bool GetDNSCommitTiming(int64_t& begin, int64_t& end);
+
         void SetRemoteAddress(const std::string& remote, bool ipv6);
     };
 } // namespace NetCfgProxy
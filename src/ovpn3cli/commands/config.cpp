@@ -104,8 +104,8 @@ std::string import_config(const std::string filename,
     // Import the configuration fileh
     OpenVPN3ConfigurationProxy conf(G_BUS_TYPE_SYSTEM, OpenVPN3DBus_rootp_configuration);
     conf.Ping();
-    std::string  cfgpath = conf.Import(cfgname, pm.profile_content(),
-                                       single_use, persistent);
+    std::string  cfgpath = conf.ImportFD(cfgname, pm.profile_content(),
+                                         single_use, persistent);
 
     // If the configuration profile contained --persist-tun,
     // set the related property in the D-Bus configuration object.
@@ -201,12 +201,74 @@ SingleCommand::Ptr prepare_command_config_import()
  *  or profiles tagged with public_access will be listed.  This restriction
  *  is handled by the Configuration Manager.
  *
+ *  The list can be narrowed down with one or more --filter KEY=VALUE
+ *  options, which are all handled by the Configuration Manager.
+ *
  * @param args  ParsedArgs object containing all related options and arguments
  * @return Returns the exit code which will be returned to the calling shell
  *
  */
 static int cmd_configs_list(ParsedArgs args)
 {
+    ConfigurationFilter filter;
+    if (args.Present("filter"))
+    {
+        for (const auto& flt : args.GetAllValues("filter"))
+        {
+            size_t sep = flt.find('=');
+            std::string key = flt.substr(0, sep);
+            std::string value = (std::string::npos != sep ? flt.substr(sep + 1) : "");
+            if ("persistent" == key)
+            {
+                filter.persistent_only = true;
+                continue;
+            }
+            if (value.empty())
+            {
+                throw CommandException("configs-list",
+                                       "Missing value in filter '" + flt + "'");
+            }
+
+            if ("owner" == key)
+            {
+                try
+                {
+                    filter.owner = get_userid(value);
+                    filter.owner_set = true;
+                }
+                catch (const LookupException& excp)
+                {
+                    throw CommandException("configs-list", excp.what());
+                }
+            }
+            else if ("name" == key)
+            {
+                filter.name_prefix = value;
+            }
+            else if ("host" == key)
+            {
+                filter.remote_host = value;
+            }
+            else if ("port" == key)
+            {
+                filter.remote_port = value;
+            }
+            else if ("proto" == key)
+            {
+                filter.remote_proto = value;
+            }
+            else if ("override" == key)
+            {
+                filter.override_filter = value;
+            }
+            else
+            {
+                throw CommandException("configs-list",
+                                       "Unknown filter '" + key + "'");
+            }
+        }
+    }
+
     OpenVPN3ConfigurationProxy confmgr(G_BUS_TYPE_SYSTEM, OpenVPN3DBus_rootp_configuration );
     confmgr.Ping();
 
@@ -219,43 +281,35 @@ static int cmd_configs_list(ParsedArgs args)
               << std::endl;
     std::cout << std::setw(32+26+18+2) << std::setfill('-') << "-" << std::endl;
 
+    // All the details are retrieved in a single call, instead of
+    // querying each configuration object for each of its properties
     bool first = true;
-    for (auto& cfg : confmgr.FetchAvailableConfigs())
+    for (const auto& cfg : confmgr.FetchAvailableConfigDetails(filter))
     {
-        if (cfg.empty())
-        {
-            continue;
-        }
-        OpenVPN3ConfigurationProxy cprx(G_BUS_TYPE_SYSTEM, cfg);
-
         if (!first)
         {
             std::cout << std::endl;
         }
         first = false;
 
-        std::string name = cprx.GetStringProperty("name");
-        std::string user = lookup_username(cprx.GetUIntProperty("owner"));
+        std::string user = lookup_username(cfg.owner);
 
-        std::time_t imp_tstamp = cprx.GetUInt64Property("import_timestamp");
-        std::string imported(std::asctime(std::localtime(&imp_tstamp)));
+        std::string imported(std::asctime(std::localtime(&cfg.import_tstamp)));
         imported.erase(imported.find_last_not_of(" \n")+1); // rtrim
 
-        std::time_t last_u_tstamp = cprx.GetUInt64Property("last_used_timestamp");
         std::string last_used;
-        if (last_u_tstamp > 0)
+        if (cfg.last_used_tstamp > 0)
         {
-            last_used = std::asctime(std::localtime(&last_u_tstamp));
+            last_used = std::asctime(std::localtime(&cfg.last_used_tstamp));
             last_used.erase(last_used.find_last_not_of(" \n")+1);  // rtrim
         }
-        unsigned int used_count = cprx.GetUIntProperty("used_count");
 
-        std::cout << cfg << std::endl;
+        std::cout << cfg.path << std::endl;
         std::cout << imported << std::setw(32 - imported.size()) << std::setfill(' ') << " "
                   << last_used <<  std::setw(26 - last_used.size()) << " "
-                  << std::to_string(used_count)
+                  << std::to_string(cfg.used_count)
                   << std::endl;
-        std::cout << name << std::setw(58 - name.size()) << " " << user
+        std::cout << cfg.name << std::setw(58 - cfg.name.size()) << " " << user
                   << std::endl;
     }
     std::cout << std::setw(32+26+18+2) << std::setfill('-') << "-" << std::endl;
@@ -277,6 +331,10 @@ SingleCommand::Ptr prepare_command_configs_list()
     cmd.reset(new SingleCommand("configs-list",
                                 "List all available configuration profiles",
                                 cmd_configs_list));
+    cmd->AddOption("filter", 'f', "KEY=VALUE", true,
+                   "Only list profiles matching this filter; may be used "
+                   "multiple times.  Keys: owner, name (prefix), host, "
+                   "port, proto, override (NAME or NAME=VALUE), persistent");
     return cmd;
 }
 
@@ -323,9 +381,9 @@ static int config_manage_show(OpenVPN3ConfigurationProxy& conf,
             std::string value = "(not set)";
             for (auto & ov: overrides)
             {
-                if (ov.override.key == vo.key)
+                if (ov.override->key == vo.key)
                 {
-                    if (OverrideType::boolean == ov.override.type)
+                    if (OverrideType::boolean == ov.override->type)
                         value = ov.boolValue ? "true" : "false";
                     else
                         value = ov.strValue;
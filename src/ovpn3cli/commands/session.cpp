@@ -23,6 +23,8 @@
  * @brief  Commands to start and manage VPN sessions
  */
 
+#include <algorithm>
+#include <iomanip>
 #include <json/json.h>
 
 #include "dbus/core.hpp"
@@ -60,6 +62,198 @@ static ConnectionStats fetch_stats(std::string session_path)
 }
 
 
+/**
+ *  Fetches the throughput rates for a specific session
+ *
+ * @param session_path  std::string containing the D-Bus session path
+ * @return Returns a std::vector<StatisticsRate> with the rates of all
+ *         the tracked counters
+ */
+static std::vector<StatisticsRate> fetch_rates(std::string session_path)
+{
+    try
+    {
+        OpenVPN3SessionProxy session(G_BUS_TYPE_SYSTEM, session_path);
+        if (!session.CheckObjectExists())
+        {
+            throw CommandException("session-stats",
+                                   "Session not found");
+        }
+        return session.FetchStatisticsHistory(0).rates;
+    }
+    catch (DBusException& err)
+    {
+        std::stringstream errmsg;
+        errmsg << "Failed to fetch statistics: " << err.GetRawError();
+        throw CommandException("session-stats",  errmsg.str());
+    }
+}
+
+
+/**
+ *  Converts the throughput rates into a plain-text string
+ *
+ * @param rates  The std::vector<StatisticsRate> returned by fetch_rates()
+ * @return Returns std::string with the rates pre-formatted as text/plain
+ */
+static std::string rates_plain(const std::vector<StatisticsRate>& rates)
+{
+    std::stringstream out;
+    out << std::endl << "Throughput per second:" << std::endl
+        << "     " << std::string(20, ' ')
+        << std::setw(13) << "1s"
+        << std::setw(14) << "10s"
+        << std::setw(14) << "60s" << std::endl;
+    out << std::fixed << std::setprecision(1);
+    for (const auto& r : rates)
+    {
+        out << "     "
+            << r.key
+            << std::setw(20-r.key.size()) << std::setfill('.') << "."
+            << std::setfill(' ')
+            << std::setw(13) << r.rate_1s
+            << std::setw(14) << r.rate_10s
+            << std::setw(14) << r.rate_60s
+            << std::endl;
+    }
+    out << std::endl;
+    return out.str();
+}
+
+
+/**
+ *  Similiar to rates_plain(), but returns a JSON string blob with the
+ *  throughput rates
+ *
+ * @param rates  The std::vector<StatisticsRate> returned by fetch_rates()
+ * @return Returns std::string with the rates pre-formatted as JSON
+ */
+static std::string rates_json(const std::vector<StatisticsRate>& rates)
+{
+    Json::Value outdata;
+
+    for (const auto& r : rates)
+    {
+        outdata[r.key]["1s"] = r.rate_1s;
+        outdata[r.key]["10s"] = r.rate_10s;
+        outdata[r.key]["60s"] = r.rate_60s;
+    }
+    std::stringstream res;
+    res << outdata;
+    res << std::endl;
+    return res.str();
+}
+
+
+/**
+ *  Fetches the startup timings for a specific session
+ *
+ * @param session_path  std::string containing the D-Bus session path
+ * @return Returns the phases of the session start which have begun
+ */
+static std::vector<StartupPhaseTiming> fetch_timings(std::string session_path)
+{
+    try
+    {
+        OpenVPN3SessionProxy session(G_BUS_TYPE_SYSTEM, session_path);
+        if (!session.CheckObjectExists())
+        {
+            throw CommandException("session-stats",
+                                   "Session not found");
+        }
+        return session.GetStartupTimings().GetPhases();
+    }
+    catch (DBusException& err)
+    {
+        std::stringstream errmsg;
+        errmsg << "Failed to fetch startup timings: " << err.GetRawError();
+        throw CommandException("session-stats",  errmsg.str());
+    }
+}
+
+
+/**
+ *  Converts the startup timings into a plain-text string.  Each phase is
+ *  listed with its start time, relative to the start of the first phase,
+ *  and its duration; both in milliseconds.
+ *
+ * @param phases  The std::vector<StartupPhaseTiming> returned by
+ *                fetch_timings()
+ * @return Returns std::string with the timings pre-formatted as text/plain
+ */
+static std::string timings_plain(const std::vector<StartupPhaseTiming>& phases)
+{
+    if (phases.empty())
+    {
+        return "";
+    }
+
+    int64_t origin = phases[0].begin;
+    for (const auto& p : phases)
+    {
+        origin = std::min(origin, p.begin);
+    }
+
+    std::stringstream out;
+    out << std::endl << "Session startup timings (ms):" << std::endl
+        << "     " << std::string(26, ' ')
+        << std::setw(12) << "start"
+        << std::setw(12) << "duration" << std::endl;
+    out << std::fixed << std::setprecision(1);
+    for (const auto& p : phases)
+    {
+        std::string name(StartupTimings::PhaseName(p.phase));
+        out << "     "
+            << name
+            << std::setw(26-name.size()) << std::setfill('.') << "."
+            << std::setfill(' ')
+            << std::setw(12) << (p.begin - origin) / 1000.0;
+        if (0 <= p.Duration())
+        {
+            out << std::setw(12) << p.Duration() / 1000.0;
+        }
+        else
+        {
+            out << std::setw(12) << "-";
+        }
+        out << std::endl;
+    }
+    out << std::endl;
+    return out.str();
+}
+
+
+/**
+ *  Similiar to timings_plain(), but returns a JSON string blob with the
+ *  startup timings in microseconds.  The duration of phases which have
+ *  not completed is -1.
+ *
+ * @param phases  The std::vector<StartupPhaseTiming> returned by
+ *                fetch_timings()
+ * @return Returns std::string with the timings pre-formatted as JSON
+ */
+static std::string timings_json(const std::vector<StartupPhaseTiming>& phases)
+{
+    Json::Value outdata;
+
+    int64_t origin = (phases.empty() ? 0 : phases[0].begin);
+    for (const auto& p : phases)
+    {
+        origin = std::min(origin, p.begin);
+    }
+    for (const auto& p : phases)
+    {
+        const char *name = StartupTimings::PhaseName(p.phase);
+        outdata[name]["start"] = (Json::Value::Int64) (p.begin - origin);
+        outdata[name]["duration"] = (Json::Value::Int64) p.Duration();
+    }
+    std::stringstream res;
+    res << outdata;
+    res << std::endl;
+    return res.str();
+}
+
+
 /**
  *  Converts ConnectionStats into a plain-text string
  *
@@ -167,6 +361,22 @@ static int cmd_session_stats(ParsedArgs args)
             sesspath = args.GetValue("path", 0);
         }
 
+        if (args.Present("timings"))
+        {
+            std::vector<StartupPhaseTiming> phases = fetch_timings(sesspath);
+            std::cout << (args.Present("json") ? timings_json(phases)
+                                               : timings_plain(phases));
+            return 0;
+        }
+
+        if (args.Present("rates"))
+        {
+            std::vector<StatisticsRate> rates = fetch_rates(sesspath);
+            std::cout << (args.Present("json") ? rates_json(rates)
+                                               : rates_plain(rates));
+            return 0;
+        }
+
         ConnectionStats stats = fetch_stats(sesspath);
 
         std::cout << (args.Present("json") ? statistics_json(stats)
@@ -207,6 +417,10 @@ SingleCommand::Ptr prepare_command_session_stats()
                    "instead",
                    arghelper_managed_interfaces);
     cmd->AddOption("json", 'j', "Dump the configuration in JSON format");
+    cmd->AddOption("rates", 'r', "Show the throughput per second, averaged "
+                   "over the last 1, 10 and 60 seconds");
+    cmd->AddOption("timings", 't', "Show how long each phase of the session "
+                   "start took");
 
     return cmd;
 }
@@ -253,6 +253,32 @@ class ConfigurationManager(object):
         return Configuration(self.__dbuscon, path)
 
 
+    ##
+    #  Import several configuration profiles in a single call.  The
+    #  configuration manager parses the profiles in parallel.
+    #
+    #  @param configs  List of (cfgname, cfg, single_use, persistent) tuples,
+    #                  see Import() for details
+    #
+    #  @return Returns a list of (Configuration, error) tuples in the same
+    #          order as configs.  If a profile could not be imported, the
+    #          Configuration is None and error contains the reason.
+    #
+    def ImportBatch(self, configs):
+        self.__ping()
+        items = dbus.Array([dbus.Struct((n, c, bool(s), bool(p)),
+                                        signature='ssbb')
+                            for (n, c, s, p) in configs],
+                           signature='(ssbb)')
+        ret = []
+        for (path, error) in self.__manager_intf.ImportBatch(items):
+            if error:
+                ret.append((None, str(error)))
+            else:
+                ret.append((Configuration(self.__dbuscon, path), None))
+        return ret
+
+
     ##
     #  Retrieve a single Configuration object for a specific configuration path
     #
@@ -279,6 +305,47 @@ class ConfigurationManager(object):
         return ret
 
 
+    ##
+    #  Retrieve details about all available configuration profiles in a
+    #  single call to the configuration manager
+    #
+    #  @param owner        (optional) Only include profiles owned by this UID
+    #  @param name_prefix  (optional) Only include profiles where the name
+    #                      starts with this string
+    #  @param persistent   (optional) If True, only include persistent
+    #                      profiles
+    #  @param offset       Number of matching profiles to skip
+    #  @param limit        Maximum number of profiles to return, 0 for all
+    #
+    #  @return Returns a tuple with the total number of matching profiles
+    #          and a list of dictionaries with the profile details
+    #
+    def FetchAvailableConfigDetails(self, owner=None, name_prefix=None,
+                                    persistent=False, offset=0, limit=0):
+        self.__ping()
+        flt = dbus.Dictionary({}, signature='sv')
+        if owner is not None:
+            flt['owner'] = dbus.UInt32(owner)
+        if name_prefix:
+            flt['name_prefix'] = dbus.String(name_prefix)
+        if persistent:
+            flt['persistent'] = dbus.Boolean(True)
+
+        (total, configs) = self.__manager_intf.FetchAvailableConfigDetails(
+            flt, dbus.UInt32(offset), dbus.UInt32(limit))
+
+        ret = []
+        for c in configs:
+            ret.append({'path': str(c[0]),
+                        'name': str(c[1]),
+                        'import_timestamp': int(c[2]),
+                        'last_used_timestamp': int(c[3]),
+                        'owner': int(c[4]),
+                        'used_count': int(c[5]),
+                        'persistent': bool(c[6])})
+        return (int(total), ret)
+
+
     ##
     #  Looks up a configuration name to find available D-Bus paths to
     #  configuration objects with the given name.
@@ -30,10 +30,15 @@
 #define OPENVPN3_DBUS_PROXY_SESSION_HPP
 
 #include <iostream>
+#include <memory>
+#include <unistd.h>
 
 #include "dbus/core.hpp"
 #include "dbus/requiresqueue-proxy.hpp"
+#include "common/startup-timings.hpp"
 #include "client/statistics.hpp"
+#include "client/statistics-history.hpp"
+#include "client/statistics-segment.hpp"
 #include "client/statusevent.hpp"
 #include "log/log-helpers.hpp"
 #include "log/dbus-log.hpp"
@@ -96,6 +101,9 @@ public:
                                  "UserInputQueueCheck",
                                  "UserInputProvide")
     {
+        SetGDBusCallTimeout(OpenVPN3DBus_timeout_sessions);
+        EnableCallBudgetPropagation();
+
         // Only try to ensure the session manager service is available
         // when accessing the main management object
         if (OpenVPN3DBus_rootp_sessions == objpath)
@@ -121,6 +129,9 @@ public:
                                  "UserInputQueueCheck",
                                  "UserInputProvide")
     {
+        SetGDBusCallTimeout(OpenVPN3DBus_timeout_sessions);
+        EnableCallBudgetPropagation();
+
         // Only try to ensure the session manager service is available
         // when accessing the main management object
         if (OpenVPN3DBus_rootp_sessions == objpath)
@@ -229,6 +240,59 @@ public:
         return ret;
     }
 
+    /**
+     *  Retrieves the statistics of all sessions available to the calling
+     *  user in a single call
+     *
+     * @return A std::vector<SessionStatistics> with one element per session
+     */
+    std::vector<SessionStatistics> FetchStatistics()
+    {
+        GVariant *res = Call("FetchStatistics");
+        if (nullptr == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3SessionProxy",
+                                "Failed to retrieve session statistics");
+        }
+
+        GVariantIter *sessions = nullptr;
+        g_variant_get(res, "(a(ossxa{sx}))", &sessions);
+
+        std::vector<SessionStatistics> ret;
+        gchar *path = nullptr;
+        gchar *cfgname = nullptr;
+        gchar *devname = nullptr;
+        gint64 timestamp = 0;
+        GVariantIter *stats_ar = nullptr;
+        while (g_variant_iter_next(sessions, "(ossxa{sx})", &path, &cfgname,
+                                   &devname, &timestamp, &stats_ar))
+        {
+            SessionStatistics sess;
+            sess.session_path = std::string(path);
+            sess.config_name = std::string(cfgname);
+            sess.device_name = std::string(devname);
+            sess.timestamp = timestamp;
+
+            gchar *key = nullptr;
+            gint64 val = 0;
+            while (g_variant_iter_next(stats_ar, "{sx}", &key, &val))
+            {
+                sess.stats.push_back(ConnectionStatDetails(std::string(key), val));
+                g_free(key);
+            }
+            ret.push_back(sess);
+
+            g_variant_iter_free(stats_ar);
+            g_free(path);
+            g_free(cfgname);
+            g_free(devname);
+        }
+        g_variant_iter_free(sessions);
+        g_variant_unref(res);
+        return ret;
+    }
+
+
     /**
      *  Lookup all sessions which where started with the given configuration
      *  profile name.
@@ -577,6 +641,119 @@ public:
     }
 
 
+    /**
+     *  Retrieves the recent history of the traffic and error counters of
+     *  this session, together with the throughput rates
+     *
+     * @param max_samples  Maximum number of samples to retrieve.  The
+     *                     rates are always included.
+     *
+     * @return Returns a StatisticsHistoryReport
+     */
+    StatisticsHistoryReport FetchStatisticsHistory(const unsigned int max_samples)
+    {
+        GVariant *res = Call("FetchStatisticsHistory",
+                             g_variant_new("(u)", (guint32) max_samples));
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3SessionProxy",
+                                "FetchStatisticsHistory() call failed");
+        }
+        StatisticsHistoryReport ret(res);
+        g_variant_unref(res);
+        return ret;
+    }
+
+
+    /**
+     *  Retrieves when each phase of the session start began and ended,
+     *  as recorded by the session manager and the backend process
+     *
+     * @return Returns the StartupTimings of this session
+     */
+    StartupTimings GetStartupTimings()
+    {
+        GVariant *res = GetProperty("startup_timings");
+        StartupTimings ret(res);
+        g_variant_unref(res);
+        return ret;
+    }
+
+
+    /**
+     *  Maps the shared memory segment where the backend publishes the
+     *  statistics counters of this session.  The counters are updated
+     *  once a second and can be read as often as needed through the
+     *  returned object, without any further D-Bus calls.
+     *
+     * @return Returns a std::unique_ptr<StatisticsSegmentReader> of the
+     *         mapped segment
+     */
+    std::unique_ptr<StatisticsSegmentReader> OpenStatisticsSegment()
+    {
+        int fd = -1;
+        GVariant *res = CallGetFD("FetchStatisticsSegment", fd);
+        if (NULL == res || 0 > fd)
+        {
+            if (res)
+            {
+                g_variant_unref(res);
+            }
+            THROW_DBUSEXCEPTION("OpenVPN3SessionProxy",
+                                "FetchStatisticsSegment() call failed");
+        }
+        g_variant_unref(res);
+
+        try
+        {
+            std::unique_ptr<StatisticsSegmentReader> ret(new StatisticsSegmentReader(fd));
+            close(fd);
+            return ret;
+        }
+        catch (const StatisticsSegmentException& excp)
+        {
+            close(fd);
+            THROW_DBUSEXCEPTION("OpenVPN3SessionProxy", excp.what());
+        }
+    }
+
+
+    /**
+     *  Subscribe to periodic StatisticsUpdate signals from this session.
+     *  The signals are sent to the D-Bus connection used by this proxy
+     *  and can be decoded using StatisticsFrame and
+     *  StatisticsDeltaDecoder.
+     *
+     * @param interval  Requested update interval, in milliseconds
+     */
+    void StatisticsSubscribe(const unsigned int interval)
+    {
+        GVariant *res = Call("StatisticsSubscribe",
+                             g_variant_new("(u)", (guint32) interval));
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3SessionProxy",
+                                "StatisticsSubscribe() call failed");
+        }
+        g_variant_unref(res);
+    }
+
+
+    /**
+     *  Stop receiving StatisticsUpdate signals from this session
+     */
+    void StatisticsUnsubscribe()
+    {
+        GVariant *res = Call("StatisticsUnsubscribe");
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3SessionProxy",
+                                "StatisticsUnsubscribe() call failed");
+        }
+        g_variant_unref(res);
+    }
+
+
     /**
      *  Retrieve the owner UID of this session object
      *
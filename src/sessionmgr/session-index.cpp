@@ -0,0 +1,149 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   session-index.cpp
+ *
+ * @brief  Secondary lookup indexes of the session objects managed
+ *         by the session manager
+ */
+
+#include "session-index.hpp"
+
+
+void SessionIndex::Update(const std::string& path,
+                          const std::string& config_name,
+                          const std::string& device_name,
+                          const uid_t owner,
+                          const std::vector<uid_t>& acl,
+                          const bool public_access)
+{
+    Remove(path);
+
+    Record rec;
+    rec.config_name = config_name;
+    rec.device_name = device_name;
+    rec.owner = owner;
+    rec.acl.insert(acl.begin(), acl.end());
+    rec.public_access = public_access;
+
+    index_add(by_config_name, config_name, path);
+    if (!device_name.empty())
+    {
+        by_device[device_name] = path;
+    }
+    index_add(by_owner, owner, path);
+    for (const auto& uid : rec.acl)
+    {
+        index_add(by_grant, uid, path);
+    }
+    if (public_access)
+    {
+        public_paths.insert(path);
+    }
+    records[path] = std::move(rec);
+}
+
+
+void SessionIndex::Remove(const std::string& path)
+{
+    auto it = records.find(path);
+    if (records.end() == it)
+    {
+        return;
+    }
+
+    const Record& rec = it->second;
+    index_remove(by_config_name, rec.config_name, path);
+    auto dev = by_device.find(rec.device_name);
+    if (by_device.end() != dev && path == dev->second)
+    {
+        by_device.erase(dev);
+    }
+    index_remove(by_owner, rec.owner, path);
+    for (const auto& uid : rec.acl)
+    {
+        index_remove(by_grant, uid, path);
+    }
+    public_paths.erase(path);
+    records.erase(it);
+}
+
+
+bool SessionIndex::Exists(const std::string& path) const
+{
+    return records.end() != records.find(path);
+}
+
+
+bool SessionIndex::HasAccess(const std::string& path, const uid_t uid) const
+{
+    auto it = records.find(path);
+    if (records.end() == it)
+    {
+        return false;
+    }
+    const Record& rec = it->second;
+    return rec.public_access
+           || uid == rec.owner
+           || rec.acl.end() != rec.acl.find(uid);
+}
+
+
+SessionIndex::PathList SessionIndex::LookupConfigName(const std::string& name,
+                                                      const uid_t uid) const
+{
+    PathList ret;
+    auto it = by_config_name.find(name);
+    if (by_config_name.end() == it)
+    {
+        return ret;
+    }
+    for (const auto& path : it->second)
+    {
+        if (HasAccess(path, uid))
+        {
+            ret.insert(path);
+        }
+    }
+    return ret;
+}
+
+
+std::string SessionIndex::LookupDevice(const std::string& device) const
+{
+    auto it = by_device.find(device);
+    return (by_device.end() != it ? it->second : "");
+}
+
+
+std::string SessionIndex::GetDeviceName(const std::string& path) const
+{
+    auto it = records.find(path);
+    return (records.end() != it ? it->second.device_name : "");
+}
+
+
+SessionIndex::PathList SessionIndex::AccessibleBy(const uid_t uid) const
+{
+    PathList ret(public_paths);
+    index_merge(ret, by_owner, uid);
+    index_merge(ret, by_grant, uid);
+    return ret;
+}
@@ -0,0 +1,201 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   session-index.hpp
+ *
+ * @brief  Secondary lookup indexes of the session objects managed
+ *         by the session manager
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+
+/**
+ *  Keeps track of which session object paths use a specific configuration
+ *  name or tun device and which users have access to them.  This allows
+ *  the session manager to answer lookups and per-user listings without
+ *  scanning every session object, ACL checking each of them and querying
+ *  each VPN backend process for its device name.
+ *
+ *  The access rules mirrors DBusCredentials::CheckACL(): an object is
+ *  accessible by its owner, by users granted access and by everyone if
+ *  public access is enabled.
+ */
+class SessionIndex
+{
+public:
+    typedef std::set<std::string> PathList;
+
+    SessionIndex() = default;
+    ~SessionIndex() = default;
+
+    /**
+     *  Adds a session object to the index or refreshes the indexed
+     *  information if the object path is already indexed.  This must be
+     *  called each time the configuration name, device name, owner or
+     *  access control of the session changes.
+     *
+     * @param path           std::string with the D-Bus object path
+     * @param config_name    std::string with the configuration name
+     * @param device_name    std::string with the tun device name, empty
+     *                       if no device is in use
+     * @param owner          uid_t of the session owner
+     * @param acl            std::vector<uid_t> with UIDs granted access
+     * @param public_access  Is the session publicly accessible?
+     */
+    void Update(const std::string& path, const std::string& config_name,
+                const std::string& device_name, const uid_t owner,
+                const std::vector<uid_t>& acl, const bool public_access);
+
+    /**
+     *  Removes a session object from all the indexes.  Unknown paths are
+     *  silently ignored.
+     *
+     * @param path  std::string with the D-Bus object path to remove
+     */
+    void Remove(const std::string& path);
+
+    /**
+     * @param path  std::string with the D-Bus object path to look up
+     *
+     * @return  Returns true if the object path is indexed
+     */
+    bool Exists(const std::string& path) const;
+
+    /**
+     *  Checks if a user has access to a session object, according to the
+     *  indexed owner, ACL and public access information.
+     *
+     * @param path  std::string with the D-Bus object path to check
+     * @param uid   uid_t of the user to check
+     *
+     * @return  Returns true if the user has access, false if not or if the
+     *          object is not indexed.
+     */
+    bool HasAccess(const std::string& path, const uid_t uid) const;
+
+    /**
+     *  Retrieve all session paths using a specific configuration name
+     *  the given user has access to.
+     *
+     * @param name  std::string with the configuration name to look up
+     * @param uid   uid_t of the user doing the lookup
+     *
+     * @return  Returns a PathList of all matching object paths
+     */
+    PathList LookupConfigName(const std::string& name, const uid_t uid) const;
+
+    /**
+     *  Retrieve the session using a specific tun device
+     *
+     * @param device  std::string with the device name to look up
+     *
+     * @return  Returns a std::string with the session object path, empty
+     *          if no session uses this device
+     */
+    std::string LookupDevice(const std::string& device) const;
+
+    /**
+     * @param path  std::string with the D-Bus object path to look up
+     *
+     * @return  Returns a std::string with the indexed device name of a
+     *          session, empty if unknown or no device is in use
+     */
+    std::string GetDeviceName(const std::string& path) const;
+
+    /**
+     *  Retrieve all session paths a user has access to; either by being
+     *  the owner, being granted access or the session being public.
+     *
+     * @param uid   uid_t of the user
+     *
+     * @return  Returns a PathList of all accessible object paths
+     */
+    PathList AccessibleBy(const uid_t uid) const;
+
+    /**
+     * @return  Returns the number of indexed session objects
+     */
+    size_t size() const noexcept
+    {
+        return records.size();
+    }
+
+
+private:
+    struct Record
+    {
+        std::string config_name;
+        std::string device_name;
+        uid_t owner;
+        std::set<uid_t> acl;
+        bool public_access;
+    };
+
+    std::map<std::string, Record> records;
+    std::map<std::string, PathList> by_config_name;
+    std::map<std::string, std::string> by_device;
+    std::map<uid_t, PathList> by_owner;
+    std::map<uid_t, PathList> by_grant;
+    PathList public_paths;
+
+
+    template <typename K>
+    static void index_add(std::map<K, PathList>& idx, const K& key,
+                          const std::string& path)
+    {
+        idx[key].insert(path);
+    }
+
+
+    template <typename K>
+    static void index_remove(std::map<K, PathList>& idx, const K& key,
+                             const std::string& path)
+    {
+        auto it = idx.find(key);
+        if (idx.end() == it)
+        {
+            return;
+        }
+        it->second.erase(path);
+        if (it->second.empty())
+        {
+            idx.erase(it);
+        }
+    }
+
+
+    template <typename K>
+    static void index_merge(PathList& result,
+                            const std::map<K, PathList>& idx, const K& key)
+    {
+        auto it = idx.find(key);
+        if (idx.end() != it)
+        {
+            result.insert(it->second.begin(), it->second.end());
+        }
+    }
+};
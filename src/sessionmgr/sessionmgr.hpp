@@ -33,23 +33,33 @@
 #ifndef OPENVPN3_DBUS_SESSIONMGR_HPP
 #define OPENVPN3_DBUS_SESSIONMGR_HPP
 
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
 #include <cstring>
 #include <functional>
 #include <ctime>
+#include <map>
+#include <memory>
+#include <vector>
 
 #include <openvpn/common/likely.hpp>
 #include <openvpn/log/logsimple.hpp>
 
 #include "common/core-extensions.hpp"
 #include "common/lookup.hpp"
+#include "common/pidfd-watch.hpp"
 #include "common/requiresqueue.hpp"
+#include "common/startup-timings.hpp"
 #include "common/utils.hpp"
 #include "dbus/core.hpp"
 #include "dbus/connection-creds.hpp"
+#include "dbus/namewatch.hpp"
 #include "dbus/path.hpp"
 #include "log/dbus-log.hpp"
 #include "log/logwriter.hpp"
 #include "client/statusevent.hpp"
+#include "session-index.hpp"
 
 using namespace openvpn;
 
@@ -423,6 +433,11 @@ public:
      *  Constructor creating a new SessionObject
      *
      * @param dbuscon  D-Bus connection this object is tied to
+     * @param remove_callback  Called when this object is being removed
+     * @param update_callback  Called whenever the configuration name,
+     *                 device name or access control of the session changes
+     * @param timings_callback  Called with the startup timings of the
+     *                 session once it has connected the first time
      * @param owner    An uid reference of the owner of this object.  This is
      *                 typically the uid of the front-end user initating the
      *                 creation of a new tunnel session.
@@ -436,6 +451,8 @@ public:
      */
     SessionObject(GDBusConnection *dbuscon,
                   std::function<void()> remove_callback,
+                  std::function<void()> update_callback,
+                  std::function<void(const StartupTimings&)> timings_callback,
                   uid_t owner,
                   std::string objpath, std::string cfg_path,
                   unsigned int manager_log_level, LogWriter *logwr,
@@ -446,6 +463,8 @@ public:
           SessionManagerSignals(dbuscon, objpath, manager_log_level, logwr,
                                 signal_broadcast),
           remove_callback(remove_callback),
+          update_callback(update_callback),
+          timings_callback(timings_callback),
           be_proxy(nullptr),
           restrict_log_access(true),
           recv_log_events(false),
@@ -460,6 +479,8 @@ public:
           registered(false),
           selfdestruct_complete(false)
     {
+        startup_timings.Begin(StartupPhase::NEW_TUNNEL);
+
         // Only for the initialization of this object, use the manager's
         // log level.  Once the object is registered with a backend, it
         // will switch to the default session log level.
@@ -470,6 +491,9 @@ public:
         std::stringstream introspection_xml;
         introspection_xml << "<node name='" << objpath << "'>"
                           << "    <interface name='" << OpenVPN3DBus_interf_sessions << "'>"
+                          << "        <method name='SetCallBudget'>"
+                          << "            <arg type='u' name='budget_ms' direction='in'/>"
+                          << "        </method>"
                           << "        <method name='Connect'/>"
                           << "        <method name='Pause'>"
                           << "            <arg type='s' name='reason' direction='in'/>"
@@ -484,6 +508,21 @@ public:
                           << "        <method name='AccessRevoke'>"
                           << "            <arg direction='in' type='u' name='uid'/>"
                           << "        </method>"
+                          << "        <method name='StatisticsSubscribe'>"
+                          << "            <arg direction='in' type='u' name='interval'/>"
+                          << "        </method>"
+                          << "        <method name='StatisticsUnsubscribe'/>"
+                          << "        <method name='FetchStatisticsHistory'>"
+                          << "            <arg type='u' name='max_samples' direction='in'/>"
+                          << "            <arg type='as' name='keys' direction='out'/>"
+                          << "            <arg type='a(xax)' name='samples' direction='out'/>"
+                          << "            <arg type='a(sddd)' name='rates' direction='out'/>"
+                          << "        </method>"
+                          << "        <method name='FetchStatisticsSegment'/>"
+                          /* FetchStatisticsSegment returns the segment
+                           * from the backend as a unix_fd, passed as
+                           * auxiliary data
+                           */
                           << RequiresQueue::IntrospectionMethods("UserInputQueueGetTypeGroup",
                                                                  "UserInputQueueFetch",
                                                                  "UserInputQueueCheck",
@@ -493,6 +532,12 @@ public:
                           << "            <arg type='u' name='group' direction='out'/>"
                           << "            <arg type='s' name='message' direction='out'/>"
                           << "        </signal>"
+                          << "        <signal name='StatisticsUpdate'>"
+                          << "            <arg type='x' name='timestamp' direction='out'/>"
+                          << "            <arg type='u' name='sequence' direction='out'/>"
+                          << "            <arg type='as' name='keys' direction='out'/>"
+                          << "            <arg type='a(ux)' name='deltas' direction='out'/>"
+                          << "        </signal>"
                           << GetStatusChangeIntrospection()
                           << GetLogIntrospection()
                           << "        <property type='u' name='owner' access='read'/>"
@@ -508,6 +553,7 @@ public:
                           << "        <property type='s' name='config_name' access='read'/>"
                           << "        <property type='s' name='session_name' access='read'/>"
                           << "        <property type='u' name='backend_pid' access='read'/>"
+                          << "        <property type='a(sxx)' name='startup_timings' access='read'/>"
                           << "        <property type='b' name='restrict_log_access' access='readwrite'/>"
                           << "        <property type='b' name='receive_log_events' access='readwrite'/>"
                           << "        <property type='u' name='log_verbosity' access='readwrite'/>"
@@ -529,6 +575,8 @@ public:
                                                OpenVPN3DBus_name_backends,
                                                OpenVPN3DBus_interf_backends,
                                                OpenVPN3DBus_rootp_backends);
+                backend_start.SetGDBusCallTimeout(OpenVPN3DBus_timeout_backends);
+                startup_timings.Begin(StartupPhase::BACKEND_SPAWN);
                 backend_start.Ping(); // Wake up the backend service first
                 (void) backend_start.GetServiceVersion();
 
@@ -540,6 +588,8 @@ public:
                                             "StartClient request");
                 }
                 g_variant_get(res_g, "(u)", &backend_pid);
+                startup_timings.End(StartupPhase::BACKEND_SPAWN);
+                startup_timings.Begin(StartupPhase::BUS_REGISTRATION);
         }
         catch (DBusException& excp)
         {
@@ -548,11 +598,9 @@ public:
             return;
         }
 
-        // The PID value we get here is just a temporary.  This is the
-        // PID returned by openvpn3-service-backendstart.  This will again
-        // start the openvpn3-service-client process, which will fork() once
-        // to be completely independent.  When this last fork() happens,
-        // the backend will report back its final PID.
+        // This is the PID of the openvpn3-service-client process, which
+        // does not fork.  The backend reports the same PID again in its
+        // RegistrationRequest signal.
         StatusChange(StatusMajor::SESSION, StatusMinor::PROC_STARTED,
                              "session_path=" + DBusObject::GetObjectPath()
                              + ", backend_pid=" + std::to_string(backend_pid));
@@ -563,10 +611,44 @@ public:
         msg << "Session starting, configuration path: " << cfg_path
             << ", owner: " << lookup_username(owner);
         LogVerb1(msg.str());
+        startup_timings.End(StartupPhase::NEW_TUNNEL);
     }
 
     ~SessionObject()
     {
+        if (0 < registration_timer)
+        {
+            g_source_remove(registration_timer);
+        }
+        if (registration_cancel)
+        {
+            // registration_confirmed() will not touch this object
+            g_cancellable_cancel(registration_cancel);
+            g_object_unref(registration_cancel);
+        }
+        if (timings_cancel)
+        {
+            // startup_timings_received() will not touch this object
+            g_cancellable_cancel(timings_cancel);
+            g_object_unref(timings_cancel);
+        }
+        cancel_device_name_lookup();
+        if (0 < shutdown_timer)
+        {
+            g_source_remove(shutdown_timer);
+        }
+        if (be_watch)
+        {
+            delete be_watch;
+        }
+
+        // The session is gone, which is what a pending Disconnect call
+        // asked for
+        for (auto& inv : shutdown_invocs)
+        {
+            g_dbus_method_invocation_return_value(inv, NULL);
+        }
+
         if (sig_statuschg)
         {
             delete sig_statuschg;
@@ -601,27 +683,39 @@ public:
 
 
     /**
-     *  Retrieve the device name used by the this session.
+     *  Retrieve the device name used by the this session.  The device name
+     *  is retrieved from the backend process each time the connection is
+     *  established, which avoids querying the backend on each lookup.
      *
      * @return Returns std::string containing the device string.  If the
-     *         connection to the backend process is not established, an
-     *         empty string is returned.
+     *         connection is not established, an empty string is returned.
      */
-    std::string GetDeviceName() const
+    std::string GetDeviceName() const noexcept
     {
-        if (!be_proxy)
-        {
-            return "";
-        }
-        try
-        {
-            return be_proxy->GetStringProperty("device_name");
-        }
-        catch (const DBusException& excp)
+        return device_name;
+    }
+
+
+    /**
+     *  Retrieve the D-Bus details needed to query the backend process of
+     *  this session directly, without going through this object.
+     *
+     * @param busname  std::string receiving the backend bus name
+     * @param path     std::string receiving the backend object path
+     *
+     * @return Returns the GDBusConnection to use if the backend process is
+     *         registered and running, otherwise nullptr.
+     */
+    GDBusConnection * GetBackendTarget(std::string& busname,
+                                       std::string& path) const
+    {
+        if (!registered || !be_running || !be_proxy)
         {
-            // Ignore errors, just report an empty device name
-            return "";
+            return nullptr;
         }
+        busname = be_busname;
+        path = be_path;
+        return be_conn;
     }
 
 
@@ -685,26 +779,39 @@ public:
 
             try
             {
+                Unsubscribe("RegistrationRequest");
+                backend_pid = be_pid;
                 Subscribe(sender_name, be_path, "AttentionRequired");
                 Subscribe(sender_name, be_path, "StatusChange");
-                register_backend();
-                backend_pid = be_pid;
-                Unsubscribe("RegistrationRequest");
-                SetLogLevel(default_session_log_level);
-                LogVerb2("Backend VPN client process registered");
+                Subscribe(sender_name, be_path, "ProcessChange");
+                Subscribe(sender_name, be_path, "StatisticsUpdate");
+
+                // The registration continues in backend_appeared() once
+                // the backend owns its well-known bus name
+                watch_backend();
             }
             catch (DBusException& err)
             {
-                LogError("Could not register backend process, removing session object");
-                Debug(be_busname, be_path, backend_pid, std::string(err.what()));
-                StatusChange(StatusMajor::SESSION, StatusMinor::PROC_KILLED, "Backend process died");
-                selfdestruct(conn);
+                registration_failed(err.what());
             }
         }
         else if ((signal_name == "StatusChange")
                  && (interface_name == OpenVPN3DBus_interf_backends))
         {
             StatusEvent status(params);
+            update_device_name(status);
+
+            if (StatusMajor::CONNECTION == status.major
+                && StatusMinor::CONN_CONNECTED == status.minor
+                && !startup_reported)
+            {
+                // Only the first connection of a session is a startup
+                startup_reported = true;
+                if (timings_callback)
+                {
+                    report_startup_timings();
+                }
+            }
 
             if (StatusMajor::CONNECTION == status.major
                 && StatusMinor::CONN_FAILED == status.minor)
@@ -719,6 +826,36 @@ public:
                 shutdown(true, (StatusMinor::CONN_FAILED == status.minor));
             }
         }
+        else if ((signal_name == "ProcessChange")
+                 && (interface_name == OpenVPN3DBus_interf_backends))
+        {
+            guint status = 0;
+            gchar *procname = nullptr;
+            guint pid = 0;
+            g_variant_get(params, "(usu)", &status, &procname, &pid);
+            g_free(procname);
+
+            if (shutdown_pending
+                && StatusMinor::PROC_STOPPED == (StatusMinor) status)
+            {
+                shutdown_completed(shutdown_forced);
+            }
+        }
+        else if ((signal_name == "StatisticsUpdate")
+                 && (interface_name == OpenVPN3DBus_interf_backends))
+        {
+            // Only proxied to the front-ends which have subscribed
+            std::vector<std::string> targets;
+            for (const auto& sub : stats_subscribers)
+            {
+                targets.push_back(sub.first);
+            }
+            if (!targets.empty())
+            {
+                Send(targets, OpenVPN3DBus_interf_sessions,
+                     DBusObject::GetObjectPath(), "StatisticsUpdate", params);
+            }
+        }
         else if ((signal_name =="AttentionRequired")
                  && (interface_name == OpenVPN3DBus_interf_backends))
         {
@@ -758,6 +895,21 @@ public:
     {
         bool ping = false;
 
+        if ("SetCallBudget" == method_name)
+        {
+            // The budget applies to the next request from this caller
+            guint budget_ms = 0;
+            g_variant_get(params, "(u)", &budget_ms);
+            DBusCallBudgets::Set(sender, budget_ms);
+            g_dbus_method_invocation_return_value(invoc, NULL);
+            return;
+        }
+
+        // All calls to the backend needed to complete this request
+        // share the time budget of the front-end calling us
+        DBusCallDeadlineScope deadline(sender, OpenVPN3DBus_timeout_sessions
+                                                - OpenVPN3DBus_timeout_margin);
+
         try
         {
             if (!be_proxy)
@@ -820,7 +972,10 @@ public:
             {
                 CheckACL(sender, true);
                 LogVerb2("Disconnecting connection");
-                shutdown(false, true);
+
+                // The call is completed when the backend has stopped
+                shutdown(false, true, invoc);
+                return;
             }
             else if ("Ready" == method_name)
             {
@@ -900,6 +1055,7 @@ public:
                 uid_t uid = -1;
                 g_variant_get(params, "(u)", &uid);
                 GrantAccess(uid);
+                update_callback();
                 g_dbus_method_invocation_return_value(invoc, NULL);
 
                 LogInfo("Access granted to UID " + std::to_string(uid));
@@ -912,9 +1068,73 @@ public:
                 uid_t uid = -1;
                 g_variant_get(params, "(u)", &uid);
                 RevokeAccess(uid);
+                update_callback();
                 g_dbus_method_invocation_return_value(invoc, NULL);
 
                 LogInfo("Access revoked for UID " + std::to_string(uid));
+                stats_check_access();
+                return;
+            }
+            else if ("StatisticsSubscribe" == method_name)
+            {
+                CheckACL(sender);
+
+                guint32 interval = 0;
+                g_variant_get(params, "(u)", &interval);
+                stats_subscribe(sender, GetUID(sender), interval);
+                g_dbus_method_invocation_return_value(invoc, NULL);
+                return;
+            }
+            else if ("FetchStatisticsHistory" == method_name)
+            {
+                CheckACL(sender);
+                GVariant *res = be_proxy->Call("FetchStatisticsHistory", params);
+                g_dbus_method_invocation_return_value(invoc, res);
+                g_variant_unref(res);
+                return;
+            }
+            else if ("FetchStatisticsSegment" == method_name)
+            {
+                // The segment is mapped by the caller and read without
+                // involving either the session manager or the backend,
+                // so revoking the access later on does not stop a
+                // caller from reading it.
+                CheckACL(sender);
+                int fd = -1;
+                GVariant *res = be_proxy->CallGetFD("FetchStatisticsSegment", fd);
+                if (nullptr == res || 0 > fd)
+                {
+                    if (res)
+                    {
+                        g_variant_unref(res);
+                    }
+                    THROW_DBUSEXCEPTION("SessionObject",
+                                        "Backend did not return the statistics segment");
+                }
+                g_variant_unref(res);
+
+                GError *error = nullptr;
+                GUnixFDList *fdlist = g_unix_fd_list_new();
+                g_unix_fd_list_append(fdlist, fd, &error);
+                close(fd);
+                if (error)
+                {
+                    GLibUtils::unref_fdlist(fdlist);
+                    std::string err(error->message);
+                    g_error_free(error);
+                    THROW_DBUSEXCEPTION("SessionObject",
+                                        "Could not prepare the fd list: " + err);
+                }
+                g_dbus_method_invocation_return_value_with_unix_fd_list(invoc,
+                                                                        nullptr,
+                                                                        fdlist);
+                GLibUtils::unref_fdlist(fdlist);
+                return;
+            }
+            else if ("StatisticsUnsubscribe" == method_name)
+            {
+                stats_unsubscribe(sender);
+                g_dbus_method_invocation_return_value(invoc, NULL);
                 return;
             }
             else
@@ -977,7 +1197,11 @@ public:
             {
                 try
                 {
-                    shutdown(true, true); // Ensure the backend client process have stopped
+                    // Ensure the backend client process have stopped;
+                    // this session object is removed below.  The
+                    // PROC_KILLED status is sent when the shutdown
+                    // completes.
+                    shutdown(true, false);
                 }
                 catch (DBusException& dberr)
                 {
@@ -986,7 +1210,6 @@ public:
                 errmsg = "Backend VPN process have died.  Session is no longer valid.";
                 if (!selfdestruct_complete)
                 {
-                    StatusChange(StatusMajor::SESSION, StatusMinor::PROC_KILLED, "Backend process died");
                     do_selfdestruct = true;
                 }
             }
@@ -1048,6 +1271,8 @@ public:
                                      const std::string property_name,
                                      GError **error)
     {
+        DBusCallDeadlineScope deadline(sender, OpenVPN3DBus_timeout_sessions
+                                                - OpenVPN3DBus_timeout_margin);
         if (!registered)
         {
             g_set_error(error,
@@ -1056,6 +1281,7 @@ public:
                         "Session not active");
             return NULL;
         }
+
         if ("owner" == property_name)
         {
             return GetOwner();
@@ -1224,6 +1450,10 @@ public:
                 return g_variant_new_string("");
             }
         }
+        else if ("startup_timings" == property_name)
+        {
+            ret = get_startup_timings().GetGVariant();
+        }
         else if ("backend_pid" == property_name)
         {
             ret = g_variant_new_uint32 (backend_pid);
@@ -1276,6 +1506,8 @@ public:
                                             GVariant *value,
                                             GError **error)
     {
+        DBusCallDeadlineScope deadline(sender, OpenVPN3DBus_timeout_sessions
+                                                - OpenVPN3DBus_timeout_margin);
         /*
           std::cout << "[SessionObject] set_property(): "
                   << "sender=" << sender
@@ -1364,6 +1596,8 @@ public:
             {
                 bool acl_public = g_variant_get_boolean(value);
                 SetPublicAccess(acl_public);
+                update_callback();
+                stats_check_access();
                 LogInfo("Public access set to "
                          + (acl_public ? std::string("true") :
                                          std::string("false"))
@@ -1406,12 +1640,15 @@ public:
 private:
     unsigned int default_session_log_level = 4; // LogCategory::INFO messages
     std::function<void()> remove_callback;
+    std::function<void()> update_callback;
+    std::function<void(const StartupTimings&)> timings_callback;
     DBusProxy *be_proxy;
     bool restrict_log_access;
     bool recv_log_events;
     std::time_t session_created;
     std::string config_path;
     std::string config_name;
+    std::string device_name;
     SessionStatusChange *sig_statuschg;
     SessionLogEvent *sig_logevent;
     std::string backend_token;
@@ -1422,221 +1659,906 @@ private:
     bool registered;
     bool selfdestruct_complete;
     std::mutex selfdestruct_guard;
+    DBusNameWatch *be_watch = nullptr;
+    std::unique_ptr<PidfdWatch> be_process;
+    bool be_running = false;
+    guint registration_timer = 0;
+    GCancellable *registration_cancel = nullptr;
+    bool shutdown_pending = false;
+    bool shutdown_forced = false;
+    bool shutdown_selfdestruct = false;
+    guint shutdown_timer = 0;
+    std::vector<GDBusMethodInvocation *> shutdown_invocs;
+    StartupTimings startup_timings;
+    bool startup_reported = false;
+    GCancellable *timings_cancel = nullptr;
+    GCancellable *devname_cancel = nullptr;
+
+    struct StatsSubscriber
+    {
+        uid_t uid;
+        unsigned int interval;
+        std::unique_ptr<DBusNameWatch> watch;
+    };
+    std::map<std::string, StatsSubscriber> stats_subscribers;
+    unsigned int stats_interval = 0;
 
 
     /**
-     *  Ties the VPN client backend process to this SessionObject.  Once that
-     *  is done, it calls the RegistrationConfirmation method in the backend
-     *  process where it confirms the backend token and provides the
-     *  VPN configuration D-Bus object path to the backend.
+     *  Adds or updates a StatisticsUpdate subscription.  The subscription
+     *  is removed automatically when the subscriber disconnects from
+     *  the bus.
+     *
+     * @param busname   std::string with the unique bus name of the subscriber
+     * @param uid       uid_t of the subscriber
+     * @param interval  Requested update interval, in milliseconds
      */
-    void register_backend()
+    void stats_subscribe(const std::string& busname, const uid_t uid,
+                         unsigned int interval)
     {
-        try
+        if (OpenVPN3DBus_statistics_interval_min > interval)
         {
-            be_proxy = new DBusProxy(G_BUS_TYPE_SYSTEM,
-                                     be_busname,
-                                     OpenVPN3DBus_interf_backends,
-                                     be_path);
-            // Don't try to auto start backend services over D-Bus,
-            // The backend service should exists _before_ we try to
-            // communicate with it.
-            be_proxy->SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
+            interval = OpenVPN3DBus_statistics_interval_min;
+        }
 
-            unsigned int attempts = 5;
-            while (attempts > 0)
-            {
-                try
-                {
-                    ping_backend();
-                    attempts = 0;
-                }
-                catch (const DBusException& excp)
-                {
-                    --attempts;
-                    if (attempts > 0)
-                    {
-                        // If we didn't manage to get a Ping response
-                        // it might be the backend client process is a bit
-                        // slow to settle.  So we just wait for another
-                        // second and try again
-                        sleep(1);
-                    }
-                    else
-                    {
-                        // This didn't work, so bail out.
-                        throw;
-                    }
-                }
-            }
+        StatsSubscriber& sub = stats_subscribers[busname];
+        sub.uid = uid;
+        sub.interval = interval;
+        if (!sub.watch)
+        {
+            sub.watch.reset(new DBusNameWatch(DBusSignalSubscription::GetConnection(),
+                                              busname, nullptr,
+                                              [this, busname]()
+                                              {
+                                                  stats_unsubscribe(busname);
+                                              }));
+        }
 
-            // Setup signal listeners from the backend process
-            // The SessionStatusChange() handler will use the senders
-            // unique bus name to identify if this is a signal this class
-            // responsible for.
-            //
-            // As the be_busname contains the well-known bus name of the
-            // backend VPN client process, we resolve this to the unique
-            // bus name for this signal handling object.
-            sig_statuschg = new SessionStatusChange(be_conn,
-                                                    GetUniqueBusID(be_busname),
-                                                    OpenVPN3DBus_interf_backends,
-                                                    DBusObject::GetObjectPath());
-
-            GVariant *res_g = be_proxy->Call("RegistrationConfirmation",
-                                             g_variant_new("(so)",
-                                                           backend_token.c_str(),
-                                                           config_path.c_str()));
-            if (nullptr == res_g)
-            {
-                THROW_DBUSEXCEPTION("SessionObject",
-                                    "Failed to extract the result of the "
-                                    "RegistrationConfirmation response");
-            }
+        // Always tell the backend, so the new subscriber gets a key frame
+        update_stats_interval(true);
+    }
 
-            gchar *cfgname_c = nullptr;
-            g_variant_get(res_g, "(s)", &cfgname_c);
-            if (!cfgname_c)
+
+    /**
+     *  Removes a StatisticsUpdate subscription
+     *
+     * @param busname  std::string with the unique bus name of the subscriber
+     */
+    void stats_unsubscribe(const std::string& busname)
+    {
+        if (0 < stats_subscribers.erase(busname))
+        {
+            update_stats_interval(false);
+        }
+    }
+
+
+    /**
+     *  Removes the StatisticsUpdate subscriptions of users who no longer
+     *  have access to this session
+     */
+    void stats_check_access()
+    {
+        bool changed = false;
+        std::vector<uid_t> acl = GetAccessList();
+        for (auto it = stats_subscribers.begin(); it != stats_subscribers.end();)
+        {
+            uid_t uid = it->second.uid;
+            if (GetPublicAccess() || GetOwnerUID() == uid
+                || acl.end() != std::find(acl.begin(), acl.end(), uid))
             {
-                // FIXME: Find a way to gracefully handle failed registration
-                return;
+                ++it;
+                continue;
             }
-            config_name = std::string(cfgname_c);
-            Debug("New session registered: " + DBusObject::GetObjectPath());
-            StatusChange(StatusMajor::SESSION, StatusMinor::SESS_NEW,
-                         "session_path=" + DBusObject::GetObjectPath()
-                         + " backend_busname=" + be_busname
-                         + " backend_path=" + be_path);
-            registered = true;
+            it = stats_subscribers.erase(it);
+            changed = true;
         }
-        catch (DBusException& err)
+        if (changed)
         {
-            THROW_DBUSEXCEPTION("SessionObject", err.what());
+            update_stats_interval(false);
         }
     }
 
 
     /**
-     * Simple ping-pong game between this SessionObject and its VPN client
-     * backend.  If the backend does not respond, we treat it as dead and will
-     * start to clean-up this session.
+     *  Tells the backend process at which interval to send the
+     *  StatisticsUpdate signal.  This is the shortest interval requested
+     *  by the subscribers, or 0 to stop sending them.
      *
-     * @return  Returns True if the backend process is alive, otherwise False.
+     * @param force  Tell the backend even if the interval did not change
      */
-    bool ping_backend()
+    void update_stats_interval(const bool force)
     {
-        if (nullptr == be_proxy)
+        unsigned int interval = 0;
+        for (const auto& sub : stats_subscribers)
         {
-            THROW_DBUSEXCEPTION("SessionObject",
-                                "No backend proxy connection established, "
-                                "cannot ping backend");
+            if (0 == interval || sub.second.interval < interval)
+            {
+                interval = sub.second.interval;
+            }
+        }
+        if (!force && interval == stats_interval)
+        {
+            return;
         }
+        stats_interval = interval;
 
-        GVariant *res_g = NULL;
-        try {
-            // This Ping() is the BackendClientObject responding,
-            // which ensures the VPN client process is initialized
-            res_g = be_proxy->Call("Ping");
+        if (!be_proxy || !registered)
+        {
+            // Sent when the registration completes
+            return;
         }
-        catch (DBusException &dbserr)
+        try
         {
-            res_g = NULL;
-            Debug(be_busname, be_path, backend_pid, std::string(dbserr.what()));
+            be_proxy->Call("SetStatisticsInterval",
+                           g_variant_new("(u)", (guint32) interval), true);
         }
-        if (NULL == res_g)
+        catch (const DBusException& excp)
         {
-            THROW_DBUSEXCEPTION("SessionObject",
-                                "VPN backend process unavailable, "
-                                "does not respond to internal Ping()");
+            LogWarn("Could not change the statistics update interval: "
+                    + std::string(excp.what()));
         }
+    }
 
-        bool ret = false;
-        g_variant_get(res_g, "(b)", &ret);
-        g_variant_unref(res_g);
+
+    /**
+     *  Collects the startup timings recorded by this object and by the
+     *  backend process.  If the backend cannot be reached, only the
+     *  phases recorded by the session manager are returned.
+     *
+     * @return Returns the combined StartupTimings of this session
+     */
+    StartupTimings get_startup_timings()
+    {
+        StartupTimings ret(startup_timings);
+        if (be_proxy && be_running)
+        {
+            try
+            {
+                GVariant *be_timings = be_proxy->GetProperty("startup_timings");
+                ret.Merge(StartupTimings(be_timings));
+                g_variant_unref(be_timings);
+            }
+            catch (const DBusException& excp)
+            {
+                Debug("Could not retrieve the backend startup timings: "
+                      + std::string(excp.what()));
+            }
+        }
         return ret;
     }
 
 
     /**
-     * Fetches the last backend status and compares to what we have
-     * registered.  If there is a mismatch, we might have missed a signal -
-     * so register it and send it again.
+     *  Passes the startup timings of this session to the timings callback.
+     *  The backend timings are retrieved asynchronously, as this is called
+     *  from a signal handler on the main loop which must not wait for the
+     *  backend process.  If the backend cannot be reached, only the
+     *  phases recorded by the session manager are reported.
      */
-    void update_last_status()
+    void report_startup_timings()
     {
-        if (!sig_statuschg)
+        if (!be_conn || !be_running)
         {
+            timings_callback(startup_timings);
             return;
         }
 
-        try
+        timings_cancel = g_cancellable_new();
+        g_dbus_connection_call(be_conn,
+                               be_busname.c_str(),
+                               be_path.c_str(),
+                               "org.freedesktop.DBus.Properties",
+                               "Get",
+                               g_variant_new("(ss)",
+                                             OpenVPN3DBus_interf_backends.c_str(),
+                                             "startup_timings"),
+                               G_VARIANT_TYPE("(v)"),
+                               G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                               OpenVPN3DBus_timeout_backends,
+                               timings_cancel,
+                               startup_timings_received,
+                               this);
+    }
+
+
+    /**
+     *  GDBus callback for the backend startup_timings property.  The call
+     *  is cancelled if this object is removed before the response arrives,
+     *  in which case user_data must not be used.
+     */
+    static void startup_timings_received(GObject *source, GAsyncResult *res,
+                                         gpointer user_data)
+    {
+        GError *error = nullptr;
+        GVariant *reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+                                                        res, &error);
+        if (error && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
         {
-            GVariant *be_status = nullptr;
-            be_status = be_proxy->GetProperty("status");
-            if (!sig_statuschg->CompareStatus(be_status))
+            g_error_free(error);
+            return;
+        }
+
+        SessionObject *self = static_cast<SessionObject *>(user_data);
+        g_object_unref(self->timings_cancel);
+        self->timings_cancel = nullptr;
+
+        StartupTimings timings(self->startup_timings);
+        if (reply)
+        {
+            GVariant *be_timings = nullptr;
+            g_variant_get(reply, "(v)", &be_timings);
+            if (g_variant_is_of_type(be_timings, G_VARIANT_TYPE("a(sxx)")))
             {
-                sig_statuschg->ProxyStatus(be_status);
+                timings.Merge(StartupTimings(be_timings));
             }
+            g_variant_unref(be_timings);
+            g_variant_unref(reply);
         }
-        catch (DBusException& excp)
+        else
         {
-            // Ignore these failures for now.  It most commonly means
-            // the backend process has closed/shut-down - this is scenario
-            // is handled elsewhere in the call chain.
-
-            // TODO: Consider to set the local status to PROC_KILLED or
-            // something similar.
+            g_dbus_error_strip_remote_error(error);
+            self->Debug("Could not retrieve the backend startup timings: "
+                        + std::string(error->message));
+            g_error_free(error);
         }
+        self->timings_callback(timings);
     }
 
 
     /**
-     *  Initiate a shutdown of the VPN client backend process.
+     *  Starts watching the well-known bus name of the backend which sent
+     *  the RegistrationRequest.  The backend may send this signal before
+     *  it owns the bus name, so the registration is completed when the
+     *  bus name appears.  If that does not happen within
+     *  OpenVPN3DBus_timeout_backends, the registration fails.
+     */
+    void watch_backend()
+    {
+        be_watch = new DBusNameWatch(be_conn, be_busname,
+                                     [this](const std::string& owner)
+                                     {
+                                         backend_appeared(owner);
+                                     },
+                                     [this]()
+                                     {
+                                         backend_vanished();
+                                     });
+        registration_timer = g_timeout_add(OpenVPN3DBus_timeout_backends,
+                                           registration_timeout, this);
+    }
+
+
+    /**
+     *  GLib timer callback, called when the backend bus name did not
+     *  appear in time
+     */
+    static gboolean registration_timeout(gpointer user_data)
+    {
+        SessionObject *self = static_cast<SessionObject *>(user_data);
+        self->registration_timer = 0;
+        self->registration_failed("Backend process did not appear on the bus");
+        return G_SOURCE_REMOVE;
+    }
+
+
+    /**
+     *  Called when the well-known bus name of the backend gets an owner
      *
-     * @param forced             If set to True, it will not do a normal
-     *                           disconnect but tell the backend process
-     *                           to stop more abruptly.
-     * @param selfdestruct_flag  If set to True, this D-Bus session object
-     *                           will be destroyed.  If not, it needs to
-     *                           be removed later on independently.  Used to
-     *                           allow front-ends to retrieve the last sent
-     *                           status message, which can be AUTH_FAILED.
+     * @param owner  std::string with the unique bus name of the backend
      */
-    void shutdown(bool forced, bool selfdestruct_flag)
+    void backend_appeared(const std::string& owner)
     {
-        try
-        {
-            be_proxy->Call( (!forced ? "Disconnect" : "ForceShutdown"), true );
-            // Wait for child to exit
-            sleep(2); // FIXME: Catch the ProcessChange StatusMinor::PROC_STOPPED signal from backend
-        }
-        catch (DBusException& excp)
+        be_running = true;
+        startup_timings.End(StartupPhase::BUS_REGISTRATION);
+        if (registered || be_proxy)
         {
-            Debug(excp.what());
-            // FIXME: For now, we just ignore any errors here - the
-            // backend process may not be running
+            // Registration already done or in progress
+            return;
         }
 
-        // Remove this session object
-        if (!forced)
+        if (0 < registration_timer)
         {
-            StatusChange(StatusMajor::SESSION, StatusMinor::PROC_STOPPED, "Session closed");
+            g_source_remove(registration_timer);
+            registration_timer = 0;
         }
-        else
+
+        try
         {
-            StatusChange(StatusMajor::SESSION, StatusMinor::PROC_KILLED, "Session closed, killed backend client");
+            register_backend(owner);
         }
-
-        if (selfdestruct_flag)
+        catch (DBusException& err)
         {
-            selfdestruct(DBusSignalSubscription::GetConnection());
+            registration_failed(err.what());
         }
     }
 
 
     /**
-     *  This method is dangerous and should only be used by either the
-     *  SessionObject::shutdown() method or exception handlers in the
+     *  Ties the VPN client backend process to this SessionObject.  Once that
+     *  is done, it calls the RegistrationConfirmation method in the backend
+     *  process where it confirms the backend token and provides the
+     *  VPN configuration D-Bus object path to the backend.
+     *
+     *  The RegistrationConfirmation call is done asynchronously, as the
+     *  backend retrieves the configuration profile before responding.
+     *  The registration is completed by registration_completed().
+     *
+     * @param owner  std::string with the unique bus name of the backend
+     */
+    void register_backend(const std::string& owner)
+    {
+        // The backend process is not a child of the session manager,
+        // so its exit is tracked through a pidfd on the PID owning the
+        // bus name
+        pid_t pid = GetPID(owner);
+        be_process.reset(new PidfdWatch(pid,
+                                        [this]()
+                                        {
+                                            backend_exited();
+                                        }));
+
+        // The backend may have exited and its PID been reused before the
+        // pidfd was opened.  The bus drops the connection of a process
+        // when it exits, so if the same PID still owns the connection,
+        // the pidfd refers to the backend.  The bus notices the exit
+        // asynchronously, which leaves a narrow window where a PID
+        // reused right after the exit is not detected here.
+        bool same_process = false;
+        try
+        {
+            same_process = (pid == GetPID(owner));
+        }
+        catch (const DBusException&)
+        {
+            // The connection is gone
+        }
+        if (!same_process)
+        {
+            be_process.reset();
+            THROW_DBUSEXCEPTION("SessionObject",
+                                "Backend process exited during registration");
+        }
+
+        be_proxy = new DBusProxy(G_BUS_TYPE_SYSTEM,
+                                 be_busname,
+                                 OpenVPN3DBus_interf_backends,
+                                 be_path);
+        // Don't try to auto start backend services over D-Bus,
+        // The backend service should exists _before_ we try to
+        // communicate with it.
+        be_proxy->SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
+        be_proxy->SetGDBusCallTimeout(OpenVPN3DBus_timeout_backends);
+        be_proxy->EnableCallBudgetPropagation();
+
+        // Setup signal listeners from the backend process
+        // The SessionStatusChange() handler will use the senders
+        // unique bus name to identify if this is a signal this class
+        // responsible for.
+        sig_statuschg = new SessionStatusChange(be_conn,
+                                                owner,
+                                                OpenVPN3DBus_interf_backends,
+                                                DBusObject::GetObjectPath());
+
+        registration_cancel = g_cancellable_new();
+        startup_timings.Begin(StartupPhase::REGISTRATION_CONFIRMATION);
+        g_dbus_connection_call(be_conn,
+                               be_busname.c_str(),
+                               be_path.c_str(),
+                               OpenVPN3DBus_interf_backends.c_str(),
+                               "RegistrationConfirmation",
+                               g_variant_new("(so)",
+                                             backend_token.c_str(),
+                                             config_path.c_str()),
+                               G_VARIANT_TYPE("(s)"),
+                               G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                               OpenVPN3DBus_timeout_backends,
+                               registration_cancel,
+                               registration_confirmed,
+                               this);
+    }
+
+
+    /**
+     *  GDBus callback for the RegistrationConfirmation response.  The
+     *  call is cancelled if this object is removed before the response
+     *  arrives, in which case user_data must not be used.
+     */
+    static void registration_confirmed(GObject *source, GAsyncResult *res,
+                                       gpointer user_data)
+    {
+        GError *error = nullptr;
+        GVariant *ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+                                                      res, &error);
+        if (error && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            g_error_free(error);
+            return;
+        }
+
+        SessionObject *self = static_cast<SessionObject *>(user_data);
+        std::string errmsg;
+        if (error)
+        {
+            g_dbus_error_strip_remote_error(error);
+            errmsg = std::string(error->message);
+            g_error_free(error);
+        }
+        self->registration_completed(ret, errmsg);
+        if (ret)
+        {
+            g_variant_unref(ret);
+        }
+    }
+
+
+    /**
+     *  Completes the backend registration when the RegistrationConfirmation
+     *  response has arrived
+     *
+     * @param res     GVariant with the response, nullptr on errors
+     * @param errmsg  std::string with the error message on errors
+     */
+    void registration_completed(GVariant *res, const std::string& errmsg)
+    {
+        g_object_unref(registration_cancel);
+        registration_cancel = nullptr;
+        startup_timings.End(StartupPhase::REGISTRATION_CONFIRMATION);
+
+        if (nullptr == res)
+        {
+            registration_failed("RegistrationConfirmation failed: " + errmsg);
+            return;
+        }
+
+        gchar *cfgname_c = nullptr;
+        g_variant_get(res, "(s)", &cfgname_c);
+        if (!cfgname_c)
+        {
+            // FIXME: Find a way to gracefully handle failed registration
+            return;
+        }
+        config_name = std::string(cfgname_c);
+        g_free(cfgname_c);
+        update_callback();
+        Debug("New session registered: " + DBusObject::GetObjectPath());
+        StatusChange(StatusMajor::SESSION, StatusMinor::SESS_NEW,
+                     "session_path=" + DBusObject::GetObjectPath()
+                     + " backend_busname=" + be_busname
+                     + " backend_path=" + be_path);
+        registered = true;
+        if (!stats_subscribers.empty())
+        {
+            update_stats_interval(true);
+        }
+        SetLogLevel(default_session_log_level);
+        LogVerb2("Backend VPN client process registered");
+    }
+
+
+    /**
+     *  Keeps the cached device name in sync with the connection state
+     *  reported by the backend process.  The device name is retrieved
+     *  asynchronously when the connection is established, as this is
+     *  called from a signal handler on the main loop which must not wait
+     *  for the backend process.  It is cleared when the connection is
+     *  torn down.
+     *
+     * @param status  StatusEvent reported by the backend process
+     */
+    void update_device_name(const StatusEvent& status)
+    {
+        if (StatusMajor::CONNECTION != status.major || !be_proxy)
+        {
+            return;
+        }
+
+        switch (status.minor)
+        {
+        case StatusMinor::CONN_CONNECTED:
+            cancel_device_name_lookup();
+            devname_cancel = g_cancellable_new();
+            g_dbus_connection_call(be_conn,
+                                   be_busname.c_str(),
+                                   be_path.c_str(),
+                                   "org.freedesktop.DBus.Properties",
+                                   "Get",
+                                   g_variant_new("(ss)",
+                                                 OpenVPN3DBus_interf_backends.c_str(),
+                                                 "device_name"),
+                                   G_VARIANT_TYPE("(v)"),
+                                   G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                                   OpenVPN3DBus_timeout_backends,
+                                   devname_cancel,
+                                   device_name_received,
+                                   this);
+            break;
+
+        case StatusMinor::CONN_DISCONNECTING:
+        case StatusMinor::CONN_DISCONNECTED:
+        case StatusMinor::CONN_DONE:
+        case StatusMinor::CONN_FAILED:
+        case StatusMinor::CONN_AUTH_FAILED:
+        case StatusMinor::CONN_PAUSED:
+            cancel_device_name_lookup();
+            set_device_name("");
+            break;
+
+        default:
+            break;
+        }
+    }
+
+
+    /**
+     *  Cancels a pending device name lookup started by
+     *  update_device_name()
+     */
+    void cancel_device_name_lookup()
+    {
+        if (devname_cancel)
+        {
+            // device_name_received() will not touch this object
+            g_cancellable_cancel(devname_cancel);
+            g_object_unref(devname_cancel);
+            devname_cancel = nullptr;
+        }
+    }
+
+
+    /**
+     *  GDBus callback for the backend device_name property.  The call is
+     *  cancelled if the connection state changes or this object is
+     *  removed before the response arrives, in which case user_data must
+     *  not be used.
+     */
+    static void device_name_received(GObject *source, GAsyncResult *res,
+                                     gpointer user_data)
+    {
+        GError *error = nullptr;
+        GVariant *reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+                                                        res, &error);
+        if (error && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            g_error_free(error);
+            return;
+        }
+
+        SessionObject *self = static_cast<SessionObject *>(user_data);
+        g_object_unref(self->devname_cancel);
+        self->devname_cancel = nullptr;
+
+        std::string devname;
+        if (reply)
+        {
+            GVariant *value = nullptr;
+            g_variant_get(reply, "(v)", &value);
+            if (g_variant_is_of_type(value, G_VARIANT_TYPE_STRING))
+            {
+                devname = std::string(g_variant_get_string(value, nullptr));
+            }
+            g_variant_unref(value);
+            g_variant_unref(reply);
+        }
+        else
+        {
+            // Ignore errors, just report an empty device name
+            g_error_free(error);
+        }
+        self->set_device_name(devname);
+    }
+
+
+    /**
+     *  Updates the cached device name, refreshing the session index
+     *  if it changed
+     *
+     * @param devname  std::string with the new device name
+     */
+    void set_device_name(const std::string& devname)
+    {
+        if (devname != device_name)
+        {
+            device_name = devname;
+            update_callback();
+        }
+    }
+
+
+    /**
+     *  Removes this session object when the backend process could not
+     *  be registered
+     *
+     * @param reason  std::string with the reason, for the debug log
+     */
+    void registration_failed(const std::string& reason)
+    {
+        LogError("Could not register backend process, removing session object");
+        Debug(be_busname, be_path, backend_pid, reason);
+        StatusChange(StatusMajor::SESSION, StatusMinor::PROC_KILLED, "Backend process died");
+        selfdestruct(DBusSignalSubscription::GetConnection());
+    }
+
+
+    /**
+     * Simple ping-pong game between this SessionObject and its VPN client
+     * backend.  If the backend does not respond, we treat it as dead and will
+     * start to clean-up this session.
+     *
+     * @return  Returns True if the backend process is alive, otherwise False.
+     */
+    bool ping_backend()
+    {
+        if (nullptr == be_proxy)
+        {
+            THROW_DBUSEXCEPTION("SessionObject",
+                                "No backend proxy connection established, "
+                                "cannot ping backend");
+        }
+
+        GVariant *res_g = NULL;
+        try {
+            // This Ping() is the BackendClientObject responding,
+            // which ensures the VPN client process is initialized
+            res_g = be_proxy->Call("Ping");
+        }
+        catch (DBusException &dbserr)
+        {
+            res_g = NULL;
+            Debug(be_busname, be_path, backend_pid, std::string(dbserr.what()));
+        }
+        if (NULL == res_g)
+        {
+            THROW_DBUSEXCEPTION("SessionObject",
+                                "VPN backend process unavailable, "
+                                "does not respond to internal Ping()");
+        }
+
+        bool ret = false;
+        g_variant_get(res_g, "(b)", &ret);
+        g_variant_unref(res_g);
+        return ret;
+    }
+
+
+    /**
+     * Fetches the last backend status and compares to what we have
+     * registered.  If there is a mismatch, we might have missed a signal -
+     * so register it and send it again.
+     */
+    void update_last_status()
+    {
+        if (!sig_statuschg)
+        {
+            return;
+        }
+
+        try
+        {
+            GVariant *be_status = nullptr;
+            be_status = be_proxy->GetProperty("status");
+            if (!sig_statuschg->CompareStatus(be_status))
+            {
+                sig_statuschg->ProxyStatus(be_status);
+            }
+        }
+        catch (DBusException& excp)
+        {
+            // Ignore these failures for now.  It most commonly means
+            // the backend process has closed/shut-down - this is scenario
+            // is handled elsewhere in the call chain.
+
+            // TODO: Consider to set the local status to PROC_KILLED or
+            // something similar.
+        }
+    }
+
+
+    /**
+     *  Initiate a shutdown of the VPN client backend process.
+     *
+     *  This does not wait for the backend process.  The shutdown is
+     *  completed by shutdown_completed() when the backend reports
+     *  PROC_STOPPED or its bus name vanishes, whichever comes first.  If
+     *  that does not happen within OpenVPN3DBus_timeout_backend_stop, a
+     *  Disconnect is escalated to ForceShutdown, and a ForceShutdown to
+     *  killing the process.
+     *
+     * @param forced             If set to True, it will not do a normal
+     *                           disconnect but tell the backend process
+     *                           to stop more abruptly.
+     * @param selfdestruct_flag  If set to True, this D-Bus session object
+     *                           will be destroyed.  If not, it needs to
+     *                           be removed later on independently.  Used to
+     *                           allow front-ends to retrieve the last sent
+     *                           status message, which can be AUTH_FAILED.
+     * @param invoc              GDBusMethodInvocation to complete when the
+     *                           shutdown has completed, may be nullptr
+     */
+    void shutdown(bool forced, bool selfdestruct_flag,
+                  GDBusMethodInvocation *invoc = nullptr)
+    {
+        if (invoc)
+        {
+            shutdown_invocs.push_back(invoc);
+        }
+        shutdown_selfdestruct |= selfdestruct_flag;
+        if (shutdown_pending)
+        {
+            // Already waiting for the backend to stop
+            return;
+        }
+        shutdown_pending = true;
+
+        if (!be_proxy || !be_running)
+        {
+            // No backend registered or it has already stopped,
+            // nothing to wait for
+            shutdown_completed(forced);
+            return;
+        }
+
+        if (!request_backend_stop(forced))
+        {
+            shutdown_completed(forced);
+        }
+    }
+
+
+    /**
+     *  Sends the Disconnect or ForceShutdown request to the backend and
+     *  arms the timer escalating the shutdown if the backend does not
+     *  stop in time.
+     *
+     * @param forced  Send ForceShutdown instead of Disconnect
+     *
+     * @return  Returns false if the request could not be sent
+     */
+    bool request_backend_stop(bool forced)
+    {
+        shutdown_forced = forced;
+        try
+        {
+            be_proxy->Call((!forced ? "Disconnect" : "ForceShutdown"), true);
+        }
+        catch (DBusException& excp)
+        {
+            // The backend process is most likely not running any more
+            Debug(excp.what());
+            return false;
+        }
+        shutdown_timer = g_timeout_add(OpenVPN3DBus_timeout_backend_stop,
+                                       shutdown_timeout, this);
+        return true;
+    }
+
+
+    /**
+     *  GLib timer callback, called when the backend did not stop in time
+     */
+    static gboolean shutdown_timeout(gpointer user_data)
+    {
+        SessionObject *self = static_cast<SessionObject *>(user_data);
+        self->shutdown_timer = 0;
+
+        if (!self->shutdown_forced)
+        {
+            self->LogWarn("Backend process did not stop, forcing shutdown");
+            if (self->request_backend_stop(true))
+            {
+                return G_SOURCE_REMOVE;
+            }
+        }
+        else
+        {
+            self->LogError("Backend process did not stop, killing pid "
+                           + std::to_string(self->backend_pid));
+            // The pidfd ensures the signal cannot reach another
+            // process which has reused the PID
+            bool sent = (self->be_process
+                         ? self->be_process->Kill(SIGKILL)
+                         : (0 < self->backend_pid
+                            && 0 == kill(self->backend_pid, SIGKILL)));
+            if (!sent)
+            {
+                self->Debug("Could not kill backend pid "
+                            + std::to_string(self->backend_pid) + ": "
+                            + std::string(strerror(errno)));
+            }
+        }
+        self->shutdown_completed(true);
+        return G_SOURCE_REMOVE;
+    }
+
+
+    /**
+     *  Called when the bus name of the backend has no owner any more
+     */
+    void backend_vanished()
+    {
+        be_running = false;
+        if (shutdown_pending)
+        {
+            shutdown_completed(shutdown_forced);
+        }
+    }
+
+
+    /**
+     *  Called when the backend process has exited.  This is usually
+     *  noticed before its bus name vanishes.
+     */
+    void backend_exited()
+    {
+        be_running = false;
+        if (shutdown_pending)
+        {
+            shutdown_completed(shutdown_forced);
+        }
+        else if (!registered)
+        {
+            registration_failed("Backend process exited");
+        }
+        else
+        {
+            LogError("Backend process, pid " + std::to_string(backend_pid)
+                     + ", exited unexpectedly");
+            shutdown(true, true);
+        }
+    }
+
+
+    /**
+     *  Completes a shutdown started by shutdown().  Any method calls
+     *  waiting for the shutdown are completed, and this object is
+     *  removed if requested.
+     *
+     * @param killed  True if the backend had to be stopped forcefully
+     */
+    void shutdown_completed(bool killed)
+    {
+        if (!shutdown_pending)
+        {
+            return;
+        }
+        if (0 < shutdown_timer)
+        {
+            g_source_remove(shutdown_timer);
+            shutdown_timer = 0;
+        }
+        if (be_watch)
+        {
+            delete be_watch;
+            be_watch = nullptr;
+        }
+        be_process.reset();
+
+        if (!killed)
+        {
+            StatusChange(StatusMajor::SESSION, StatusMinor::PROC_STOPPED, "Session closed");
+        }
+        else
+        {
+            StatusChange(StatusMajor::SESSION, StatusMinor::PROC_KILLED, "Session closed, killed backend client");
+        }
+
+        for (auto& inv : shutdown_invocs)
+        {
+            g_dbus_method_invocation_return_value(inv, NULL);
+        }
+        shutdown_invocs.clear();
+        shutdown_pending = false;
+
+        if (shutdown_selfdestruct)
+        {
+            selfdestruct(DBusSignalSubscription::GetConnection());
+        }
+    }
+
+
+    /**
+     *  This method is dangerous and should only be used by either the
+     *  SessionObject::shutdown() method or exception handlers in the
      *  SessionObject.
      *
      *  This will initiate deleting this SessionObject from the D-Bus and then
@@ -1671,6 +2593,207 @@ private:
 };
 
 
+/**
+ *  Collects the connection statistics of several sessions and returns
+ *  them in a single reply to a pending D-Bus method call.
+ *
+ *  All the backend processes are queried in parallel, each with the same
+ *  timeout.  The reply is sent when all of them have responded or timed
+ *  out, so the total time is bounded by a single timeout regardless of
+ *  the number of sessions.  Sessions without a running backend or where
+ *  the backend did not respond are reported without statistics and with
+ *  a 0 timestamp.
+ *
+ *  Only the D-Bus details of each backend are kept, so sessions may be
+ *  removed while the collection is running.  The collector deletes itself
+ *  once the reply has been sent.
+ */
+class SessionStatisticsCollector
+{
+public:
+    /**
+     * @param invoc  GDBusMethodInvocation to return the result to
+     */
+    SessionStatisticsCollector(GDBusMethodInvocation *invoc)
+        : invoc(invoc)
+    {
+    }
+
+    ~SessionStatisticsCollector()
+    {
+        for (auto& r : results)
+        {
+            if (r.stats)
+            {
+                g_variant_unref(r.stats);
+            }
+        }
+    }
+
+    SessionStatisticsCollector(const SessionStatisticsCollector&) = delete;
+    SessionStatisticsCollector& operator=(const SessionStatisticsCollector&) = delete;
+
+
+    /**
+     *  Adds a session to the result
+     *
+     * @param session_path  std::string with the session object path
+     * @param config_name   std::string with the configuration name
+     * @param device_name   std::string with the tun device name
+     * @param be_conn       GDBusConnection to the backend process, nullptr
+     *                      if the backend is not available
+     * @param be_busname    std::string with the backend bus name
+     * @param be_path       std::string with the backend object path
+     */
+    void Add(const std::string& session_path, const std::string& config_name,
+             const std::string& device_name, GDBusConnection *be_conn,
+             const std::string& be_busname, const std::string& be_path)
+    {
+        Result r;
+        r.session_path = session_path;
+        r.config_name = config_name;
+        r.device_name = device_name;
+        r.be_conn = be_conn;
+        r.be_busname = be_busname;
+        r.be_path = be_path;
+        results.push_back(r);
+    }
+
+
+    /**
+     *  Queries all the backend processes and sends the reply once all
+     *  have responded.  This object must not be used after this call.
+     *
+     * @param timeout_ms  Timeout of each backend query, in milliseconds
+     */
+    void Run(const int timeout_ms)
+    {
+        // Count all queries before starting any of them; the replies
+        // are never dispatched before we return to the main loop
+        for (const auto& r : results)
+        {
+            if (r.be_conn)
+            {
+                ++pending;
+            }
+        }
+        if (0 == pending)
+        {
+            complete();
+            return;
+        }
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& r = results[i];
+            if (!r.be_conn)
+            {
+                continue;
+            }
+            g_dbus_connection_call(r.be_conn,
+                                   r.be_busname.c_str(),
+                                   r.be_path.c_str(),
+                                   "org.freedesktop.DBus.Properties",
+                                   "Get",
+                                   g_variant_new("(ss)",
+                                                 OpenVPN3DBus_interf_backends.c_str(),
+                                                 "statistics"),
+                                   G_VARIANT_TYPE("(v)"),
+                                   G_DBUS_CALL_FLAGS_NONE,
+                                   timeout_ms,
+                                   nullptr,
+                                   statistics_received,
+                                   new Query{this, i});
+        }
+    }
+
+
+private:
+    struct Result
+    {
+        std::string session_path;
+        std::string config_name;
+        std::string device_name;
+        GDBusConnection *be_conn = nullptr;
+        std::string be_busname;
+        std::string be_path;
+        gint64 timestamp = 0;
+        GVariant *stats = nullptr;
+    };
+
+    struct Query
+    {
+        SessionStatisticsCollector *collector;
+        size_t index;
+    };
+
+    GDBusMethodInvocation *invoc = nullptr;
+    std::vector<Result> results;
+    size_t pending = 0;
+
+
+    static void statistics_received(GObject *source, GAsyncResult *res,
+                                    gpointer user_data)
+    {
+        Query *q = static_cast<Query *>(user_data);
+        SessionStatisticsCollector *self = q->collector;
+        Result& result = self->results[q->index];
+        delete q;
+
+        GError *err = nullptr;
+        GVariant *reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+                                                        res, &err);
+        if (reply)
+        {
+            GVariant *stats = nullptr;
+            g_variant_get(reply, "(v)", &stats);
+            if (g_variant_is_of_type(stats, G_VARIANT_TYPE("a{sx}")))
+            {
+                result.stats = stats;
+                result.timestamp = g_get_real_time();
+            }
+            else
+            {
+                g_variant_unref(stats);
+            }
+            g_variant_unref(reply);
+        }
+        else
+        {
+            // The backend did not respond in time or is not running
+            // anymore; report the session without statistics
+            g_error_free(err);
+        }
+
+        if (0 == --self->pending)
+        {
+            self->complete();
+        }
+    }
+
+
+    void complete()
+    {
+        GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("a(ossxa{sx})"));
+        for (const auto& r : results)
+        {
+            GVariant *stats = (r.stats ? r.stats
+                               : g_variant_new_array(G_VARIANT_TYPE("{sx}"),
+                                                     nullptr, 0));
+            g_variant_builder_add(bld, "(ossx@a{sx})",
+                                  r.session_path.c_str(),
+                                  r.config_name.c_str(),
+                                  r.device_name.c_str(),
+                                  r.timestamp,
+                                  stats);
+        }
+        g_dbus_method_invocation_return_value(invoc,
+                                              GLibUtils::wrapInTuple(bld));
+        delete this;
+    }
+};
+
+
 /**
  *   A SessionManagerObject is the main entry point when starting new
  *   VPN tunnels.  It should only exist a single SessionManagerObject during
@@ -1705,6 +2828,9 @@ public:
         std::stringstream introspection_xml;
         introspection_xml << "<node name='" << objpath << "'>"
                           << "    <interface name='" << OpenVPN3DBus_interf_sessions << "'>"
+                          << "        <method name='SetCallBudget'>"
+                          << "          <arg type='u' name='budget_ms' direction='in'/>"
+                          << "        </method>"
                           << "        <method name='NewTunnel'>"
                           << "          <arg type='o' name='config_path' direction='in'/>"
                           << "          <arg type='o' name='session_path' direction='out'/>"
@@ -1715,6 +2841,9 @@ public:
                           << "        <method name='FetchManagedInterfaces'>"
                           << "          <arg type='as' name='devices' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='FetchStatistics'>"
+                          << "          <arg type='a(ossxa{sx})' name='statistics' direction='out'/>"
+                          << "        </method>"
                           << "        <method name='LookupConfigName'>"
                           << "           <arg type='s' name='config_name' direction='in'/>"
                           << "           <arg type='ao' name='session_paths' direction='out'/>"
@@ -1728,6 +2857,7 @@ public:
                           << "           <arg type='u' name='new_owner_uid' direction='in'/>"
                           << "        </method>"
                           << "        <property type='s' name='version' access='read'/>"
+                          << "        <property type='a(sttat)' name='startup_timing_histograms' access='read'/>"
                           << GetLogIntrospection()
                           << "    </interface>"
                           << "</node>";
@@ -1767,6 +2897,18 @@ public:
                               GDBusMethodInvocation *invoc)
     {
         // std::cout << "SessionManagerObject::callback_method_call: " << method_name << std::endl;
+        if ("SetCallBudget" == method_name)
+        {
+            // The budget applies to the next request from this caller
+            guint budget_ms = 0;
+            g_variant_get(params, "(u)", &budget_ms);
+            DBusCallBudgets::Set(sender, budget_ms);
+            g_dbus_method_invocation_return_value(invoc, NULL);
+            return;
+        }
+
+        DBusCallDeadlineScope deadline(sender, OpenVPN3DBus_timeout_sessions
+                                                - OpenVPN3DBus_timeout_margin);
         if ("NewTunnel" == method_name)
         {
             IdleCheck_UpdateTimestamp();
@@ -1787,8 +2929,18 @@ public:
                             {
                                 self->remove_session_object(sesspath);
                             };
+            auto update_cb = [self=Ptr(this), sesspath](void)
+                             {
+                                 self->update_session_index(sesspath);
+                             };
+            auto timings_cb = [self=Ptr(this)](const StartupTimings& timings)
+                              {
+                                  self->startup_histograms.Add(timings);
+                              };
             SessionObject *session = new SessionObject(conn,
                                                        callback,
+                                                       update_cb,
+                                                       timings_cb,
                                                        creds.GetUID(sender),
                                                        sesspath,
                                                        config_path,
@@ -1799,6 +2951,7 @@ public:
             session->IdleCheck_Register(IdleCheck_Get());
             session->RegisterObject(conn);
             session_objects[sesspath] = session;
+            update_session_index(sesspath);
 
             // Return the path to the new session object object to the caller
             // The backend object will remind "hidden" for the end-user
@@ -1813,26 +2966,16 @@ public:
             // session objects
             GVariantBuilder *bld;
             bld = g_variant_builder_new(G_VARIANT_TYPE(ret_iface ? "as" : "ao"));
-            for (auto& item : session_objects)
-            {
-                try {
-                    // We check if the caller is allowed to access this
-                    // session object.  If not, an exception is thrown
-                    // and we will just ignore that exception and continue
-                    item.second->CheckACL(sender);
-                    if (ret_iface)
-                    {
-                        g_variant_builder_add(bld, "s", item.second->GetDeviceName().c_str());
-                    }
-                    else
-                    {
-                        g_variant_builder_add(bld, "o", item.first.c_str());
-                    }
+            for (const auto& path : session_index.AccessibleBy(creds.GetUID(sender)))
+            {
+                if (ret_iface)
+                {
+                    g_variant_builder_add(bld, "s",
+                                          session_index.GetDeviceName(path).c_str());
                 }
-                catch (DBusCredentialsException& excp)
+                else
                 {
-                    // Ignore credentials exceptions.  It means the
-                    // caller does not have access this session object
+                    g_variant_builder_add(bld, "o", path.c_str());
                 }
             }
 
@@ -1847,6 +2990,30 @@ public:
             g_variant_builder_unref(bld);
             g_variant_builder_unref(ret);
         }
+        else if ("FetchStatistics" == method_name)
+        {
+            // The statistics are collected from all the backend processes
+            // in parallel; the reply is sent by the collector
+            uid_t caller = creds.GetUID(sender);
+            SessionStatisticsCollector *collector = new SessionStatisticsCollector(invoc);
+            for (const auto& path : session_index.AccessibleBy(caller))
+            {
+                auto it = session_objects.find(path);
+                if (session_objects.end() == it)
+                {
+                    continue;
+                }
+                std::string be_busname;
+                std::string be_path;
+                GDBusConnection *be_conn = it->second->GetBackendTarget(be_busname,
+                                                                        be_path);
+                collector->Add(path, it->second->GetConfigName(),
+                               it->second->GetDeviceName(),
+                               be_conn, be_busname, be_path);
+            }
+            collector->Run(DBusCallDeadline::Current().Timeout(OpenVPN3DBus_timeout_statistics));
+            return;
+        }
         else if ("LookupConfigName" == method_name)
         {
             gchar *cfgname_c = nullptr;
@@ -1864,27 +3031,12 @@ public:
             g_free(cfgname_c);
 
             // Build up an array of object paths to sessions with a matching
-            // configuration profile name
+            // configuration profile name the caller has access to
             GVariantBuilder *found_paths = g_variant_builder_new(G_VARIANT_TYPE("ao"));
-            for (const auto& item : session_objects)
+            uid_t caller = creds.GetUID(sender);
+            for (const auto& path : session_index.LookupConfigName(cfgname, caller))
             {
-                if (item.second->GetConfigName() == cfgname)
-                {
-                    try
-                    {
-                        // We check if the caller is allowed to access this
-                        // configuration object.  If not, an exception is thrown
-                        // and we will just ignore that exception and continue
-                        item.second->CheckACL(sender);
-                        g_variant_builder_add(found_paths,
-                                              "o", item.first.c_str());
-                    }
-                    catch (DBusCredentialsException& excp)
-                    {
-                        // Ignore credentials exceptions.  It means the
-                        // caller does not have access this configuration object
-                    }
-                }
+                g_variant_builder_add(found_paths, "o", path.c_str());
             }
             g_dbus_method_invocation_return_value(invoc, GLibUtils::wrapInTuple(found_paths));
             return;
@@ -1905,17 +3057,8 @@ public:
             std::string iface(iface_c);
             g_free(iface_c);
 
-            GVariant *ret = nullptr;
-            for (const auto& item : session_objects)
-            {
-                if (item.second->GetDeviceName() == iface)
-                {
-                    ret = g_variant_new("(o)", item.first.c_str());
-                    break;
-                }
-            }
-
-            if (nullptr == ret)
+            std::string path = session_index.LookupDevice(iface);
+            if (path.empty())
             {
                 GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.iface",
                                                               "Interface not found");
@@ -1923,7 +3066,8 @@ public:
                 g_error_free(err);
                 return;
             }
-            g_dbus_method_invocation_return_value(invoc, ret);
+            g_dbus_method_invocation_return_value(invoc,
+                                                  g_variant_new("(o)", path.c_str()));
             return;
         }
         else if ("TransferOwnership" == method_name)
@@ -1951,6 +3095,7 @@ public:
                 {
                     uid_t cur_owner = si.second->GetOwnerUID();
                     si.second->TransferOwnership(new_uid);
+                    update_session_index(si.first);
                     g_dbus_method_invocation_return_value(invoc, NULL);
 
                     std::stringstream msg;
@@ -1995,6 +3140,8 @@ public:
                                      const std::string property_name,
                                      GError **error)
     {
+        DBusCallDeadlineScope deadline(sender, OpenVPN3DBus_timeout_sessions
+                                                - OpenVPN3DBus_timeout_margin);
         IdleCheck_UpdateTimestamp();
         GVariant *ret = nullptr;
 
@@ -2002,6 +3149,10 @@ public:
         {
             ret = g_variant_new_string(package_version);
         }
+        else if ("startup_timing_histograms" == property_name)
+        {
+            ret = startup_histograms.GetGVariant();
+        }
         else
         {
             g_set_error (error,
@@ -2038,6 +3189,8 @@ public:
                                             GVariant *value,
                                             GError **error)
     {
+        // Forget any budget announced for this request
+        (void) DBusCallBudgets::Take(sender);
         THROW_DBUSEXCEPTION("SessionManagerObject", "set property not implemented");
     }
 
@@ -2046,10 +3199,32 @@ private:
     GDBusConnection *dbuscon;
     DBusConnectionCreds creds;
     std::map<std::string, SessionObject *> session_objects;
+    SessionIndex session_index;
+    StartupTimingHistograms startup_histograms;
 
     void remove_session_object(const std::string sesspath)
     {
         session_objects.erase(sesspath);
+        session_index.Remove(sesspath);
+    }
+
+
+    /**
+     *  Refreshes the lookup index information of a session object
+     *
+     * @param sesspath  std::string with the session object path
+     */
+    void update_session_index(const std::string& sesspath)
+    {
+        auto it = session_objects.find(sesspath);
+        if (session_objects.end() == it)
+        {
+            return;
+        }
+        SessionObject *sess = it->second;
+        session_index.Update(sesspath, sess->GetConfigName(),
+                             sess->GetDeviceName(), sess->GetOwnerUID(),
+                             sess->GetAccessList(), sess->GetPublicAccess());
     }
 };
 
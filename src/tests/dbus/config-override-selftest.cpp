@@ -36,12 +36,12 @@ using namespace openvpn;
 
 bool check_override_value(const OverrideValue ov, OverrideType ovt, bool expect)
 {
-    if (false == ov.override.valid())
+    if (false == ov.override->valid())
     {
         return false;
     }
 
-    if (ovt != ov.override.type)
+    if (ovt != ov.override->type)
     {
         return false;
     }
@@ -56,12 +56,12 @@ bool check_override_value(const OverrideValue ov, OverrideType ovt, bool expect)
 
 bool check_override_value(const OverrideValue ov, OverrideType ovt, std::string expect)
 {
-    if (false == ov.override.valid())
+    if (false == ov.override->valid())
     {
         return false;
     }
 
-    if (ovt != ov.override.type)
+    if (ovt != ov.override->type)
     {
         return false;
     }
@@ -346,26 +346,26 @@ int main(int argc, char **argv)
             std::string failmsg = "";
             for (const auto& cov : chkov)
             {
-                if (cov.override.key != cfgoverride.key)
+                if (cov.override->key != cfgoverride.key)
                 {
                     continue;
                 }
 
-                if (cov.override.type != cfgoverride.type)
+                if (cov.override->type != cfgoverride.type)
                 {
                     failmsg = "FAIL - Type mismatch";
                     break;
                 }
-                else if (OverrideType::string == cov.override.type)
+                else if (OverrideType::string == cov.override->type)
                 {
-                    std::string expect = "override:" + cov.override.key;
+                    std::string expect = "override:" + cov.override->key;
                     if (!check_override_value(cov, OverrideType::string, expect))
                     {
                         failmsg = "FAIL - incorrect override string value";
                     }
                     break;
                 }
-                else if (OverrideType::boolean == cov.override.type)
+                else if (OverrideType::boolean == cov.override->type)
                 {
                     if (!check_override_value(cov, OverrideType::boolean, true))
                     {
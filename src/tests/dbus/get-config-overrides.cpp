@@ -50,7 +50,7 @@ int main(int argc, char **argv)
             std::string value;
             std::string type;
 
-            switch (ov.override.type)
+            switch (ov.override->type)
             {
             case OverrideType::boolean:
                     value = (ov.boolValue ? "True" : "False");
@@ -71,7 +71,7 @@ int main(int argc, char **argv)
                     value = "(unknown)";
                     type = "(unknown)";
             }
-            std::cout << ov.override.key << " "
+            std::cout << ov.override->key << " "
                       << "[type: " << type << "]: "
                       << value
                       << std::endl;
@@ -0,0 +1,303 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   configmgr-memory-bench.cpp
+ *
+ * @brief  Measures the resident memory used to keep a number of parsed
+ *         configuration profiles (default 10000) in memory, after each
+ *         of them has been fetched once by a backend client (Fetch) and
+ *         once by a front-end (FetchJSON).  Three layouts are compared:
+ *
+ *         - OptionListJSON: the profiles stored as an OptionListJSON,
+ *           with nothing cached, like the configuration manager did
+ *           before the export caches were added
+ *         - Full caches: CompactOptionList with the inline payloads in
+ *           the InlineBlobStore, plus cached copies of the plain text,
+ *           the Json::Value and the JSON string of each profile
+ *         - ProfileText: CompactOptionList with the inline payloads in
+ *           the InlineBlobStore, caching only the ProfileText of each
+ *           profile, as the configuration manager does now
+ *
+ *         All profiles share the same <ca>, while <cert> and <key> are
+ *         unique per profile.  Each layout is measured in its own child
+ *         process, so memory freed by the other measurements does not
+ *         affect the result.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <openvpn/log/logsimple.hpp>
+
+#include "common/core-extensions.hpp"
+#include "configmgr/blob-store.hpp"
+#include "configmgr/compact-options.hpp"
+#include "configmgr/profile-text.hpp"
+
+using namespace openvpn;
+
+
+static void add_payload(std::stringstream& cfg, const std::string& tag,
+                        const std::string& marker)
+{
+    cfg << "<" << tag << ">" << std::endl
+        << "-----BEGIN DATA-----" << std::endl
+        << marker << std::endl;
+    for (int i = 0; i < 25; i++)
+    {
+        cfg << "MIIDSzCCAjOgAwIBAgIUJ1m8O2Yp0Qr6CjZkPz8Bq2bX6cswDQYJKoZIhvcN"
+            << std::endl;
+    }
+    cfg << "-----END DATA-----" << std::endl
+        << "</" << tag << ">" << std::endl;
+}
+
+
+static std::string generate_profile(const unsigned int id)
+{
+    std::stringstream cfg;
+    cfg << "client" << std::endl
+        << "dev tun" << std::endl
+        << "proto udp" << std::endl
+        << "remote vpn" << id << ".example.org 1194" << std::endl
+        << "remote vpn" << id << "-backup.example.org 443 tcp" << std::endl
+        << "remote-random" << std::endl
+        << "nobind" << std::endl
+        << "remote-cert-tls server" << std::endl
+        << "cipher AES-256-GCM" << std::endl
+        << "verb 3" << std::endl;
+
+    add_payload(cfg, "ca", "shared");
+    add_payload(cfg, "cert", "cert-" + std::to_string(id));
+    add_payload(cfg, "key", "key-" + std::to_string(id));
+    return cfg.str();
+}
+
+
+/**
+ * @return Returns the resident set size of this process, in kB
+ */
+static long rss_kb()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size = 0;
+    long resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+
+/**
+ *  Profile kept as an OptionListJSON; the exports are generated on each
+ *  call and not kept
+ */
+struct PlainProfile
+{
+    PlainProfile(OptionListJSON&& parsed, InlineBlobStore&)
+        : options(std::move(parsed))
+    {
+    }
+
+    void Fetch()
+    {
+        std::string text = options.string_export();
+        std::stringstream json;
+        json << options.json_export();
+    }
+
+    OptionListJSON options;
+};
+
+
+/**
+ *  Moves the large inline payloads into the blob store, like
+ *  ConfigurationObject::store_inline_blobs() does
+ */
+static std::map<size_t, std::string> store_blobs(OptionListJSON& parsed,
+                                                 InlineBlobStore& store)
+{
+    std::map<size_t, std::string> ret;
+    for (size_t i = 0; i < parsed.size(); ++i)
+    {
+        const Option& opt = parsed[i];
+        if (2 != opt.size() || !optparser_inline_file(opt.ref(0))
+            || 256 > opt.ref(1).size())
+        {
+            continue;
+        }
+        std::string optname = opt.ref(0);
+        std::string id = store.Add(opt.ref(1));
+        parsed[i] = Option(optname, id);
+        ret[i] = id;
+    }
+    return ret;
+}
+
+
+static OptionListJSON expand(const CompactOptionList& options,
+                             const std::map<size_t, std::string>& blobs,
+                             InlineBlobStore& store)
+{
+    OptionListJSON ret;
+    options.Expand(ret);
+    for (const auto& b : blobs)
+    {
+        ret[b.first] = Option(options.Name(b.first), store.Get(b.second));
+    }
+    return ret;
+}
+
+
+/**
+ *  CompactOptionList with the text, Json::Value and JSON string exports
+ *  cached after the first use
+ */
+struct FullCacheProfile
+{
+    FullCacheProfile(OptionListJSON&& parsed, InlineBlobStore& store)
+        : blobs(store_blobs(parsed, store)), options(parsed), store(store)
+    {
+    }
+
+    void Fetch()
+    {
+        OptionListJSON opts = expand(options, blobs, store);
+        text = opts.string_export();
+        json = opts.json_export();
+        std::stringstream jsonstr;
+        jsonstr << json;
+        json_str = jsonstr.str();
+    }
+
+    std::map<size_t, std::string> blobs;
+    CompactOptionList options;
+    InlineBlobStore& store;
+    std::string text;
+    Json::Value json;
+    std::string json_str;
+};
+
+
+/**
+ *  CompactOptionList with only the ProfileText cached after the first
+ *  use
+ */
+struct ProfileTextProfile
+{
+    ProfileTextProfile(OptionListJSON&& parsed, InlineBlobStore& store)
+        : blobs(store_blobs(parsed, store)), options(parsed), store(store)
+    {
+    }
+
+    void Fetch()
+    {
+        OptionListJSON opts;
+        options.Expand(opts);
+        text = ProfileText(opts, blobs);
+        std::string rendered = text.Render([this](const std::string& id)
+                                           {
+                                               return store.Get(id);
+                                           });
+        std::stringstream json;
+        json << expand(options, blobs, store).json_export();
+    }
+
+    std::map<size_t, std::string> blobs;
+    CompactOptionList options;
+    InlineBlobStore& store;
+    ProfileText text;
+};
+
+
+/**
+ *  Parses count profiles, keeping them all in memory as Storage objects,
+ *  fetches each of them once and prints the increase of the resident
+ *  set size.
+ */
+template <typename Storage>
+static void measure(const std::string& label, const unsigned int count)
+{
+    OptionList::Limits limits("profile is too large",
+                              ProfileParseLimits::MAX_PROFILE_SIZE,
+                              ProfileParseLimits::OPT_OVERHEAD,
+                              ProfileParseLimits::TERM_OVERHEAD,
+                              ProfileParseLimits::MAX_LINE_SIZE,
+                              ProfileParseLimits::MAX_DIRECTIVE_SIZE);
+
+    InlineBlobStore store;
+    std::vector<std::unique_ptr<Storage>> profiles;
+    profiles.reserve(count);
+    long before = rss_kb();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        OptionListJSON parsed;
+        parsed.parse_from_config(generate_profile(i), &limits);
+        profiles.emplace_back(new Storage(std::move(parsed), store));
+        profiles.back()->Fetch();
+    }
+    long after = rss_kb();
+
+    std::cout << std::setw(20) << std::left << label
+              << (after - before) << " kB for " << count << " profiles ("
+              << ((after - before) * 1024 / count) << " bytes per profile)"
+              << std::endl;
+}
+
+
+/**
+ *  Runs a measurement in a child process
+ */
+static bool run_child(void (*func)(const std::string&, const unsigned int),
+                      const std::string& label, const unsigned int count)
+{
+    pid_t pid = fork();
+    if (0 == pid)
+    {
+        func(label, count);
+        std::cout.flush();
+        _exit(0);
+    }
+    int status = 0;
+    return (0 < pid && pid == waitpid(pid, &status, 0)
+            && WIFEXITED(status) && 0 == WEXITSTATUS(status));
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned int count = 10000;
+    if (argc > 1)
+    {
+        count = std::atoi(argv[1]);
+    }
+
+    bool ok = run_child(measure<PlainProfile>, "OptionListJSON:", count);
+    ok &= run_child(measure<FullCacheProfile>, "Full caches:", count);
+    ok &= run_child(measure<ProfileTextProfile>, "ProfileText:", count);
+    return (ok ? 0 : 1);
+}
@@ -0,0 +1,239 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   configmgr-startup-bench.cpp
+ *
+ * @brief  Measures the time the configuration manager spends loading
+ *         persistent configuration profiles at startup, with and without
+ *         the persistent metadata index used by the --lazy-load mode.
+ *
+ *         The program generates a number of persistent configuration
+ *         files (default 5000) in a temporary directory and runs the
+ *         same file parsing steps as openvpn3-service-configmgr.  The
+ *         D-Bus object registration is not included, as that cost is the
+ *         same in both modes.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+
+#include <openvpn/log/logsimple.hpp>
+
+#include "common/core-extensions.hpp"
+#include "configmgr/persistent-index.hpp"
+
+using namespace openvpn;
+
+typedef std::chrono::steady_clock bench_clock;
+
+
+static std::string generate_profile()
+{
+    std::stringstream cfg;
+    cfg << "client" << std::endl
+        << "dev tun" << std::endl
+        << "proto udp" << std::endl
+        << "remote vpn1.example.org 1194" << std::endl
+        << "remote vpn2.example.org 1194" << std::endl
+        << "remote-random" << std::endl
+        << "nobind" << std::endl
+        << "remote-cert-tls server" << std::endl
+        << "cipher AES-256-GCM" << std::endl
+        << "verb 3" << std::endl;
+
+    for (const auto& tag : {"ca", "cert", "key"})
+    {
+        cfg << "<" << tag << ">" << std::endl
+            << "-----BEGIN DATA-----" << std::endl;
+        for (int i = 0; i < 25; i++)
+        {
+            cfg << "MIIDSzCCAjOgAwIBAgIUJ1m8O2Yp0Qr6CjZkPz8Bq2bX6cswDQYJKoZIhvcN"
+                << std::endl;
+        }
+        cfg << "-----END DATA-----" << std::endl
+            << "</" << tag << ">" << std::endl;
+    }
+    return cfg.str();
+}
+
+
+static OptionList::Limits parse_limits()
+{
+    return OptionList::Limits("profile is too large",
+                              ProfileParseLimits::MAX_PROFILE_SIZE,
+                              ProfileParseLimits::OPT_OVERHEAD,
+                              ProfileParseLimits::TERM_OVERHEAD,
+                              ProfileParseLimits::MAX_LINE_SIZE,
+                              ProfileParseLimits::MAX_DIRECTIVE_SIZE);
+}
+
+
+/**
+ *  Parses a persistent configuration file the same way
+ *  ConfigManagerObject::import_persistent_configuration() and the
+ *  ConfigurationObject constructor does without lazy loading.
+ */
+static Json::Value full_parse(const std::string& fname)
+{
+    std::ifstream statefile(fname, std::ifstream::binary);
+    Json::Value data;
+    statefile >> data;
+    statefile.close();
+
+    OptionList::Limits limits = parse_limits();
+    ProfileMergeJSON pm(data["profile"]);
+    OptionListJSON options;
+    options.parse_from_config(pm.profile_content(), &limits);
+
+    data.removeMember("profile");
+    return data;
+}
+
+
+static double elapsed_ms(const bench_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now()
+                                                     - start).count();
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned int count = 5000;
+    if (argc > 1)
+    {
+        count = std::atoi(argv[1]);
+    }
+
+    char tmpl[] = "/tmp/ovpn3-configmgr-bench-XXXXXX";
+    if (nullptr == mkdtemp(tmpl))
+    {
+        std::cerr << "Could not create temporary directory" << std::endl;
+        return 1;
+    }
+    std::string state_dir(tmpl);
+
+    // Generate the persistent configuration files
+    OptionList::Limits limits = parse_limits();
+    OptionListJSON options;
+    options.parse_from_config(generate_profile(), &limits);
+    Json::Value profile = options.json_export();
+
+    std::vector<std::string> files;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        std::stringstream objpath;
+        objpath << "/net/openvpn/v3/configuration/bench"
+                << std::setw(8) << std::setfill('0') << i;
+
+        Json::Value data;
+        data["object_path"] = objpath.str();
+        data["owner"] = 1000 + (i % 10);
+        data["name"] = "bench-profile-" + std::to_string(i);
+        data["import_timestamp"] = (uint32_t) std::time(nullptr);
+        data["last_used_timestamp"] = 0;
+        data["locked_down"] = false;
+        data["readonly"] = false;
+        data["single_use"] = false;
+        data["used_count"] = 0;
+        data["valid"] = true;
+        data["public_access"] = false;
+        data["acl"].append(2000 + (i % 5));
+        data["profile"] = profile;
+
+        std::string fname = state_dir + "/bench"
+                            + std::to_string(i) + ".json";
+        std::ofstream f(fname);
+        f << data;
+        files.push_back(fname);
+    }
+    std::cout << "Generated " << count << " persistent configuration files in "
+              << state_dir << std::endl;
+
+    // Startup without lazy loading: all files are parsed completely
+    auto start = bench_clock::now();
+    for (const auto& fname : files)
+    {
+        (void) full_parse(fname);
+    }
+    double full_ms = elapsed_ms(start);
+
+    // First startup with lazy loading: no index exists yet, so all files
+    // are parsed and the index is created
+    start = bench_clock::now();
+    {
+        PersistentMetadataIndex idx(state_dir);
+        idx.Load();
+        idx.Prune(files);
+        for (const auto& fname : files)
+        {
+            idx.Update(fname, full_parse(fname));
+        }
+        idx.Save();
+    }
+    double rebuild_ms = elapsed_ms(start);
+
+    // Following startups with lazy loading: only the index is parsed
+    start = bench_clock::now();
+    unsigned int found = 0;
+    {
+        PersistentMetadataIndex idx(state_dir);
+        idx.Load();
+        idx.Prune(files);
+        for (const auto& fname : files)
+        {
+            Json::Value md;
+            if (idx.Lookup(fname, md))
+            {
+                ++found;
+            }
+            else
+            {
+                (void) full_parse(fname);
+            }
+        }
+        idx.Save();
+    }
+    double lazy_ms = elapsed_ms(start);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Full parsing:             " << full_ms << " ms" << std::endl
+              << "Lazy, building the index: " << rebuild_ms << " ms" << std::endl
+              << "Lazy, using the index:    " << lazy_ms << " ms"
+              << " (" << found << " of " << count << " from the index)"
+              << std::endl;
+
+    for (const auto& fname : files)
+    {
+        std::remove(fname.c_str());
+    }
+    std::remove((state_dir + "/metadata-index.json").c_str());
+    rmdir(state_dir.c_str());
+
+    return (count == found ? 0 : 2);
+}
@@ -0,0 +1,140 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   atomic-file.cpp
+ *
+ * @brief  Unit tests for write_file_atomic()
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "common/atomic-file.hpp"
+
+
+namespace unittest
+{
+
+class AtomicFile : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/ovpn3-unittest-XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir = std::string(tmpl);
+        fname = dir + "/test.json";
+    }
+
+    void TearDown() override
+    {
+        std::remove(fname.c_str());
+        rmdir(dir.c_str());
+    }
+
+    std::string read_file()
+    {
+        std::ifstream f(fname);
+        std::stringstream ret;
+        ret << f.rdbuf();
+        return ret.str();
+    }
+
+    int count_files()
+    {
+        int ret = 0;
+        DIR *d = opendir(dir.c_str());
+        while (struct dirent *e = readdir(d))
+        {
+            if ('.' != e->d_name[0])
+            {
+                ++ret;
+            }
+        }
+        closedir(d);
+        return ret;
+    }
+
+    std::string dir;
+    std::string fname;
+};
+
+
+TEST_F(AtomicFile, create_and_replace)
+{
+    write_file_atomic(fname, "first version");
+    EXPECT_EQ(read_file(), "first version");
+
+    write_file_atomic(fname, "second");
+    EXPECT_EQ(read_file(), "second");
+
+    // No temporary files should be left behind
+    EXPECT_EQ(count_files(), 1);
+}
+
+
+TEST_F(AtomicFile, failure)
+{
+    write_file_atomic(fname, "original");
+    EXPECT_THROW(write_file_atomic(dir + "/missing/test.json", "data"),
+                 AtomicFileException);
+    EXPECT_EQ(read_file(), "original");
+    EXPECT_EQ(count_files(), 1);
+}
+
+
+TEST_F(AtomicFile, symlink)
+{
+    std::string target = dir + "/target.json";
+    write_file_atomic(target, "original");
+    ASSERT_EQ(symlink("target.json", fname.c_str()), 0);
+
+    write_file_atomic(fname, "updated");
+    char buf[64] = {};
+    ASSERT_GT(readlink(fname.c_str(), buf, sizeof(buf) - 1), 0);
+    EXPECT_EQ(std::string(buf), "target.json");
+    EXPECT_EQ(read_file(), "updated");
+    EXPECT_EQ(count_files(), 2);
+    std::remove(target.c_str());
+}
+
+
+TEST_F(AtomicFile, remove_stale)
+{
+    write_file_atomic(fname, "data");
+    std::string stale = fname + ".tmp.a1B2c3";
+    std::string other = dir + "/other.tmp.json";
+    std::ofstream(stale) << "partial";
+    std::ofstream(other) << "keep";
+
+    EXPECT_EQ(remove_stale_atomic_files(dir), 1u);
+    EXPECT_EQ(count_files(), 2);
+    EXPECT_EQ(read_file(), "data");
+    std::remove(other.c_str());
+}
+
+} // namespace unittest
@@ -0,0 +1,183 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   blob-store.cpp
+ *
+ * @brief  Unit tests for the InlineBlobStore class
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "configmgr/blob-store.hpp"
+
+
+namespace unittest
+{
+
+class BlobStore : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/ovpn3-unittest-XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir = std::string(tmpl);
+    }
+
+    void TearDown() override
+    {
+        std::string cmd = "rm -rf " + dir;
+        EXPECT_EQ(std::system(cmd.c_str()), 0);
+    }
+
+    bool exists(const std::string& id)
+    {
+        return 0 == access((dir + "/blobs/" + id).c_str(), F_OK);
+    }
+
+    std::string dir;
+};
+
+
+TEST_F(BlobStore, deduplication)
+{
+    InlineBlobStore store;
+    std::string ca(2000, 'c');
+
+    std::string id1 = store.Add(ca);
+    std::string id2 = store.Add(ca);
+    std::string id3 = store.Add(std::string(2000, 'k'));
+    EXPECT_EQ(id1, id2);
+    EXPECT_NE(id1, id3);
+    EXPECT_EQ(store.size(), 2);
+    EXPECT_EQ(store.RefCount(id1), 2);
+    EXPECT_EQ(store.MemoryUsage(), 4000);
+    EXPECT_EQ(store.Get(id1), ca);
+
+    store.Release(id1);
+    EXPECT_EQ(store.Get(id1), ca);
+    store.Release(id1);
+    EXPECT_EQ(store.RefCount(id1), 0);
+    EXPECT_THROW(store.Get(id1), InlineBlobStoreException);
+    EXPECT_EQ(store.size(), 1);
+}
+
+
+TEST_F(BlobStore, persistence)
+{
+    std::string ca(2000, 'c');
+    std::string id;
+    {
+        InlineBlobStore store;
+        store.SetDirectory(dir + "/blobs");
+        id = store.Add(ca);
+        std::string tmp = store.Add("not persisted");
+        store.Persist(id);
+        EXPECT_TRUE(exists(id));
+        EXPECT_FALSE(exists(tmp));
+    }
+
+    // A restarted service references the blob from the metadata
+    // and loads it when needed
+    InlineBlobStore store;
+    store.SetDirectory(dir + "/blobs");
+    {
+        std::ofstream f(dir + "/blobs/stale");
+        f << "unreferenced";
+    }
+    store.Ref(id);
+    EXPECT_EQ(store.Prune(), 1);
+    EXPECT_EQ(store.MemoryUsage(), 0);
+    EXPECT_EQ(store.Get(id), ca);
+    EXPECT_EQ(store.Add(ca), id);
+
+    store.Release(id);
+    EXPECT_TRUE(exists(id));
+    store.Release(id);
+    EXPECT_FALSE(exists(id));
+}
+
+
+TEST_F(BlobStore, invalid_id)
+{
+    InlineBlobStore store;
+    EXPECT_THROW(store.Ref("../configs.log"), InlineBlobStoreException);
+    EXPECT_THROW(store.Persist(store.Add("data")), InlineBlobStoreException);
+}
+
+
+TEST_F(BlobStore, refs_released)
+{
+    InlineBlobStore store;
+    std::string id1 = store.Add(std::string(2000, 'c'));
+    std::string id2 = store.Add(std::string(2000, 'k'));
+    store.Ref(id1);
+    {
+        InlineBlobRefs refs;
+        refs.SetStore(&store);
+        refs[0] = id1;
+        refs[3] = id2;
+    }
+    EXPECT_EQ(store.RefCount(id1), 1);
+    EXPECT_EQ(store.RefCount(id2), 0);
+    EXPECT_EQ(store.size(), 1);
+}
+
+
+TEST_F(BlobStore, refs_moved)
+{
+    InlineBlobStore store;
+    std::string id1 = store.Add(std::string(2000, 'c'));
+    std::string id2 = store.Add(std::string(2000, 'k'));
+
+    InlineBlobRefs owner;
+    {
+        InlineBlobRefs refs;
+        refs.SetStore(&store);
+        refs[0] = id1;
+
+        // Moving hands the references over
+        InlineBlobRefs moved(std::move(refs));
+        EXPECT_TRUE(refs.empty());
+        owner = std::move(moved);
+    }
+    EXPECT_EQ(store.RefCount(id1), 1);
+    EXPECT_EQ(owner.size(), 1);
+
+    // Assigning releases the references held until then
+    InlineBlobRefs other;
+    other.SetStore(&store);
+    other[0] = id2;
+    owner = std::move(other);
+    EXPECT_EQ(store.RefCount(id1), 0);
+    EXPECT_EQ(store.RefCount(id2), 1);
+
+    owner.Release();
+    EXPECT_TRUE(owner.empty());
+    EXPECT_EQ(store.size(), 0);
+}
+
+} // namespace unittest
@@ -0,0 +1,96 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   compact-options.cpp
+ *
+ * @brief  Unit tests for the CompactOptionList class
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "configmgr/compact-options.hpp"
+
+
+namespace unittest
+{
+
+static const std::string profile = "client\n"
+                                   "remote vpn1.example.org 1194 udp\n"
+                                   "remote vpn2.example.org 443 tcp\n"
+                                   "setenv FORWARD_COMPATIBLE 1\n"
+                                   "verb 3\n"
+                                   "<ca>\n-----BEGIN CERTIFICATE-----\n"
+                                   "-----END CERTIFICATE-----\n</ca>\n";
+
+
+TEST(CompactOptions, roundtrip)
+{
+    openvpn::OptionList orig;
+    orig.parse_from_config(profile, nullptr);
+
+    CompactOptionList compact(orig);
+    ASSERT_EQ(compact.size(), orig.size());
+    EXPECT_EQ(compact.Name(1), "remote");
+    EXPECT_EQ(compact.Name(5), "ca");
+    EXPECT_THROW(compact.Name(6), std::out_of_range);
+
+    openvpn::OptionList expanded;
+    compact.Expand(expanded);
+    ASSERT_EQ(expanded.size(), orig.size());
+    for (size_t i = 0; i < orig.size(); ++i)
+    {
+        ASSERT_EQ(expanded[i].size(), orig[i].size());
+        for (size_t a = 0; a < orig[i].size(); ++a)
+        {
+            EXPECT_EQ(expanded[i].ref(a), orig[i].ref(a));
+        }
+    }
+}
+
+
+TEST(CompactOptions, interning)
+{
+    openvpn::OptionList opts;
+    opts.parse_from_config(profile, nullptr);
+
+    CompactOptionList first(opts);
+    size_t names = CompactOptionList::InternedNames();
+    CompactOptionList second(opts);
+    EXPECT_EQ(CompactOptionList::InternedNames(), names);
+    EXPECT_EQ(&first.Name(1), &second.Name(2));
+
+    // Only the arguments are stored per profile
+    EXPECT_LT(first.MemoryUsage(), profile.size() + 16 * sizeof(uint32_t));
+}
+
+
+TEST(CompactOptions, empty)
+{
+    CompactOptionList compact;
+    EXPECT_EQ(compact.size(), 0);
+
+    openvpn::OptionList out;
+    compact.Expand(out);
+    EXPECT_TRUE(out.empty());
+}
+
+} // namespace unittest
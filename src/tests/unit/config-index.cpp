@@ -0,0 +1,190 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   config-index.cpp
+ *
+ * @brief  Unit tests for the ConfigurationIndex class
+ */
+
+#include <gtest/gtest.h>
+
+#include "configmgr/config-index.hpp"
+
+
+namespace unittest
+{
+
+class ConfigIndex : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        idx.Update("/cfg/a", "work", 1000, {}, false);
+        idx.Update("/cfg/b", "work", 1001, {1000}, false);
+        idx.Update("/cfg/c", "home", 1001, {}, true);
+        idx.Update("/cfg/d", "home", 1002, {1003}, false);
+    }
+
+    ConfigurationIndex idx;
+};
+
+
+TEST_F(ConfigIndex, lookup_name)
+{
+    EXPECT_EQ(idx.size(), 4);
+    EXPECT_EQ(idx.LookupName("work"),
+              ConfigurationIndex::PathList({"/cfg/a", "/cfg/b"}));
+    EXPECT_TRUE(idx.LookupName("nonexisting").empty());
+
+    // Only the configurations the user has access to
+    EXPECT_EQ(idx.LookupName("work", 1001),
+              ConfigurationIndex::PathList({"/cfg/b"}));
+    EXPECT_EQ(idx.LookupName("home", 1000),
+              ConfigurationIndex::PathList({"/cfg/c"}));
+    EXPECT_EQ(idx.LookupName("home", 1003),
+              ConfigurationIndex::PathList({"/cfg/c", "/cfg/d"}));
+}
+
+
+TEST_F(ConfigIndex, lookup_name_prefix)
+{
+    idx.Update("/cfg/e", "workshop", 1000, {}, false);
+    idx.Update("/cfg/f", "wor", 1000, {}, false);
+
+    EXPECT_EQ(idx.LookupNamePrefix("work", 1000),
+              ConfigurationIndex::PathList({"/cfg/a", "/cfg/b", "/cfg/e"}));
+    EXPECT_EQ(idx.LookupNamePrefix("h", 1002),
+              ConfigurationIndex::PathList({"/cfg/c", "/cfg/d"}));
+    EXPECT_EQ(idx.LookupNamePrefix("", 1002),
+              ConfigurationIndex::PathList({"/cfg/c", "/cfg/d"}));
+    EXPECT_TRUE(idx.LookupNamePrefix("x", 1000).empty());
+}
+
+
+TEST_F(ConfigIndex, access)
+{
+    EXPECT_EQ(idx.AccessibleBy(1000),
+              ConfigurationIndex::PathList({"/cfg/a", "/cfg/b", "/cfg/c"}));
+    EXPECT_EQ(idx.AccessibleBy(1001),
+              ConfigurationIndex::PathList({"/cfg/b", "/cfg/c"}));
+    EXPECT_EQ(idx.AccessibleBy(4242),
+              ConfigurationIndex::PathList({"/cfg/c"}));
+    EXPECT_EQ(idx.OwnedBy(1001),
+              ConfigurationIndex::PathList({"/cfg/b", "/cfg/c"}));
+
+    EXPECT_TRUE(idx.HasAccess("/cfg/d", 1003));
+    EXPECT_FALSE(idx.HasAccess("/cfg/d", 1000));
+    EXPECT_FALSE(idx.HasAccess("/cfg/nonexisting", 1000));
+}
+
+
+TEST_F(ConfigIndex, update)
+{
+    // Rename and make the profile public
+    idx.Update("/cfg/a", "private", 1000, {}, true);
+    EXPECT_EQ(idx.size(), 4);
+    EXPECT_EQ(idx.LookupName("work"),
+              ConfigurationIndex::PathList({"/cfg/b"}));
+    EXPECT_EQ(idx.LookupName("private"),
+              ConfigurationIndex::PathList({"/cfg/a"}));
+    EXPECT_TRUE(idx.HasAccess("/cfg/a", 4242));
+
+    // Transfer ownership and revoke the granted access
+    idx.Update("/cfg/b", "work", 1002, {}, false);
+    EXPECT_FALSE(idx.HasAccess("/cfg/b", 1000));
+    EXPECT_FALSE(idx.HasAccess("/cfg/b", 1001));
+    EXPECT_EQ(idx.OwnedBy(1002),
+              ConfigurationIndex::PathList({"/cfg/b", "/cfg/d"}));
+}
+
+
+TEST_F(ConfigIndex, remove)
+{
+    idx.Remove("/cfg/c");
+    idx.Remove("/cfg/nonexisting");
+    EXPECT_EQ(idx.size(), 3);
+    EXPECT_FALSE(idx.Exists("/cfg/c"));
+    EXPECT_EQ(idx.LookupName("home"),
+              ConfigurationIndex::PathList({"/cfg/d"}));
+    EXPECT_EQ(idx.AccessibleBy(4242), ConfigurationIndex::PathList());
+    EXPECT_EQ(idx.OwnedBy(1001),
+              ConfigurationIndex::PathList({"/cfg/b"}));
+}
+
+
+TEST_F(ConfigIndex, search)
+{
+    ConfigurationIndex::Attributes attrs;
+    attrs.remote_hosts = {"VPN1.example.org", "vpn2.example.org"};
+    attrs.remote_ports = {"443", "1194"};
+    attrs.remote_protos = {"tcp", "udp"};
+    attrs.remote_endpoints = {"443/tcp", "1194/udp"};
+    attrs.overrides = {{"dns-setup-disabled", "true"}};
+    idx.Update("/cfg/a", "work", 1000, {}, false, attrs);
+
+    attrs.remote_hosts = {"vpn1.example.org"};
+    attrs.remote_ports = {"443"};
+    attrs.remote_protos = {"udp"};
+    attrs.remote_endpoints = {"443/udp"};
+    attrs.overrides = {{"dns-setup-disabled", "false"}};
+    idx.Update("/cfg/b", "work", 1001, {1000}, false, attrs);
+
+    ConfigurationIndex::Query q;
+    q.remote_host = "vpn1.EXAMPLE.org";
+    EXPECT_EQ(idx.Search(q, 1000),
+              ConfigurationIndex::PathList({"/cfg/a", "/cfg/b"}));
+    EXPECT_EQ(idx.Search(q, 1001),
+              ConfigurationIndex::PathList({"/cfg/b"}));
+
+    // Port and protocol must match the same remote entry
+    q.remote_port = "443";
+    q.remote_proto = "tcp";
+    EXPECT_EQ(idx.Search(q, 1000),
+              ConfigurationIndex::PathList({"/cfg/a"}));
+
+    ConfigurationIndex::Query ovq;
+    ovq.override_name = "dns-setup-disabled";
+    EXPECT_EQ(idx.Search(ovq, 1000),
+              ConfigurationIndex::PathList({"/cfg/a", "/cfg/b"}));
+    ovq.override_value_set = true;
+    ovq.override_value = "false";
+    ovq.owner_set = true;
+    ovq.owner = 1001;
+    EXPECT_EQ(idx.Search(ovq, 1000),
+              ConfigurationIndex::PathList({"/cfg/b"}));
+
+    // Without attribute criteria, the name and owner indexes are used
+    ConfigurationIndex::Query nq;
+    nq.name_prefix = "ho";
+    EXPECT_EQ(idx.Search(nq, 1003),
+              ConfigurationIndex::PathList({"/cfg/c", "/cfg/d"}));
+    EXPECT_EQ(idx.Search(ConfigurationIndex::Query(), 4242),
+              ConfigurationIndex::PathList({"/cfg/c"}));
+
+    // Updates replace the indexed attributes
+    idx.Update("/cfg/a", "work", 1000, {}, false);
+    EXPECT_EQ(idx.Search(q, 1000), ConfigurationIndex::PathList());
+    idx.Remove("/cfg/b");
+    ovq.owner_set = false;
+    ovq.override_value_set = false;
+    EXPECT_TRUE(idx.Search(ovq, 1000).empty());
+}
+
+} // namespace unittest
@@ -0,0 +1,184 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   dbus-deadline.cpp
+ *
+ * @brief  Unit tests for DBusCallDeadline, DBusCallBudgets and
+ *         DBusCallDeadlineScope
+ */
+
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "dbus/deadline.hpp"
+
+
+namespace unittest
+{
+
+TEST(DBusCallDeadline, unset)
+{
+    DBusCallDeadline dl;
+    EXPECT_FALSE(dl.IsSet());
+    EXPECT_FALSE(dl.Expired());
+    EXPECT_EQ(dl.Remaining(), -1);
+    EXPECT_EQ(dl.Timeout(-1), -1);
+    EXPECT_EQ(dl.Timeout(500), 500);
+
+    DBusCallDeadline neg(-1);
+    EXPECT_FALSE(neg.IsSet());
+}
+
+
+TEST(DBusCallDeadline, timeout)
+{
+    DBusCallDeadline dl(2000);
+    EXPECT_TRUE(dl.IsSet());
+    EXPECT_FALSE(dl.Expired());
+    EXPECT_LE(dl.Remaining(), 2000);
+    EXPECT_GT(dl.Remaining(), 1000);
+
+    // The shortest of the call timeout and the remaining budget wins
+    EXPECT_EQ(dl.Timeout(100), 100);
+    EXPECT_LE(dl.Timeout(5000), 2000);
+    EXPECT_LE(dl.Timeout(-1), 2000);
+    EXPECT_GT(dl.Timeout(-1), 0);
+}
+
+
+TEST(DBusCallDeadline, expired)
+{
+    DBusCallDeadline dl(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_TRUE(dl.Expired());
+    EXPECT_EQ(dl.Remaining(), 0);
+}
+
+
+TEST(DBusCallDeadline, scope)
+{
+    EXPECT_FALSE(DBusCallDeadline::Current().IsSet());
+    {
+        DBusCallDeadlineScope outer(DBusCallDeadline(1000));
+        EXPECT_TRUE(DBusCallDeadline::Current().IsSet());
+        EXPECT_LE(DBusCallDeadline::Current().Remaining(), 1000);
+        {
+            // A nested scope can not extend the budget ...
+            DBusCallDeadlineScope inner(DBusCallDeadline(60000));
+            EXPECT_LE(DBusCallDeadline::Current().Remaining(), 1000);
+        }
+        {
+            // ... but it may shorten it
+            DBusCallDeadlineScope inner(DBusCallDeadline(100));
+            EXPECT_LE(DBusCallDeadline::Current().Remaining(), 100);
+        }
+        EXPECT_GT(DBusCallDeadline::Current().Remaining(), 100);
+
+        // Other threads are not affected
+        bool other_set = true;
+        std::thread t([&other_set]()
+                      {
+                          other_set = DBusCallDeadline::Current().IsSet();
+                      });
+        t.join();
+        EXPECT_FALSE(other_set);
+    }
+    EXPECT_FALSE(DBusCallDeadline::Current().IsSet());
+}
+
+
+TEST(DBusCallDeadline, earliest)
+{
+    DBusCallDeadline unset;
+    DBusCallDeadline short_dl(100);
+    DBusCallDeadline long_dl(60000);
+
+    EXPECT_FALSE(DBusCallDeadline::Earliest(unset, unset).IsSet());
+    EXPECT_LE(DBusCallDeadline::Earliest(unset, short_dl).Remaining(), 100);
+    EXPECT_LE(DBusCallDeadline::Earliest(short_dl, unset).Remaining(), 100);
+    EXPECT_LE(DBusCallDeadline::Earliest(long_dl, short_dl).Remaining(), 100);
+    EXPECT_LE(DBusCallDeadline::Earliest(short_dl, long_dl).Remaining(), 100);
+}
+
+
+TEST(DBusCallBudgets, set_take)
+{
+    // Nothing announced
+    EXPECT_FALSE(DBusCallBudgets::Take(":1.10").IsSet());
+
+    DBusCallBudgets::Set(":1.10", 1000);
+    DBusCallBudgets::Set(":1.11", 2000);
+
+    DBusCallDeadline dl = DBusCallBudgets::Take(":1.10");
+    EXPECT_TRUE(dl.IsSet());
+    EXPECT_LE(dl.Remaining(), 1000);
+
+    // A budget is only used once
+    EXPECT_FALSE(DBusCallBudgets::Take(":1.10").IsSet());
+
+    dl = DBusCallBudgets::Take(":1.11");
+    EXPECT_TRUE(dl.IsSet());
+    EXPECT_GT(dl.Remaining(), 1000);
+}
+
+
+TEST(DBusCallBudgets, expired)
+{
+    DBusCallBudgets::Set(":1.12", 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_FALSE(DBusCallBudgets::Take(":1.12").IsSet());
+}
+
+
+TEST(DBusCallBudgets, sender_scope)
+{
+    // Without an announced budget, the fixed budget is used
+    {
+        DBusCallDeadlineScope scope(":1.20", 5000);
+        EXPECT_GT(DBusCallDeadline::Current().Remaining(), 1000);
+        EXPECT_LE(DBusCallDeadline::Current().Remaining(), 5000);
+    }
+
+    // A shorter announced budget wins over the fixed budget
+    DBusCallBudgets::Set(":1.20", 100);
+    {
+        DBusCallDeadlineScope scope(":1.20", 5000);
+        EXPECT_LE(DBusCallDeadline::Current().Remaining(), 100);
+    }
+
+    // A longer announced budget can not extend the fixed budget
+    DBusCallBudgets::Set(":1.20", 60000);
+    {
+        DBusCallDeadlineScope scope(":1.20", 5000);
+        EXPECT_LE(DBusCallDeadline::Current().Remaining(), 5000);
+    }
+
+    // Budgets of other callers are not used
+    DBusCallBudgets::Set(":1.21", 100);
+    {
+        DBusCallDeadlineScope scope(":1.20", 5000);
+        EXPECT_GT(DBusCallDeadline::Current().Remaining(), 1000);
+    }
+    EXPECT_TRUE(DBusCallBudgets::Take(":1.21").IsSet());
+    EXPECT_FALSE(DBusCallDeadline::Current().IsSet());
+}
+
+} // namespace unittest
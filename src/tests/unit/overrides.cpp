@@ -0,0 +1,87 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   overrides.cpp
+ *
+ * @brief  Unit tests for the configuration override lookup
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "configmgr/overrides.hpp"
+
+
+namespace unittest
+{
+
+TEST(ConfigOverrides, lookup_all)
+{
+    size_t idx = 0;
+    for (const ValidOverride& vo : configProfileOverrides)
+    {
+        EXPECT_EQ(static_cast<size_t>(vo.id), idx++);
+
+        const ValidOverride& found = GetConfigOverride(vo.key);
+        ASSERT_TRUE(found.valid()) << vo.key;
+        EXPECT_EQ(found.key, vo.key);
+        EXPECT_EQ(found.id, vo.id);
+        EXPECT_EQ(found.type, vo.type);
+
+        // The same descriptor is always returned
+        EXPECT_EQ(&found, &GetConfigOverride(vo.key, true));
+    }
+}
+
+
+TEST(ConfigOverrides, ignore_case)
+{
+    EXPECT_FALSE(GetConfigOverride("Persist-TUN").valid());
+
+    const ValidOverride& vo = GetConfigOverride("Persist-TUN", true);
+    ASSERT_TRUE(vo.valid());
+    EXPECT_EQ(vo.id, OverrideID::persist_tun);
+    EXPECT_EQ(vo.type, OverrideType::boolean);
+}
+
+
+TEST(ConfigOverrides, invalid)
+{
+    EXPECT_FALSE(GetConfigOverride("").valid());
+    EXPECT_FALSE(GetConfigOverride("ipv").valid());
+    EXPECT_FALSE(GetConfigOverride("ipv6-extra", true).valid());
+    EXPECT_FALSE(GetConfigOverride("non-existent-fake-override").valid());
+    EXPECT_EQ(GetConfigOverride("bogus").id, OverrideID::invalid);
+
+    // Key lengths are not limited by the D-Bus callers
+    EXPECT_FALSE(GetConfigOverride(std::string(16 * 1024 * 1024, 'x'), true).valid());
+}
+
+
+TEST(ConfigOverrides, value_refers_descriptor)
+{
+    const ValidOverride& vo = GetConfigOverride("proxy-host");
+    OverrideValue val(vo, std::string("proxy.example.org"));
+    EXPECT_EQ(val.override, &vo);
+    EXPECT_EQ(val.strValue, "proxy.example.org");
+}
+
+} // namespace unittest
@@ -0,0 +1,129 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   persistent-index.cpp
+ *
+ * @brief  Unit tests for the PersistentMetadataIndex class
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "configmgr/persistent-index.hpp"
+
+
+namespace unittest
+{
+
+class PersistentIndex : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/ovpn3-unittest-XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir = std::string(tmpl);
+        cfgfile = dir + "/config.json";
+        write_file(cfgfile, "{}");
+    }
+
+    void TearDown() override
+    {
+        std::remove(cfgfile.c_str());
+        std::remove((dir + "/metadata-index.json").c_str());
+        rmdir(dir.c_str());
+    }
+
+    void write_file(const std::string& fname, const std::string& content)
+    {
+        std::ofstream f(fname);
+        f << content;
+    }
+
+    Json::Value metadata(const std::string& name)
+    {
+        Json::Value ret;
+        ret["object_path"] = "/net/openvpn/v3/configuration/test";
+        ret["name"] = name;
+        return ret;
+    }
+
+    std::string dir;
+    std::string cfgfile;
+};
+
+
+TEST_F(PersistentIndex, save_and_load)
+{
+    PersistentMetadataIndex idx(dir);
+    EXPECT_FALSE(idx.Load());
+    idx.Update(cfgfile, metadata("test-config"));
+    ASSERT_TRUE(idx.Save());
+
+    PersistentMetadataIndex idx2(dir);
+    ASSERT_TRUE(idx2.Load());
+    Json::Value md;
+    ASSERT_TRUE(idx2.Lookup(cfgfile, md));
+    EXPECT_EQ(md["name"].asString(), "test-config");
+    EXPECT_FALSE(idx2.Lookup(dir + "/unknown.json", md));
+}
+
+
+TEST_F(PersistentIndex, modified_file)
+{
+    PersistentMetadataIndex idx(dir);
+    idx.Update(cfgfile, metadata("test-config"));
+
+    // A changed configuration file invalidates the indexed metadata
+    write_file(cfgfile, "{ \"name\": \"changed\" }");
+    Json::Value md;
+    EXPECT_FALSE(idx.Lookup(cfgfile, md));
+
+    idx.Update(cfgfile, metadata("changed"));
+    ASSERT_TRUE(idx.Lookup(cfgfile, md));
+    EXPECT_EQ(md["name"].asString(), "changed");
+}
+
+
+TEST_F(PersistentIndex, prune)
+{
+    PersistentMetadataIndex idx(dir);
+    idx.Update(cfgfile, metadata("test-config"));
+    idx.Prune({});
+    Json::Value md;
+    EXPECT_FALSE(idx.Lookup(cfgfile, md));
+}
+
+
+TEST_F(PersistentIndex, corrupted_index)
+{
+    write_file(dir + "/metadata-index.json", "{ this is not JSON");
+    PersistentMetadataIndex idx(dir);
+    EXPECT_FALSE(idx.Load());
+    Json::Value md;
+    EXPECT_FALSE(idx.Lookup(cfgfile, md));
+}
+
+} // namespace unittest
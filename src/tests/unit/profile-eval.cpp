@@ -0,0 +1,91 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   profile-eval.cpp
+ *
+ * @brief  Unit tests for the ProfileEvaluation class
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "configmgr/profile-eval.hpp"
+
+
+namespace unittest
+{
+
+static ProfileEvaluation evaluate(const std::string& profile)
+{
+    openvpn::OptionList opts;
+    opts.parse_from_config(profile, nullptr);
+    return ProfileEvaluation::Evaluate(opts);
+}
+
+
+TEST(ProfileEval, client_cert)
+{
+    ProfileEvaluation userpass = evaluate("client\n"
+                                          "remote vpn.example.org\n"
+                                          "auth-user-pass\n"
+                                          "<ca>\nCA\n</ca>\n");
+    EXPECT_FALSE(userpass.client_cert);
+
+    ProfileEvaluation certs = evaluate("client\n"
+                                       "remote vpn.example.org\n"
+                                       "<cert>\nCERT\n</cert>\n"
+                                       "<key>\nKEY\n</key>\n");
+    EXPECT_TRUE(certs.client_cert);
+}
+
+
+TEST(ProfileEval, remotes)
+{
+    ProfileEvaluation eval = evaluate("client\n"
+                                      "remote one.example.org\n"
+                                      "remote two.example.org 443 tcp\n"
+                                      "port 1195\n");
+    ASSERT_EQ(eval.remotes.size(), 2);
+    EXPECT_EQ(eval.remotes[0].host, "one.example.org");
+    EXPECT_EQ(eval.remotes[0].port, "1195");
+    EXPECT_EQ(eval.remotes[0].proto, "udp");
+    EXPECT_EQ(eval.remotes[1].port, "443");
+    EXPECT_EQ(eval.remotes[1].proto, "tcp");
+}
+
+
+TEST(ProfileEval, gvariant_roundtrip)
+{
+    ProfileEvaluation eval = evaluate("client\n"
+                                      "remote vpn.example.org 443 tcp\n"
+                                      "<cert>\nCERT\n</cert>\n");
+    GVariant *dict = eval.GetGVariant();
+    g_variant_ref_sink(dict);
+    ProfileEvaluation copy(dict);
+    g_variant_unref(dict);
+
+    EXPECT_TRUE(copy.client_cert);
+    ASSERT_EQ(copy.remotes.size(), 1);
+    EXPECT_EQ(copy.remotes[0].host, "vpn.example.org");
+    EXPECT_EQ(copy.remotes[0].proto, "tcp");
+}
+
+} // namespace unittest
@@ -0,0 +1,104 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   sealed-memfd.cpp
+ *
+ * @brief  Unit tests for sealed_memfd_create(), sealed_memfd_read() and
+ *         sealed_memfd_map()
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "dbus/sealed-memfd.hpp"
+
+
+namespace unittest
+{
+
+TEST(SealedMemfd, roundtrip)
+{
+    std::string data(1024 * 1024, 'x');
+    data += "\nclient\n";
+
+    int fd = sealed_memfd_create("unittest", data);
+    ASSERT_GE(fd, 0);
+
+    // The contents cannot be modified once sealed
+    EXPECT_EQ(write(fd, "y", 1), -1);
+    EXPECT_NE(ftruncate(fd, 0), 0);
+
+    EXPECT_EQ(sealed_memfd_read(fd, data.size()), data);
+    EXPECT_THROW(sealed_memfd_read(fd, data.size() - 1),
+                 SealedMemfdException);
+    close(fd);
+
+    fd = sealed_memfd_create("unittest", "");
+    EXPECT_EQ(sealed_memfd_read(fd, 10), "");
+    close(fd);
+}
+
+
+TEST(SealedMemfd, map)
+{
+    std::string data("remote example.org\0client\n", 26);
+
+    int fd = sealed_memfd_create("unittest", data);
+    ASSERT_GE(fd, 0);
+    size_t size = 0;
+    const char *addr = sealed_memfd_map(fd, data.size(), size);
+    ASSERT_NE(addr, nullptr);
+    EXPECT_EQ(std::string(addr, size), data);
+    munmap(const_cast<char *>(addr), size);
+    EXPECT_THROW(sealed_memfd_map(fd, data.size() - 1, size),
+                 SealedMemfdException);
+    close(fd);
+
+    fd = sealed_memfd_create("unittest", "");
+    EXPECT_EQ(sealed_memfd_map(fd, 10, size), nullptr);
+    EXPECT_EQ(size, 0u);
+    close(fd);
+
+    fd = memfd_create("unittest", MFD_CLOEXEC);
+    ASSERT_EQ(write(fd, "data", 4), 4);
+    EXPECT_THROW(sealed_memfd_map(fd, 100, size), SealedMemfdException);
+    close(fd);
+}
+
+
+TEST(SealedMemfd, reject_unsealed)
+{
+    int fd = memfd_create("unittest", MFD_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, "data", 4), 4);
+    EXPECT_THROW(sealed_memfd_read(fd, 100), SealedMemfdException);
+    close(fd);
+
+    int pipefd[2];
+    ASSERT_EQ(pipe(pipefd), 0);
+    EXPECT_THROW(sealed_memfd_read(pipefd[0], 100), SealedMemfdException);
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+} // namespace unittest
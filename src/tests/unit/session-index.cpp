@@ -0,0 +1,104 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   session-index.cpp
+ *
+ * @brief  Unit tests for the SessionIndex class
+ */
+
+#include <gtest/gtest.h>
+
+#include "sessionmgr/session-index.hpp"
+
+
+namespace unittest
+{
+
+class SessIndex : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        idx.Update("/sess/a", "work", "tun0", 1000, {}, false);
+        idx.Update("/sess/b", "work", "tun1", 1001, {1000}, false);
+        idx.Update("/sess/c", "home", "", 1001, {}, true);
+        idx.Update("/sess/d", "home", "tun2", 1002, {1003}, false);
+    }
+
+    SessionIndex idx;
+};
+
+
+TEST_F(SessIndex, lookup_config_name)
+{
+    EXPECT_EQ(idx.size(), 4);
+    EXPECT_EQ(idx.LookupConfigName("work", 1000),
+              SessionIndex::PathList({"/sess/a", "/sess/b"}));
+    EXPECT_EQ(idx.LookupConfigName("work", 1001),
+              SessionIndex::PathList({"/sess/b"}));
+    EXPECT_EQ(idx.LookupConfigName("home", 1003),
+              SessionIndex::PathList({"/sess/c", "/sess/d"}));
+    EXPECT_TRUE(idx.LookupConfigName("nonexisting", 1000).empty());
+}
+
+
+TEST_F(SessIndex, lookup_device)
+{
+    EXPECT_EQ(idx.LookupDevice("tun1"), "/sess/b");
+    EXPECT_EQ(idx.LookupDevice("tun9"), "");
+    EXPECT_EQ(idx.LookupDevice(""), "");
+    EXPECT_EQ(idx.GetDeviceName("/sess/d"), "tun2");
+
+    // Device torn down and created again with a different name
+    idx.Update("/sess/b", "work", "", 1001, {1000}, false);
+    EXPECT_EQ(idx.LookupDevice("tun1"), "");
+    idx.Update("/sess/b", "work", "tun3", 1001, {1000}, false);
+    EXPECT_EQ(idx.LookupDevice("tun3"), "/sess/b");
+
+    // A device name reused by a new session is not lost when the
+    // old session is removed afterwards
+    idx.Update("/sess/e", "work", "tun0", 1000, {}, false);
+    idx.Remove("/sess/a");
+    EXPECT_EQ(idx.LookupDevice("tun0"), "/sess/e");
+}
+
+
+TEST_F(SessIndex, access)
+{
+    EXPECT_EQ(idx.AccessibleBy(1000),
+              SessionIndex::PathList({"/sess/a", "/sess/b", "/sess/c"}));
+    EXPECT_EQ(idx.AccessibleBy(1003),
+              SessionIndex::PathList({"/sess/c", "/sess/d"}));
+    EXPECT_EQ(idx.AccessibleBy(2000),
+              SessionIndex::PathList({"/sess/c"}));
+
+    // Ownership transfer
+    idx.Update("/sess/a", "work", "tun0", 2000, {}, false);
+    EXPECT_FALSE(idx.HasAccess("/sess/a", 1000));
+    EXPECT_TRUE(idx.HasAccess("/sess/a", 2000));
+
+    idx.Remove("/sess/c");
+    EXPECT_FALSE(idx.Exists("/sess/c"));
+    EXPECT_EQ(idx.AccessibleBy(2000),
+              SessionIndex::PathList({"/sess/a"}));
+    EXPECT_EQ(idx.size(), 3);
+}
+
+} // namespace unittest
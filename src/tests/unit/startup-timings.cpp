@@ -0,0 +1,110 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+/**
+ * @file   startup-timings.cpp
+ *
+ * @brief  Unit tests for the StartupTimings and StartupTimingHistograms
+ *         classes
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "common/startup-timings.hpp"
+
+
+namespace unittest
+{
+
+TEST(StartupTimings, first_occurrence)
+{
+    StartupTimings t;
+    t.End(StartupPhase::TLS_HANDSHAKE, 50);
+    EXPECT_TRUE(t.GetPhases().empty());
+
+    t.Begin(StartupPhase::TLS_HANDSHAKE, 100);
+    t.End(StartupPhase::TLS_HANDSHAKE, 400);
+
+    // A reconnect does not change the recorded startup timings
+    t.Begin(StartupPhase::TLS_HANDSHAKE, 1000);
+    t.End(StartupPhase::TLS_HANDSHAKE, 2000);
+
+    t.Begin(StartupPhase::NEW_TUNNEL, 10);
+    auto phases = t.GetPhases();
+    ASSERT_EQ(phases.size(), 2);
+    EXPECT_EQ(phases[0].phase, StartupPhase::NEW_TUNNEL);
+    EXPECT_EQ(phases[0].Duration(), -1);
+    EXPECT_EQ(phases[1].phase, StartupPhase::TLS_HANDSHAKE);
+    EXPECT_EQ(phases[1].begin, 100);
+    EXPECT_EQ(phases[1].Duration(), 300);
+}
+
+
+TEST(StartupTimings, merge)
+{
+    StartupTimings session;
+    session.Begin(StartupPhase::NEW_TUNNEL, 10);
+    session.End(StartupPhase::NEW_TUNNEL, 20);
+
+    StartupTimings backend;
+    backend.Set(StartupPhase::NEW_TUNNEL, 1, 2);
+    backend.Begin(StartupPhase::CONFIG_FETCH, 30);
+    backend.End(StartupPhase::CONFIG_FETCH, 45);
+    backend.Set(StartupPhase::DNS_COMMIT, 60, 70);
+
+    session.Merge(backend);
+    auto phases = session.GetPhases();
+    ASSERT_EQ(phases.size(), 3);
+    EXPECT_EQ(phases[0].begin, 10);
+    EXPECT_EQ(phases[1].phase, StartupPhase::CONFIG_FETCH);
+    EXPECT_EQ(phases[1].Duration(), 15);
+    EXPECT_EQ(phases[2].phase, StartupPhase::DNS_COMMIT);
+    EXPECT_STREQ(StartupTimings::PhaseName(phases[2].phase), "dns_commit");
+}
+
+
+TEST(StartupTimingHistograms, buckets)
+{
+    EXPECT_EQ(StartupTimingHistograms::BucketLimit(0), 1000);
+    EXPECT_EQ(StartupTimingHistograms::BucketLimit(3), 8000);
+    EXPECT_EQ(StartupTimingHistograms::BucketLimit(StartupTimingHistograms::BUCKETS - 1), -1);
+
+    StartupTimingHistograms hist;
+    for (int64_t duration : std::vector<int64_t>{500, 999, 1000, 5000, 3600000000})
+    {
+        StartupTimings t;
+        t.Begin(StartupPhase::TLS_HANDSHAKE, 1);
+        t.End(StartupPhase::TLS_HANDSHAKE, 1 + duration);
+        t.Begin(StartupPhase::CREDENTIAL_QUEUE, 1);
+        hist.Add(t);
+    }
+
+    EXPECT_EQ(hist.Count(StartupPhase::TLS_HANDSHAKE), 5);
+    EXPECT_EQ(hist.Count(StartupPhase::CREDENTIAL_QUEUE), 0);
+    EXPECT_EQ(hist.BucketCount(StartupPhase::TLS_HANDSHAKE, 0), 2);
+    EXPECT_EQ(hist.BucketCount(StartupPhase::TLS_HANDSHAKE, 1), 1);
+    EXPECT_EQ(hist.BucketCount(StartupPhase::TLS_HANDSHAKE, 3), 1);
+    EXPECT_EQ(hist.BucketCount(StartupPhase::TLS_HANDSHAKE,
+                               StartupTimingHistograms::BUCKETS - 1), 1);
+}
+
+} // namespace unittest
@@ -0,0 +1,227 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   state-log.cpp
+ *
+ * @brief  Unit tests for the ConfigStateLog class
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "configmgr/state-log.hpp"
+
+
+namespace unittest
+{
+
+class StateLog : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/ovpn3-unittest-XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir = std::string(tmpl);
+    }
+
+    void TearDown() override
+    {
+        std::remove((dir + "/configs.log").c_str());
+        rmdir(dir.c_str());
+    }
+
+    Json::Value metadata(const std::string& name)
+    {
+        Json::Value ret;
+        ret["name"] = name;
+        return ret;
+    }
+
+    Json::Value profile(const std::string& remote)
+    {
+        Json::Value ret;
+        ret["remote"] = remote;
+        return ret;
+    }
+
+    off_t file_size()
+    {
+        struct stat st;
+        stat((dir + "/configs.log").c_str(), &st);
+        return st.st_size;
+    }
+
+    std::string dir;
+};
+
+
+TEST_F(StateLog, put_delete_reload)
+{
+    {
+        ConfigStateLog log(dir);
+        EXPECT_TRUE(log.Load().empty());
+        log.Put("/cfg/a", metadata("a"), profile("a.example.org"));
+        log.Put("/cfg/b", metadata("b"), profile("b.example.org"));
+        log.Put("/cfg/a", metadata("a2"), profile("a2.example.org"));
+        log.Delete("/cfg/b");
+        log.Delete("/cfg/unknown");
+        EXPECT_EQ(log.size(), 1);
+        EXPECT_EQ(log.ReadProfile("/cfg/a")["remote"].asString(),
+                  "a2.example.org");
+    }
+
+    ConfigStateLog log(dir);
+    ConfigStateLog::MetadataMap md = log.Load();
+    ASSERT_EQ(md.size(), 1);
+    EXPECT_EQ(md["/cfg/a"]["name"].asString(), "a2");
+    EXPECT_FALSE(log.Exists("/cfg/b"));
+    EXPECT_EQ(log.GarbageRecords(), 3);
+    EXPECT_EQ(log.ReadProfile("/cfg/a")["remote"].asString(),
+              "a2.example.org");
+    EXPECT_THROW(log.ReadProfile("/cfg/b"), ConfigStateLogException);
+}
+
+
+TEST_F(StateLog, torn_record)
+{
+    {
+        ConfigStateLog log(dir);
+        log.Load();
+        log.Put("/cfg/a", metadata("a"), profile("a.example.org"));
+    }
+    off_t good_size = file_size();
+
+    // Simulate a crash in the middle of appending a record
+    {
+        std::ofstream f(dir + "/configs.log", std::ios::app);
+        f << "P /cfg/b 100 100\n{\"name\":";
+    }
+
+    ConfigStateLog log(dir);
+    ConfigStateLog::MetadataMap md = log.Load();
+    EXPECT_EQ(md.size(), 1);
+    EXPECT_GT(log.DiscardedBytes(), 0);
+    EXPECT_EQ(file_size(), good_size);
+
+    // New records must be readable after the truncation
+    log.Put("/cfg/c", metadata("c"), profile("c.example.org"));
+    ConfigStateLog log2(dir);
+    EXPECT_EQ(log2.Load().size(), 2);
+}
+
+
+TEST_F(StateLog, corrupt_record)
+{
+    {
+        ConfigStateLog log(dir);
+        log.Load();
+        log.Put("/cfg/a", metadata("a"), profile("a.example.org"));
+    }
+
+    // A complete record with damaged metadata in the middle of the log
+    {
+        std::ofstream f(dir + "/configs.log", std::ios::app);
+        f << "P /cfg/b 6 2\n{\"nam!{}\n";
+    }
+    {
+        ConfigStateLog log(dir);
+        log.Load();
+        log.Put("/cfg/c", metadata("c"), profile("c.example.org"));
+    }
+    off_t size = file_size();
+
+    ConfigStateLog log(dir);
+    ConfigStateLog::MetadataMap md = log.Load();
+    EXPECT_EQ(md.size(), 2);
+    EXPECT_EQ(md["/cfg/c"]["name"].asString(), "c");
+    EXPECT_EQ(log.ReadProfile("/cfg/c")["remote"].asString(), "c.example.org");
+    EXPECT_FALSE(log.Exists("/cfg/b"));
+    EXPECT_EQ(log.SkippedRecords(), 1);
+    EXPECT_EQ(log.DiscardedBytes(), 0);
+    EXPECT_EQ(file_size(), size);
+}
+
+
+TEST_F(StateLog, corrupt_framing)
+{
+    {
+        ConfigStateLog log(dir);
+        log.Load();
+        log.Put("/cfg/a", metadata("a"), profile("a.example.org"));
+    }
+
+    // The declared lengths do not match the record, which is followed
+    // by a valid record
+    {
+        std::ofstream f(dir + "/configs.log", std::ios::app);
+        f << "P /cfg/b 1 1\n{}{}\n";
+        f << "P /cfg/c 2 2\n{}{}\n";
+    }
+    off_t size = file_size();
+
+    // Nothing after the damaged record may be removed
+    ConfigStateLog log(dir);
+    EXPECT_THROW(log.Load(), ConfigStateLogException);
+    EXPECT_EQ(file_size(), size);
+}
+
+
+TEST_F(StateLog, compaction)
+{
+    ConfigStateLog log(dir);
+    log.Load();
+    log.Put("/cfg/a", metadata("a"), profile("a.example.org"));
+    for (int i = 0; i < 200; ++i)
+    {
+        log.Put("/cfg/b", metadata("b" + std::to_string(i)),
+                profile("b.example.org"));
+    }
+
+    // Compaction happens automatically once there is enough garbage
+    EXPECT_LT(log.GarbageRecords(), 100);
+    log.Compact();
+    EXPECT_EQ(log.GarbageRecords(), 0);
+    EXPECT_EQ(log.ReadProfile("/cfg/a")["remote"].asString(),
+              "a.example.org");
+
+    ConfigStateLog log2(dir);
+    ConfigStateLog::MetadataMap md = log2.Load();
+    ASSERT_EQ(md.size(), 2);
+    EXPECT_EQ(md["/cfg/b"]["name"].asString(), "b199");
+    EXPECT_EQ(log2.GarbageRecords(), 0);
+}
+
+
+TEST_F(StateLog, invalid_path)
+{
+    ConfigStateLog log(dir);
+    log.Load();
+    EXPECT_THROW(log.Put("/cfg/with space", metadata("x"), profile("x")),
+                 ConfigStateLogException);
+}
+
+} // namespace unittest
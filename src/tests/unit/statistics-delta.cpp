@@ -0,0 +1,132 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-delta.cpp
+ *
+ * @brief  Unit tests for the delta encoding of connection statistics
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "client/statistics-delta.hpp"
+
+
+namespace unittest
+{
+
+static const std::vector<std::string> keys = {"BYTES_IN", "BYTES_OUT",
+                                              "PACKETS_IN", "PACKETS_OUT"};
+
+
+TEST(StatisticsDelta, encode_decode)
+{
+    StatisticsDeltaEncoder enc;
+    StatisticsDeltaDecoder dec;
+    StatisticsFrame frame;
+
+    ASSERT_TRUE(enc.Encode(keys, {100, 0, 2, 0}, 1000, frame));
+    EXPECT_TRUE(frame.IsKeyFrame());
+    EXPECT_EQ(frame.deltas.size(), 2);
+    ASSERT_TRUE(dec.Apply(frame));
+
+    ASSERT_TRUE(enc.Encode(keys, {150, 20, 2, 1}, 2000, frame));
+    EXPECT_FALSE(frame.IsKeyFrame());
+    ASSERT_EQ(frame.deltas.size(), 3);
+    EXPECT_EQ(frame.deltas[0], StatisticsFrame::Delta(0, 50));
+    ASSERT_TRUE(dec.Apply(frame));
+
+    // Nothing changed, nothing to send
+    EXPECT_FALSE(enc.Encode(keys, {150, 20, 2, 1}, 3000, frame));
+
+    EXPECT_EQ(dec.GetTimestamp(), 2000);
+    ConnectionStats stats = dec.GetStats();
+    ASSERT_EQ(stats.size(), 4);
+    EXPECT_EQ(stats[0].key, "BYTES_IN");
+    EXPECT_EQ(stats[0].value, 150);
+    EXPECT_EQ(stats[3].value, 1);
+}
+
+
+TEST(StatisticsDelta, lost_frame)
+{
+    StatisticsDeltaEncoder enc;
+    StatisticsDeltaDecoder dec;
+    StatisticsFrame frame;
+
+    ASSERT_TRUE(enc.Encode(keys, {1, 1, 1, 1}, 1000, frame));
+    ASSERT_TRUE(dec.Apply(frame));
+    ASSERT_TRUE(enc.Encode(keys, {2, 1, 1, 1}, 2000, frame));
+    // ... this frame is lost
+    ASSERT_TRUE(enc.Encode(keys, {3, 1, 1, 1}, 3000, frame));
+    EXPECT_FALSE(dec.Apply(frame));
+    EXPECT_FALSE(dec.Synchronized());
+
+    // A new receiver resets the encoder, which results in a key frame
+    enc.Reset();
+    ASSERT_TRUE(enc.Encode(keys, {4, 1, 1, 1}, 4000, frame));
+    EXPECT_TRUE(frame.IsKeyFrame());
+    ASSERT_TRUE(dec.Apply(frame));
+    EXPECT_TRUE(dec.Synchronized());
+    EXPECT_EQ(dec.GetStats()[0].value, 4);
+}
+
+
+TEST(StatisticsDelta, keyframe_interval)
+{
+    StatisticsDeltaEncoder enc(3);
+    StatisticsFrame frame;
+
+    std::vector<bool> keyframes;
+    for (long long i = 1; i <= 7; ++i)
+    {
+        ASSERT_TRUE(enc.Encode(keys, {i, 0, 0, 0}, i, frame));
+        keyframes.push_back(frame.IsKeyFrame());
+        EXPECT_EQ(frame.sequence, i - 1);
+    }
+    EXPECT_EQ(keyframes, std::vector<bool>({true, false, false,
+                                            true, false, false, true}));
+
+    // A changed set of counters always results in a key frame
+    ASSERT_TRUE(enc.Encode({"BYTES_IN"}, {8}, 8, frame));
+    EXPECT_TRUE(frame.IsKeyFrame());
+}
+
+
+TEST(StatisticsDelta, gvariant)
+{
+    StatisticsDeltaEncoder enc;
+    StatisticsFrame frame;
+    ASSERT_TRUE(enc.Encode(keys, {100, 0, -5, 0}, 1234567, frame));
+
+    GVariant *v = frame.GetGVariant();
+    g_variant_ref_sink(v);
+    StatisticsFrame restored(v);
+    g_variant_unref(v);
+
+    EXPECT_EQ(restored.timestamp, 1234567);
+    EXPECT_EQ(restored.sequence, frame.sequence);
+    EXPECT_EQ(restored.keys, keys);
+    EXPECT_EQ(restored.deltas, frame.deltas);
+}
+
+} // namespace unittest
@@ -0,0 +1,119 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-history.cpp
+ *
+ * @brief  Unit tests for the StatisticsHistory class
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "client/statistics-history.hpp"
+
+
+namespace unittest
+{
+
+static const std::vector<std::string> names = {
+    "BYTES_IN", "BYTES_OUT", "PACKETS_IN", "PACKETS_OUT",
+    "TUN_BYTES_IN", "TUN_BYTES_OUT", "TUN_PACKETS_IN", "TUN_PACKETS_OUT",
+    "N_RECONNECT", "NETWORK_RECV_ERROR", "DECRYPT_ERROR"
+};
+
+static std::vector<long long> sample(long long bytes, long long errors)
+{
+    return {bytes, bytes / 2, bytes / 100, bytes / 200,
+            0, 0, 0, 0, 3, errors, errors};
+}
+
+
+TEST(StatisticsHistory, rates)
+{
+    StatisticsHistory hist;
+
+    // 1000 bytes/s for 71 seconds, then 5000 bytes/s for 4 seconds
+    long long bytes = 0;
+    int64_t ts = 0;
+    for (int i = 0; i <= 70; ++i)
+    {
+        hist.Add(names, sample(bytes, 0), ts);
+        bytes += 1000;
+        ts += 1000000;
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        hist.Add(names, sample(bytes, 1), ts);
+        bytes += 5000;
+        ts += 1000000;
+    }
+
+    std::vector<StatisticsRate> rates = hist.GetRates();
+    ASSERT_EQ(rates.size(), StatisticsHistory::TRACKED);
+    EXPECT_EQ(rates[0].key, "BYTES_IN");
+    EXPECT_DOUBLE_EQ(rates[0].rate_1s, 5000);
+    EXPECT_DOUBLE_EQ(rates[0].rate_10s, (6 * 1000 + 4 * 5000) / 10.0);
+    EXPECT_DOUBLE_EQ(rates[0].rate_60s, (56 * 1000 + 4 * 5000) / 60.0);
+    EXPECT_DOUBLE_EQ(rates[1].rate_1s, 2500);
+    EXPECT_EQ(rates[8].key, "ERRORS");
+    EXPECT_DOUBLE_EQ(rates[8].rate_10s, 2 / 10.0);
+}
+
+
+TEST(StatisticsHistory, ring)
+{
+    StatisticsHistory hist(8);
+    EXPECT_EQ(hist.GetRates()[0].rate_1s, 0);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        hist.Add(names, sample(i * 100, i), i * 1000000);
+    }
+    EXPECT_EQ(hist.size(), 8);
+
+    StatisticsHistoryReport report = hist.GetReport(3);
+    ASSERT_EQ(report.samples.size(), 3);
+    EXPECT_EQ(report.keys, StatisticsHistory::TrackedKeys());
+    EXPECT_EQ(report.samples[0].timestamp, 17000000);
+    EXPECT_EQ(report.samples[2].timestamp, 19000000);
+    EXPECT_EQ(report.samples[2].values[0], 1900);
+    EXPECT_EQ(report.samples[2].values[8], 38);
+
+    // The 60 second window is limited by the history size
+    EXPECT_DOUBLE_EQ(report.rates[0].rate_60s, 100);
+}
+
+
+TEST(StatisticsHistory, counter_reset)
+{
+    StatisticsHistory hist;
+    hist.Add(names, sample(5000, 0), 0);
+    hist.Add(names, sample(6000, 0), 1000000);
+    EXPECT_EQ(hist.size(), 2);
+
+    // A new connection starts counting from 0 again
+    hist.Add(names, sample(100, 0), 2000000);
+    EXPECT_EQ(hist.size(), 1);
+    EXPECT_EQ(hist.GetRates()[0].rate_1s, 0);
+}
+
+} // namespace unittest
@@ -0,0 +1,108 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2020         OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C) 2020         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   statistics-segment.cpp
+ *
+ * @brief  Unit tests for the StatisticsSegmentWriter and
+ *         StatisticsSegmentReader classes
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "client/statistics-segment.hpp"
+
+
+namespace unittest
+{
+
+static const std::vector<std::string> names = {
+    "BYTES_IN", "BYTES_OUT", "A_VERY_LONG_COUNTER_NAME_WHICH_IS_TRUNCATED"
+};
+
+
+TEST(StatisticsSegment, read_updates)
+{
+    StatisticsSegmentWriter writer(names);
+    int fd = writer.GetReaderFD();
+    ASSERT_GE(fd, 0);
+    StatisticsSegmentReader reader(fd);
+    close(fd);
+
+    ASSERT_EQ(reader.GetNames().size(), 3);
+    EXPECT_EQ(reader.GetNames()[0], "BYTES_IN");
+    EXPECT_EQ(reader.GetNames()[2].size(), 31);
+
+    StatisticsSegmentSnapshot snap = reader.Read();
+    EXPECT_EQ(snap.timestamp, 0);
+    EXPECT_EQ(snap.values, std::vector<long long>({0, 0, 0}));
+
+    writer.Update({100, 200, 300, 400}, 1000000);
+    writer.Update({150, 250}, 2000000);
+    snap = reader.Read();
+    EXPECT_EQ(snap.sequence, 2);
+    EXPECT_EQ(snap.timestamp, 2000000);
+    EXPECT_EQ(snap.values, std::vector<long long>({150, 250, 300}));
+}
+
+
+TEST(StatisticsSegment, readonly)
+{
+    StatisticsSegmentWriter writer(names);
+    int fd = writer.GetReaderFD();
+    ASSERT_GE(fd, 0);
+
+    // Readers can neither modify nor resize the segment
+    EXPECT_EQ(write(fd, "x", 1), -1);
+    EXPECT_NE(ftruncate(fd, 0), 0);
+    EXPECT_EQ(mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0),
+              MAP_FAILED);
+
+    // Opening the memfd again with write access does not help either
+    std::string path = "/proc/self/fd/" + std::to_string(fd);
+    int rwfd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    ASSERT_GE(rwfd, 0);
+    EXPECT_EQ(write(rwfd, "x", 1), -1);
+    EXPECT_EQ(mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, rwfd, 0),
+              MAP_FAILED);
+    close(rwfd);
+    close(fd);
+}
+
+
+TEST(StatisticsSegment, reject_invalid)
+{
+    int fd = memfd_create("unittest", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, 4096), 0);
+    EXPECT_THROW(StatisticsSegmentReader r(fd), StatisticsSegmentException);
+
+    // Sealed, but without a valid header
+    ASSERT_EQ(fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW), 0);
+    EXPECT_THROW(StatisticsSegmentReader r(fd), StatisticsSegmentException);
+    close(fd);
+}
+
+} // namespace unittest